@@ -0,0 +1,97 @@
+/**
+ * @file arena_bench.cpp
+ *
+ * @description
+ * This program load tests the arena with many snakes on a generated open
+ * maze with scattered obstacles. The snakes take turns between the random,
+ * greedy and search planners. The same run is repeated with 1, 2, 4, ...
+ * threads choosing the moves; each must end on the same board with the
+ * same scores as the single-threaded one.
+ *
+ * Usage: snaze_arena_bench [size] [snakes] [ticks] [max_threads] [seed]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "arena.h"
+#include "common.h"
+#include "layout.h"
+#include "maze_gen.h"
+
+using clock_type = std::chrono::steady_clock;
+
+/**
+ * @brief Folds the board, the scores and the deaths into a checksum.
+ *
+ * @param arena The arena to summarize.
+ * @return An FNV-1a hash of everything a run decides.
+ */
+uint64_t checksum(const snaze::Arena &arena)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&](uint64_t value) { hash = (hash ^ value) * 0x100000001b3ULL; };
+
+    for (snaze::cell_t id = 0; id < arena.rows() * arena.cols(); ++id)
+        mix(static_cast<uint64_t>(arena.cell(id)));
+    for (size_t i = 0; i < arena.size(); ++i) {
+        mix(arena.score(i));
+        mix(arena.deaths(i));
+        mix(arena.snake(i).hash());
+    }
+
+    return hash;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512;
+    size_t snakes = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+    size_t ticks = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000;
+    size_t max_threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 8;
+    unsigned seed = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 42;
+
+    auto layout = std::make_shared<const snaze::Layout>(snaze::generate_maze(snaze::maze_style_e::ARENA, size, size, seed, 0.1));
+
+    std::cout << "arena " << size << "x" << size << ", " << snakes << " snakes, "
+              << ticks << " ticks, seed " << seed << "\n";
+    std::cout << "  threads   ticks/s   moves/s      foods   deaths   match\n";
+
+    uint64_t reference = 0;
+    size_t failures = 0;
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        snaze::Arena arena(layout, snakes, snakes, seed);
+        arena.parallelize(threads);
+        for (size_t i = 0; i < snakes; ++i)
+            arena.policy(i, static_cast<snaze::Arena::policy_e>(i % 3));
+
+        auto t0 = clock_type::now();
+        for (size_t t = 0; t < ticks; ++t)
+            arena.tick();
+        double seconds = std::chrono::duration<double>(clock_type::now() - t0).count();
+
+        uint64_t foods = 0, deaths = 0;
+        for (size_t i = 0; i < snakes; ++i) {
+            foods += arena.score(i) / 20;
+            deaths += arena.deaths(i);
+        }
+
+        uint64_t sum = checksum(arena);
+        if (threads == 1)
+            reference = sum;
+        failures += sum != reference;
+
+        std::cout << "  " << std::setw(7) << threads << "   " << std::setw(7) << std::fixed << std::setprecision(0)
+                  << ticks / seconds << "   " << std::setw(9) << ticks * snakes / seconds
+                  << "   " << std::setw(8) << foods << "   " << std::setw(6) << deaths
+                  << "   " << (sum == reference ? "yes" : "NO") << "\n";
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
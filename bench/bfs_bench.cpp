@@ -0,0 +1,131 @@
+/**
+ * @file bfs_bench.cpp
+ *
+ * @description
+ * This program measures how the layer-parallel BFS scales with the number
+ * of threads on generated open arenas with scattered obstacles. Every
+ * query is solved with 1, 2, 4, ... threads; each run must reach the same
+ * cells with the same parents as the single-threaded one, and its path
+ * must be as long as the one found by the serial BFS of the player.
+ *
+ * Usage: snaze_bfs_bench [size] [max_threads] [queries] [obstacle_density] [seed]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common.h"
+#include "grid_view.h"
+#include "level.h"
+#include "maze_gen.h"
+#include "parallel_bfs.h"
+#include "player.h"
+
+using clock_type = std::chrono::steady_clock;
+
+/**
+ * @brief Counts the moves of the path to a cell by walking its parents back.
+ *
+ * @param parent The direction used to enter each cell.
+ * @param origin The cell where the search started.
+ * @param cell The cell where the path ends.
+ * @param cols The number of cols in the arena.
+ * @return The number of moves from the origin to the cell.
+ */
+size_t path_length(const std::vector<short> &parent, snaze::cell_t origin, snaze::cell_t cell, size_t cols)
+{
+    size_t moves = 0;
+    for (; cell != origin; ++moves) {
+        switch (parent[cell]) {
+            case snaze::UP:    cell += cols; break;
+            case snaze::DOWN:  cell -= cols; break;
+            case snaze::LEFT:  cell += 1; break;
+            default:    cell -= 1; break;
+        }
+    }
+
+    return moves;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    size_t queries = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 5;
+    double density = argc > 4 ? std::strtod(argv[4], nullptr) : 0.2;
+    unsigned seed = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 42;
+
+    std::mt19937 rng(seed);
+    snaze::Level level(snaze::generate_maze(snaze::maze_style_e::ARENA, size, size, seed, density));
+    snaze::GridView grid = level.view();
+    std::vector<size_t> vacate(size * size, 0);
+
+    // Picks a random free cell of the arena.
+    std::uniform_int_distribution<size_t> coord(1, size - 2);
+    auto free_cell = [&]() {
+        snaze::Position pos;
+        do {
+            pos = snaze::Position(coord(rng), coord(rng));
+        } while (level.cell(pos) != snaze::Cell::cell_e::FREE);
+        return pos;
+    };
+
+    std::vector<std::pair<snaze::Position, snaze::Position>> pairs;
+    for (size_t q = 0; q < queries; ++q)
+        pairs.emplace_back(free_cell(), free_cell());
+
+    // Path lengths of the serial BFS of the player, the reference for every run.
+    snaze::Player serial(level, player_e::TIMED);
+    std::vector<size_t> expected;
+    double serial_ms = 0;
+    for (const auto &[start, end] : pairs) {
+        auto t0 = clock_type::now();
+        bool found = serial.find_solution(start, end);
+        serial_ms += std::chrono::duration<double, std::milli>(clock_type::now() - t0).count();
+        expected.push_back(found ? serial.amount_of_steps() - 1 : SIZE_MAX);
+    }
+
+    std::cout << "arena " << size << "x" << size << ", obstacle density " << density
+              << ", " << queries << " queries, seed " << seed << "\n";
+    std::cout << "  serial player bfs: " << serial_ms / queries << " ms/query\n";
+    std::cout << "  threads   ms/query   speedup   mismatches\n";
+
+    std::vector<std::vector<short>> reference(queries);
+    double base_ms = 0;
+    size_t failures = 0;
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        snaze::ParallelBfs bfs(threads);
+        double ms = 0;
+        size_t mismatches = 0;
+
+        for (size_t q = 0; q < queries; ++q) {
+            snaze::cell_t origin = snaze::to_cell(pairs[q].first, size), target = snaze::to_cell(pairs[q].second, size);
+            std::vector<short> parent(size * size, -1);
+            parent[origin] = 4;
+
+            auto t0 = clock_type::now();
+            snaze::cell_t reached = bfs.search(grid, vacate, origin, target, parent);
+            ms += std::chrono::duration<double, std::milli>(clock_type::now() - t0).count();
+
+            size_t length = reached == target ? path_length(parent, origin, target, size) : SIZE_MAX;
+            if (threads == 1)
+                reference[q] = parent;
+            if (length != expected[q] or parent != reference[q])
+                ++mismatches;
+        }
+
+        if (threads == 1)
+            base_ms = ms;
+        failures += mismatches;
+
+        std::cout << "  " << std::setw(7) << threads << "   " << std::setw(8) << std::fixed << std::setprecision(2) << ms / queries
+                  << "   " << std::setw(6) << base_ms / ms << "x   " << mismatches << "\n";
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file incremental_bench.cpp
+ *
+ * @description
+ * This program measures what the incremental planner pays per move on
+ * generated open arenas with scattered obstacles. A snake walks to random
+ * goals, growing up to the given length; after every move the planner
+ * repairs its search around the new head and the freed tail, and a fresh
+ * planner searches from scratch from the same head. Both must find the
+ * same distance to the goal.
+ *
+ * Usage: snaze_incremental_bench [size] [obstacle_density] [walks] [snake_length] [seed]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common.h"
+#include "incremental.h"
+#include "level.h"
+#include "maze_gen.h"
+
+using clock_type = std::chrono::steady_clock;
+
+int main(int argc, char *argv[])
+{
+    size_t size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    double density = argc > 2 ? std::strtod(argv[2], nullptr) : 0.2;
+    size_t walks = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10;
+    size_t length = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 64;
+    unsigned seed = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 42;
+
+    std::mt19937 rng(seed);
+    snaze::Level level(snaze::generate_maze(snaze::maze_style_e::ARENA, size, size, seed, density));
+
+    // Picks a random free cell of the arena.
+    std::uniform_int_distribution<size_t> coord(1, size - 2);
+    auto free_cell = [&]() {
+        snaze::Position pos;
+        do {
+            pos = snaze::Position(coord(rng), coord(rng));
+        } while (level.cell(pos) != snaze::Cell::cell_e::FREE);
+        return pos;
+    };
+
+    // The corner of the spawn may be closed off by obstacles, so the snake starts at a random cell.
+    snaze::Position head = free_cell();
+    level.spawn(head);
+    level.reset();
+    level.place_snake(head);
+
+    snaze::IncrementalPlanner incremental, scratch;
+
+    double plan_ms = 0, repair_ms = 0, scratch_ms = 0;
+    size_t planned = 0, plan_expanded = 0, repair_expanded = 0, scratch_expanded = 0;
+    size_t moves = 0, mismatches = 0;
+
+    for (size_t walk = 0; walk < walks; ++walk) {
+        snaze::Position goal = free_cell();
+
+        auto t0 = clock_type::now();
+        bool found = incremental.plan(level, head, goal);
+        auto t1 = clock_type::now();
+        plan_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        plan_expanded += incremental.expanded();
+        if (not found)
+            continue;
+        ++planned;
+
+        while (not (head == goal)) {
+            auto dir = incremental.next();
+            if (not dir)
+                break;
+
+            // The snake grows on its first moves, then keeps its length.
+            snaze::Position tail = level.snake().tail();
+            level.update(head, *dir, false);
+            head = level.move_to(head, *dir);
+            if (level.snake().size() < length)
+                level.update(head, *dir, true);
+            ++moves;
+
+            size_t expanded = incremental.expanded();
+            auto t2 = clock_type::now();
+            incremental.move(level, head, { head, tail });
+            auto t3 = clock_type::now();
+            scratch.plan(level, head, goal);
+            auto t4 = clock_type::now();
+
+            repair_ms += std::chrono::duration<double, std::milli>(t3 - t2).count();
+            scratch_ms += std::chrono::duration<double, std::milli>(t4 - t3).count();
+            repair_expanded += incremental.expanded() - expanded;
+            scratch_expanded += scratch.expanded();
+
+            if (incremental.distance() != scratch.distance())
+                ++mismatches;
+        }
+    }
+
+    // Keeps the averages finite when no walk reached a goal.
+    const double per_walk = std::max<size_t>(walks, 1);
+    const double per_move = std::max<size_t>(moves, 1);
+
+    std::cout << "arena " << size << "x" << size << ", obstacle density " << density
+              << ", " << walks << " walks (" << planned << " reachable), snake length " << length
+              << ", seed " << seed << "\n";
+    std::cout << "  first search: " << plan_expanded / per_walk << " cells expanded, "
+              << plan_ms / per_walk << " ms per walk\n";
+    std::cout << "  repair:       " << repair_expanded / per_move << " cells expanded, "
+              << repair_ms * 1000 / per_move << " us per move\n";
+    std::cout << "  from scratch: " << scratch_expanded / per_move << " cells expanded, "
+              << scratch_ms * 1000 / per_move << " us per move\n";
+    std::cout << "  " << moves << " moves, distance mismatches: " << mismatches << "\n";
+
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
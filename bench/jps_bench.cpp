@@ -0,0 +1,77 @@
+/**
+ * @file jps_bench.cpp
+ *
+ * @description
+ * This program compares Jump Point Search against the BFS planner on
+ * generated open arenas with scattered obstacles. Every query is solved
+ * by both planners, and their path lengths must match.
+ *
+ * Usage: snaze_jps_bench [size] [obstacle_density] [queries] [seed]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common.h"
+#include "level.h"
+#include "maze_gen.h"
+#include "player.h"
+
+using clock_type = std::chrono::steady_clock;
+
+int main(int argc, char *argv[])
+{
+    size_t size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    double density = argc > 2 ? std::strtod(argv[2], nullptr) : 0.2;
+    size_t queries = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20;
+    unsigned seed = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 42;
+
+    std::mt19937 rng(seed);
+    snaze::Level level(snaze::generate_maze(snaze::maze_style_e::ARENA, size, size, seed, density));
+
+    // Picks a random free cell of the arena.
+    std::uniform_int_distribution<size_t> coord(1, size - 2);
+    auto free_cell = [&]() {
+        snaze::Position pos;
+        do {
+            pos = snaze::Position(coord(rng), coord(rng));
+        } while (level.cell(pos) != snaze::Cell::cell_e::FREE);
+        return pos;
+    };
+
+    snaze::Player bfs(level, player_e::TIMED);
+    snaze::Player jps(level, player_e::JUMP_POINT);
+
+    double bfs_ms = 0, jps_ms = 0;
+    size_t solved = 0, mismatches = 0;
+
+    for (size_t q = 0; q < queries; ++q) {
+        snaze::Position start = free_cell(), end = free_cell();
+
+        auto t0 = clock_type::now();
+        bool bfs_found = bfs.find_solution(start, end);
+        auto t1 = clock_type::now();
+        bool jps_found = jps.find_solution(start, end);
+        auto t2 = clock_type::now();
+
+        bfs_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        jps_ms += std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+        if (bfs_found != jps_found or (bfs_found and bfs.amount_of_steps() != jps.amount_of_steps()))
+            ++mismatches;
+        if (bfs_found)
+            ++solved;
+    }
+
+    std::cout << "arena " << size << "x" << size << ", obstacle density " << density
+              << ", " << queries << " queries (" << solved << " reachable), seed " << seed << "\n";
+    std::cout << "  bfs: " << bfs_ms / queries << " ms/query\n";
+    std::cout << "  jps: " << jps_ms / queries << " ms/query\n";
+    std::cout << "  speedup: " << bfs_ms / jps_ms << "x\n";
+    std::cout << "  path length mismatches: " << mismatches << "\n";
+
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
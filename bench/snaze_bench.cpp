@@ -0,0 +1,619 @@
+/**
+ * @file snaze_bench.cpp
+ *
+ * @description
+ * This program times the hot paths of the game on every maze of the level
+ * files and on a generated open arena: reading a level file, planning a
+ * path with the main players, moving the snake, placing food, drawing the
+ * board, writing observations, resetting the level and stepping and
+ * undoing a game state. The snake is grown along the Hamiltonian cycle of
+ * the maze first, so it keeps moving at the length asked for; on a maze
+ * without a cycle it is grown by a walk from the spawn instead, which is
+ * reported on stderr, and moves as a single cell.
+ *
+ * The game state is also checked: random walks are undone many times and
+ * must restore the state they started from exactly, or the run fails.
+ * So is the transposition table: several threads store and probe a small
+ * table at once, and a probe must never return an entry stored for
+ * another key, or one mixing two writes.
+ *
+ * Every operation runs in batches until it took the minimum time; setup
+ * between batches is not timed. Allocations are counted by replacing the
+ * global `operator new`. The results are written to the standard output
+ * as JSON, one entry per maze and operation, to compare versions.
+ *
+ * Usage: snaze_bench [size] [snake_length] [min_ms] [seed] [level files or directories...]
+ *
+ * The level files default to the `.dat` files of the `assets` directory.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <new>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+#include "game_state.h"
+#include "level.h"
+#include "maze_file.h"
+#include "maze_gen.h"
+#include "observer.h"
+#include "player.h"
+#include "transposition.h"
+
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+
+std::atomic<uint64_t> allocations { 0 };    //!< Calls to `operator new` so far.
+std::atomic<uint64_t> allocated { 0 };      //!< Bytes asked to `operator new` so far.
+
+/// The cost of one operation on one maze.
+struct Result {
+    std::string maze;       //!< Name of the maze.
+    std::string op;         //!< Name of the operation.
+    size_t rows, cols;      //!< Size of the maze, or of the largest maze of a file.
+    size_t snake;           //!< Length of the snake.
+    size_t cells = 0;       //!< Cells handled per operation, if not `rows * cols`.
+    uint64_t ops = 0;       //!< Operations timed.
+    double ns = 0;          //!< Time spent in them.
+    uint64_t allocs = 0;    //!< Allocations made by them.
+    uint64_t bytes = 0;     //!< Bytes allocated by them.
+};
+
+/// The options shared by every measure.
+struct Options {
+    double min_ms;          //!< Time each operation runs for at least.
+    size_t length;          //!< Length the snake is grown to.
+    unsigned seed;          //!< Seed of the food and of the queries.
+};
+
+/**
+ * @brief Times an operation in batches until it ran for the minimum time.
+ *
+ * @param result Receives the operations, time and allocations.
+ * @param options The minimum time.
+ * @param batch The number of operations per batch.
+ * @param setup Prepares a batch, untimed; called with the batch size.
+ * @param op Runs one operation; called with its index in the batch.
+ */
+template <typename Setup, typename Op>
+void measure(Result &result, const Options &options, size_t batch, Setup setup, Op op)
+{
+    const double min_ns = options.min_ms * 1e6;
+    while (result.ns < min_ns) {
+        setup(batch);
+
+        uint64_t allocs = allocations.load(std::memory_order_relaxed);
+        uint64_t bytes = allocated.load(std::memory_order_relaxed);
+        auto t0 = clock_type::now();
+        for (size_t i = 0; i < batch; ++i)
+            op(i);
+        auto t1 = clock_type::now();
+
+        result.allocs += allocations.load(std::memory_order_relaxed) - allocs;
+        result.bytes += allocated.load(std::memory_order_relaxed) - bytes;
+        result.ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        result.ops += batch;
+    }
+}
+
+/**
+ * @brief Grows the snake along a walk from the spawn, for mazes without a cycle.
+ *
+ * The cells reachable from the spawn are counted by a BFS first. The walk
+ * then eats after each move, stepping to the open neighbor with the fewest
+ * open neighbors of its own, which keeps it along the walls and out of
+ * dead ends it could leave open, until it is long enough or boxed in.
+ *
+ * @param level The level.
+ * @param length The length to reach, capped to half the reachable cells.
+ * @return The length reached.
+ */
+size_t walk_snake(snaze::Level &level, size_t length)
+{
+    const snaze::dir_e dirs[] = { snaze::UP, snaze::LEFT, snaze::DOWN, snaze::RIGHT };
+    snaze::Position pos = level.spawn();
+    level.reset();
+    level.place_snake(pos);
+
+    std::vector<bool> seen(level.rows() * level.cols(), false);
+    std::vector<snaze::Position> queue { pos };
+    seen[pos.row * level.cols() + pos.col] = true;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        for (snaze::dir_e dir : dirs) {
+            if (level.is_blocked(queue[i], dir))
+                continue;
+            snaze::Position next = level.move_to(queue[i], dir);
+            if (not seen[next.row * level.cols() + next.col]) {
+                seen[next.row * level.cols() + next.col] = true;
+                queue.push_back(next);
+            }
+        }
+    }
+
+    // Counts the open neighbors of a cell.
+    auto exits = [&](const snaze::Position &cell) {
+        size_t count = 0;
+        for (snaze::dir_e dir : dirs)
+            count += not level.is_blocked(cell, dir);
+        return count;
+    };
+
+    length = std::max<size_t>(1, std::min(length, queue.size() / 2));
+    for (size_t i = 1; i < length; ++i) {
+        std::optional<snaze::dir_e> best;
+        size_t fewest = 0;
+        for (snaze::dir_e dir : dirs) {
+            if (level.is_blocked(pos, dir))
+                continue;
+            // The cell left behind is taken by the body, so it does not count.
+            size_t count = exits(level.move_to(pos, dir)) - 1;
+            if (not best or count < fewest) {
+                best = dir;
+                fewest = count;
+            }
+        }
+        if (not best)
+            break;
+
+        level.update(pos, *best, false);
+        pos = level.move_to(pos, *best);
+        level.update(pos, *best, true);
+    }
+
+    return level.snake().size();
+}
+
+/**
+ * @brief Grows the snake along the Hamiltonian cycle of the maze.
+ *
+ * The snake starts at the spawn if the cycle covers it, at the first cell
+ * of the cycle otherwise, and eats after each move until it is long enough.
+ *
+ * @param level The level, whose spawn may move.
+ * @param length The length to reach, capped to half the cycle.
+ * @return The length reached, 0 if the maze has no cycle.
+ */
+size_t grow_snake(snaze::Level &level, size_t length)
+{
+    const snaze::HamiltonianCycle &cycle = level.cycle();
+    snaze::Position pos = level.spawn();
+    for (size_t r = 0; r < level.rows() and not cycle.contains(pos); ++r)
+        for (size_t c = 0; c < level.cols() and not cycle.contains(pos); ++c)
+            pos = snaze::Position(r, c);
+    if (not cycle.contains(pos))
+        return 0;
+
+    level.spawn(pos);
+    level.reset();
+    level.place_snake(pos);
+
+    length = std::max<size_t>(1, std::min(length, cycle.size() / 2));
+    for (size_t i = 1; i < length; ++i) {
+        snaze::dir_e dir = cycle.next(pos);
+        level.update(pos, dir, false);
+        pos = level.move_to(pos, dir);
+        level.update(pos, dir, true);
+    }
+
+    return level.snake().size();
+}
+
+/**
+ * @brief Times every operation on a maze.
+ *
+ * @param name The name of the maze.
+ * @param maze The maze.
+ * @param options The options of the run.
+ * @param results Receives one result per operation.
+ */
+void bench_maze(const std::string &name, const snaze::maze_t &maze, const Options &options, std::vector<Result> &results)
+{
+    snaze::Level base(maze);
+    base.seed(options.seed);
+
+    snaze::Level grown = base;
+    size_t length = grow_snake(grown, options.length);
+    const bool walked = length == 0;
+    if (walked) {
+        grown = base;
+        length = walk_snake(grown, options.length);
+        std::cerr << "snaze_bench: " << name << " has no Hamiltonian cycle, the snake was grown to "
+                  << length << " cells by a walk\n";
+    }
+    grown.add_food();
+
+    auto result = [&](const std::string &op, size_t snake) -> Result & {
+        results.push_back({ name, op, base.rows(), base.cols(), snake });
+        return results.back();
+    };
+    auto nothing = [](size_t) {};
+
+    // Queries from the head of the snake to random free cells.
+    std::mt19937 rng(options.seed);
+    std::uniform_int_distribution<size_t> row(0, base.rows() - 1), col(0, base.cols() - 1);
+    std::vector<snaze::Position> targets;
+    for (size_t tries = 0; targets.size() < 16 and tries < 100000; ++tries) {
+        snaze::Position pos(row(rng), col(rng));
+        if (grown.cell(pos) == snaze::Cell::cell_e::FREE)
+            targets.push_back(pos);
+    }
+
+    const std::pair<const char *, player_e> players[] = {
+        { "find_solution/backtracking", player_e::BACKTRACKING },
+        { "find_solution/timed", player_e::TIMED },
+        { "find_solution/jps", player_e::JUMP_POINT },
+    };
+    for (const auto &[op, type] : players) {
+        if (targets.empty())
+            break;
+        snaze::Player player(grown, type);
+        snaze::Position head = grown.snake().head();
+        measure(result(op, length), options, targets.size(), nothing,
+                [&](size_t i) { player.find_solution(head, targets[i]); });
+    }
+
+    // The snake goes round the cycle, or back and forth next to its spawn as a single cell without one.
+    {
+        snaze::Level level = grown;
+        if (walked) {
+            level = base;
+            level.place_snake(level.spawn());
+        }
+        snaze::Position pos = level.snake().head();
+        const snaze::HamiltonianCycle &cycle = level.cycle();
+        bool bounce = not cycle.contains(pos);
+        snaze::dir_e way = snaze::UP;
+        size_t ways = 0;
+        for (snaze::dir_e dir : { snaze::UP, snaze::LEFT, snaze::DOWN, snaze::RIGHT })
+            if (not level.is_blocked(pos, dir) and ways++ == 0)
+                way = dir;
+
+        if (not bounce or ways > 0) {
+            measure(result("update", level.snake().size()), options, 1024, nothing, [&](size_t) {
+                snaze::dir_e dir = bounce ? way : cycle.next(pos);
+                level.update(pos, dir, false);
+                pos = level.move_to(pos, dir);
+                way = static_cast<snaze::dir_e>((way + 2) % 4);
+            });
+        }
+    }
+
+    // One food more per call, so every call places exactly one.
+    {
+        snaze::Level level = grown;
+        size_t free = 0;
+        for (size_t r = 0; r < level.rows(); ++r)
+            for (size_t c = 0; c < level.cols(); ++c)
+                free += level.cell(snaze::Position(r, c)) == snaze::Cell::cell_e::FREE;
+        size_t batch = std::clamp<size_t>(free / 4, 1, 256);
+        measure(result("add_food", length), options, batch,
+                [&](size_t) { level = grown; },
+                [&](size_t i) { level.board(level.foods().size() + 1); level.add_food(); });
+    }
+
+    {
+        size_t chars = 0;
+        measure(result("to_string", length), options, 64, nothing,
+                [&](size_t) { chars += grown.to_string().size(); });
+        if (chars == 0)
+            std::cerr << "snaze_bench: empty board\n";
+    }
+
+    // Observations are written into one buffer, which must not allocate.
+    {
+        const std::pair<const char *, snaze::Observer::format_e> formats[] = {
+            { "observe/codes", snaze::Observer::format_e::CODES },
+            { "observe/planes", snaze::Observer::format_e::PLANES },
+            { "observe/window", snaze::Observer::format_e::WINDOW },
+        };
+        for (const auto &[op, format] : formats) {
+            snaze::Observer observer(*grown.layout(), format);
+            std::vector<uint8_t> board(observer.size());
+            measure(result(op, length), options, 64, nothing, [&](size_t) { observer.fill(grown, board.data()); });
+        }
+    }
+
+    // Copies of a level with the snake and food on it, each reset once.
+    {
+        std::vector<snaze::Level> levels;
+        measure(result("reset", length), options, 64,
+                [&](size_t batch) { levels.assign(batch, grown); },
+                [&](size_t i) { levels[i].reset(); });
+    }
+
+    // Random walks of up to 16 steps, each undone; one operation is one step and its undo.
+    {
+        snaze::GameState state(grown, 3);
+        std::uniform_int_distribution<int> dir(0, 3);
+        uint64_t steps = 0;
+        auto walk = [&] {
+            snaze::GameState::mark_t mark = state.snapshot();
+            for (size_t i = 0; i < 16 and not state.dead(); ++i, ++steps)
+                state.step(static_cast<snaze::dir_e>(dir(rng)));
+            state.restore(mark);
+        };
+
+        Result &steps_undone = result("step_undo", length);
+        measure(steps_undone, options, 1024, nothing, [&](size_t) { walk(); });
+        steps_undone.ops = steps;
+
+        // Every walk must give back the exact state; the cells are compared on a budget.
+        const snaze::GameState start = state;
+        const size_t cells = state.rows() * state.cols();
+        const size_t rounds = std::clamp<size_t>(size_t(2e8) / cells, 100, 20000);
+        for (size_t round = 0; round < rounds; ++round) {
+            walk();
+            if (state.hash() != start.hash() or state.head() != start.head() or state.tail() != start.tail()
+                    or state.length() != start.length() or state.food() != start.food()
+                    or state.score() != start.score() or state.lives() != start.lives()
+                    or state.rng().state() != start.rng().state()
+                    or std::memcmp(state.cells(), start.cells(), cells * sizeof(*state.cells())) != 0) {
+                std::cerr << "snaze_bench: " << name << ": undoing walk " << round << " did not restore the state\n";
+                std::exit(1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Times the reading of level files, or of a generated one from memory.
+ *
+ * @param name The name of the file.
+ * @param read Reads the mazes into a list; false on an error.
+ * @param options The options of the run.
+ * @param results Receives the result.
+ */
+template <typename Read>
+void bench_read(const std::string &name, Read read, const Options &options, std::vector<Result> &results)
+{
+    std::list<snaze::maze_t> mazes;
+    if (not read(mazes) or mazes.empty())
+        return;
+
+    size_t cells = 0;
+    for (const auto &maze : mazes)
+        cells += maze.size() * maze.front().size();
+
+    // The file reports the size of its largest maze, and the cells of all of them.
+    const auto largest = std::max_element(mazes.begin(), mazes.end(), [](const auto &a, const auto &b) {
+        return a.size() * a.front().size() < b.size() * b.front().size();
+    });
+    results.push_back({ name, "read_mazes", largest->size(), largest->front().size(), 0 });
+    results.back().cells = cells;
+    measure(results.back(), options, 16, [&](size_t) { mazes.clear(); },
+            [&](size_t) { read(mazes); });
+}
+
+/**
+ * @brief Returns the entry the table stress run stores for a key.
+ *
+ * Every field comes from the key, so an entry read back can be checked
+ * against the key it was found with. The flags are never zero, so no
+ * entry reads as an empty slot.
+ *
+ * @param key The key.
+ * @return The entry of the key.
+ */
+snaze::TranspositionTable::Entry table_entry(uint64_t key)
+{
+    snaze::TranspositionTable::Entry entry {};
+    entry.value = static_cast<float>(key & 0xffffff);
+    entry.depth = static_cast<uint16_t>(key >> 24);
+    entry.move = static_cast<uint8_t>(key >> 40);
+    entry.flags = static_cast<uint8_t>(key >> 48) | 1;
+    return entry;
+}
+
+/**
+ * @brief Stores and probes a small transposition table from several threads.
+ *
+ * Each thread draws keys from a few times as many as there are slots, so
+ * writers keep overwriting each other, and probes half of the time. A
+ * probe that hits must return the entry of its own key; a torn or foreign
+ * entry fails the run. One operation is one store or probe.
+ *
+ * @param options The options of the run.
+ * @param results Receives the result.
+ */
+void bench_table(const Options &options, std::vector<Result> &results)
+{
+    constexpr size_t SLOTS = 1 << 10;
+    const size_t threads = std::max(2u, std::thread::hardware_concurrency());
+
+    snaze::TranspositionTable table(SLOTS);
+    snaze::TranspositionTable::Entry empty;
+    if (table.probe(0, empty)) {
+        std::cerr << "snaze_bench: an empty transposition table found the key 0\n";
+        std::exit(1);
+    }
+
+    std::atomic<uint64_t> ops { 0 }, hits { 0 }, torn { 0 };
+    auto t0 = clock_type::now();
+    const auto end = t0 + std::chrono::duration<double, std::milli>(options.min_ms);
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 rng(options.seed + t);
+            std::uniform_int_distribution<uint64_t> pick(0, 4 * SLOTS - 1);
+            uint64_t done = 0, found = 0, bad = 0;
+            snaze::TranspositionTable::Entry entry, expected;
+
+            while (clock_type::now() < end) {
+                for (size_t i = 0; i < 1024; ++i, ++done) {
+                    // Spread the keys over the high bits too, keeping few of them.
+                    uint64_t key = pick(rng) * 0x9e3779b97f4a7c15ULL;
+                    expected = table_entry(key);
+                    if (rng() & 1) {
+                        table.store(key, expected);
+                    }
+                    else if (table.probe(key, entry)) {
+                        ++found;
+                        if (std::memcmp(&entry, &expected, sizeof(entry)) != 0)
+                            ++bad;
+                    }
+                }
+            }
+
+            ops += done;
+            hits += found;
+            torn += bad;
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    auto t1 = clock_type::now();
+
+    if (torn > 0 or hits == 0) {
+        std::cerr << "snaze_bench: the transposition table returned " << torn << " torn entries in "
+                  << hits << " hits\n";
+        std::exit(1);
+    }
+
+    results.push_back({ "transposition" + std::to_string(threads), "table_store_probe", 1, SLOTS, 0 });
+    results.back().cells = 1;
+    results.back().ops = ops;
+    results.back().ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+}
+
+/**
+ * @brief Writes the results as JSON.
+ *
+ * @param results The results.
+ * @param options The options of the run.
+ */
+void write_json(const std::vector<Result> &results, const Options &options)
+{
+    std::ostringstream out;
+    out << "{\n  \"seed\": " << options.seed << ",\n  \"min_ms\": " << options.min_ms
+        << ",\n  \"snake_length\": " << options.length << ",\n  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        double ops = static_cast<double>(r.ops);
+        double cells = static_cast<double>(r.cells != 0 ? r.cells : r.rows * r.cols);
+        out << (i == 0 ? "\n" : ",\n")
+            << "    { \"maze\": \"" << r.maze << "\", \"op\": \"" << r.op
+            << "\", \"rows\": " << r.rows << ", \"cols\": " << r.cols << ", \"snake\": " << r.snake
+            << ", \"ops\": " << r.ops
+            << ", \"ns_per_op\": " << r.ns / ops
+            << ", \"allocs_per_op\": " << r.allocs / ops
+            << ", \"bytes_per_op\": " << r.bytes / ops
+            << ", \"ops_per_sec\": " << ops * 1e9 / r.ns
+            << ", \"cells_per_sec\": " << ops * cells * 1e9 / r.ns << " }";
+    }
+    out << "\n  ]\n}\n";
+
+    std::cout << out.str();
+}
+
+} // ANONYMOUS NAMESPACE
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+// GCC sees the memory of the replaced `operator new` reach `free()` and takes it for a mismatch.
+#if defined(__GNUC__) and not defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char *argv[])
+{
+    size_t size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    Options options;
+    options.length = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 32;
+    options.min_ms = argc > 3 ? std::strtod(argv[3], nullptr) : 50;
+    options.seed = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 42;
+
+    // The level files, in order, from the arguments or the assets directory.
+    std::vector<std::string> paths;
+    std::vector<std::string> sources(argv + std::min(argc, 5), argv + argc);
+    if (sources.empty())
+        sources.push_back("assets");
+    for (const auto &source : sources) {
+        std::error_code error;
+        if (std::filesystem::is_directory(source, error)) {
+            std::vector<std::string> found;
+            for (const auto &entry : std::filesystem::directory_iterator(source, error))
+                if (entry.path().extension() == ".dat")
+                    found.push_back(entry.path().string());
+            std::sort(found.begin(), found.end());
+            paths.insert(paths.end(), found.begin(), found.end());
+        }
+        else {
+            paths.push_back(source);
+        }
+    }
+
+    std::vector<Result> results;
+
+    for (const auto &path : paths) {
+        std::list<snaze::maze_t> mazes;
+        if (not snaze::read_mazes(path, mazes)) {
+            std::cerr << "snaze_bench: skipping unreadable level file " << path << "\n";
+            continue;
+        }
+
+        bench_read(path, [&](std::list<snaze::maze_t> &out) { return snaze::read_mazes(path, out); }, options, results);
+
+        size_t index = 0;
+        for (const auto &maze : mazes) {
+            std::string name = path + "#" + std::to_string(index++);
+            bool ragged = maze.empty() or std::any_of(maze.begin(), maze.end(),
+                                                      [&](const auto &row) { return row.size() != maze.front().size(); });
+            if (ragged) {
+                std::cerr << "snaze_bench: skipping " << name << ": rows of different lengths\n";
+                continue;
+            }
+
+            try {
+                bench_maze(name, maze, options, results);
+            }
+            catch (const std::exception &e) {
+                std::cerr << "snaze_bench: skipping " << name << ": " << e.what() << "\n";
+            }
+        }
+    }
+
+    // The generated arena, read from memory to leave the disk out.
+    if (size >= 4) {
+        snaze::maze_t arena = snaze::generate_maze(snaze::maze_style_e::ARENA, size, size, options.seed, 0);
+        std::string name = "arena" + std::to_string(size);
+        std::ostringstream file;
+        snaze::write_maze(file, arena);
+        std::string text = file.str();
+        bench_read(name, [&](std::list<snaze::maze_t> &out) {
+            std::istringstream in(text);
+            return snaze::read_mazes(in, out);
+        }, options, results);
+        bench_maze(name, arena, options, results);
+    }
+
+    bench_table(options, results);
+
+    write_json(results, options);
+
+    return EXIT_SUCCESS;
+}
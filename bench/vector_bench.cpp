@@ -0,0 +1,203 @@
+/**
+ * @file vector_bench.cpp
+ *
+ * @description
+ * This program measures how many game steps per second the vectorized
+ * environment runs. The games play a cheap policy that heads for the food
+ * and avoids the cells the snake knows are taken; only the steps are
+ * timed. The same run is repeated with 1, 2, 4, ... threads, and each
+ * must end with the same games as the single-threaded one.
+ *
+ * Before timing, a few games take random moves next to a plain model that
+ * keeps each body in a deque, and every step must agree with it on deaths,
+ * foods, heads, lengths and the cells taken.
+ *
+ * Usage: snaze_vector_bench [games] [steps] [max_threads] [size] [seed]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "cell.h"
+#include "common.h"
+#include "layout.h"
+#include "maze_gen.h"
+#include "vector_env.h"
+
+using clock_type = std::chrono::steady_clock;
+
+/**
+ * @brief Picks a move towards the food that does not enter a taken cell.
+ *
+ * @param env The environment.
+ * @param game The game to move.
+ * @return The direction of the move.
+ */
+snaze::dir_e policy(const snaze::VectorEnv &env, size_t game)
+{
+    const size_t cols = env.cols();
+    snaze::cell_t head = env.head(game), food = env.food(game);
+    size_t row = head / cols, col = head % cols;
+    size_t food_row = food / cols, food_col = food % cols;
+
+    snaze::dir_e order[4] = { snaze::UP, snaze::LEFT, snaze::DOWN, snaze::RIGHT };
+    snaze::dir_e want = food_row < row ? snaze::UP : food_row > row ? snaze::DOWN
+                      : food_col < col ? snaze::LEFT : snaze::RIGHT;
+    std::swap(order[0], order[want]);
+
+    for (snaze::dir_e dir : order) {
+        snaze::cell_t next = dir == snaze::UP ? head - cols : dir == snaze::DOWN ? head + cols
+                           : dir == snaze::LEFT ? head - 1 : head + 1;
+        if (not env.taken(game, next))
+            return dir;
+    }
+
+    return want;
+}
+
+/**
+ * @brief Steps games with random moves next to a model keeping each body in a deque.
+ *
+ * The model follows the rules of `VectorEnv` on its own: the snake dies
+ * moving off the maze, into a wall or into any cell of its body, tail
+ * included; eating grows it on the same move; dying or finishing an
+ * episode puts it back at the spawn point with one cell. Only the foods
+ * are taken from the environment.
+ *
+ * @param layout The maze.
+ * @param games The number of games.
+ * @param steps The number of steps.
+ * @param seed The seed of the games and of the moves.
+ * @return The number of game steps where the environment and the model disagree.
+ */
+size_t check_reference(std::shared_ptr<const snaze::Layout> layout, size_t games, size_t steps, unsigned seed)
+{
+    const size_t rows = layout->rows(), cols = layout->cols(), cells = rows * cols;
+    const snaze::cell_t spawn = snaze::to_cell(layout->spawn(), cols);
+
+    snaze::VectorEnv env(layout, games, seed);
+    std::vector<std::deque<snaze::cell_t>> bodies(games, std::deque<snaze::cell_t>{ spawn });
+    std::vector<uint8_t> taken(games * cells, 0);
+    for (size_t game = 0; game < games; ++game)
+        taken[game * cells + spawn] = 1;
+
+    std::mt19937 rng(seed);
+    std::vector<snaze::dir_e> actions(games);
+    size_t disagreements = 0;
+
+    for (size_t t = 0; t < steps; ++t) {
+        std::vector<snaze::cell_t> foods(games);
+        for (size_t game = 0; game < games; ++game) {
+            actions[game] = static_cast<snaze::dir_e>(rng() % 4);
+            foods[game] = env.food(game);
+        }
+
+        env.step(actions.data());
+
+        for (size_t game = 0; game < games; ++game) {
+            auto &body = bodies[game];
+            uint8_t *board = &taken[game * cells];
+            size_t row = body.front() / cols, col = body.front() % cols;
+            switch (actions[game]) {
+                case snaze::UP:    --row; break;
+                case snaze::DOWN:  ++row; break;
+                case snaze::LEFT:  --col; break;
+                default:           ++col; break;
+            }
+
+            snaze::cell_t next = row * cols + col;
+            bool outside = row >= rows or col >= cols;
+            bool died = outside or board[next] or layout->cells()[next].type() == snaze::Cell::cell_e::WALL
+                     or layout->cells()[next].type() == snaze::Cell::cell_e::INV_WALL;
+            bool ate = not died and next == foods[game];
+            bool bad = (env.rewards()[game] < 0) != died or (env.rewards()[game] > 0) != ate;
+
+            if (died or env.dones()[game]) {
+                for (snaze::cell_t cell : body)
+                    board[cell] = 0;
+                body.assign(1, spawn);
+                board[spawn] = 1;
+            }
+            else {
+                body.push_front(next);
+                board[next] = 1;
+                if (not ate) {
+                    board[body.back()] = 0;
+                    body.pop_back();
+                }
+            }
+
+            bad = bad or env.head(game) != body.front() or env.length(game) != body.size();
+            for (snaze::cell_t cell = 0; cell < cells and not bad; ++cell)
+                bad = env.taken(game, cell) != bool(board[cell]);
+            disagreements += bad;
+        }
+    }
+
+    return disagreements;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t games = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    size_t steps = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    size_t max_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 8;
+    size_t size = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 32;
+    unsigned seed = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 42;
+
+    auto layout = std::make_shared<const snaze::Layout>(snaze::generate_maze(snaze::maze_style_e::ARENA, size, size, seed, 0.05));
+
+    std::cout << games << " games on a " << size << "x" << size << " arena, "
+              << steps << " steps, seed " << seed << "\n";
+    const size_t checked_games = 16, checked_steps = 5000;
+    size_t failures = check_reference(layout, checked_games, checked_steps, seed);
+    std::cout << "deque reference: " << checked_games * checked_steps << " game steps, "
+              << failures << " disagreements\n";
+
+    std::cout << "  threads   Msteps/s   episodes   mean reward   match\n";
+
+    uint64_t reference = 0;
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        snaze::VectorEnv env(layout, games, seed);
+        env.parallelize(threads);
+
+        std::vector<snaze::dir_e> actions(games);
+        uint64_t episodes = 0, hash = 0xcbf29ce484222325ULL;
+        double reward = 0, seconds = 0;
+
+        for (size_t t = 0; t < steps; ++t) {
+            for (size_t game = 0; game < games; ++game)
+                actions[game] = policy(env, game);
+
+            auto t0 = clock_type::now();
+            env.step(actions.data());
+            seconds += std::chrono::duration<double>(clock_type::now() - t0).count();
+
+            for (size_t game = 0; game < games; ++game) {
+                episodes += env.dones()[game];
+                reward += env.rewards()[game];
+                hash = (hash ^ (env.head(game) + uint64_t(env.score(game)) * 65599 + env.food(game))) * 0x100000001b3ULL;
+            }
+        }
+
+        if (threads == 1)
+            reference = hash;
+        failures += hash != reference;
+
+        std::cout << "  " << std::setw(7) << threads << "   " << std::setw(8) << std::fixed << std::setprecision(1)
+                  << env.steps() / seconds / 1e6 << "   " << std::setw(8) << episodes
+                  << "   " << std::setw(11) << std::setprecision(4) << reward / env.steps()
+                  << "   " << (hash == reference ? "yes" : "NO") << "\n";
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
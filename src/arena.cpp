@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+#include "cell.h"
+#include "common.h"
+#include "draw_cell.h"
+
+namespace snaze {
+
+/**
+ * @brief Places the snakes and the foods on a maze.
+ *
+ * The first snake starts at the spawn point of the maze and the others on
+ * random free cells, all with a single cell. Each snake gets its own
+ * generator, drawn from the seed, for the random choices of its planner.
+ *
+ * @param layout The walls of the maze, shared with the levels.
+ * @param snakes The number of snakes.
+ * @param foods The number of foods kept on the board.
+ * @param seed The seed of the positions and of the planners.
+ */
+Arena::Arena(std::shared_ptr<const Layout> layout, size_t snakes, size_t foods, Rng::state_t seed)
+    : m_layout(std::move(layout)), m_rows(m_layout->rows()), m_cols(m_layout->cols()),
+      m_cells(m_rows * m_cols), m_agents(snakes), m_food_slot(m_rows * m_cols, 0),
+      m_field(m_rows * m_cols, INF),
+      m_claims(m_rows * m_cols, 0), m_targets(snakes, NO_CELL), m_rng(seed), m_scratch(1)
+{
+    // The spawn point is an ordinary free cell once the snakes are placed.
+    for (cell_t id = 0; id < m_cells.size(); ++id) {
+        Cell::cell_e type = m_layout->cells()[id].type();
+        m_cells[id] = type == Cell::cell_e::SPAWN ? Cell::cell_e::FREE : type;
+    }
+
+    for (size_t i = 0; i < m_agents.size(); ++i) {
+        m_agents[i].rng = Rng(m_rng.next());
+
+        cell_t spawn = to_cell(m_layout->spawn(), m_cols);
+        cell_t cell = i == 0 and open(spawn) ? spawn : draw_free();
+        if (cell != NO_CELL)
+            respawn(m_agents[i], cell);
+    }
+
+    for (size_t i = 0; i < foods; ++i) {
+        cell_t cell = draw_free();
+        if (cell == NO_CELL)
+            break;
+        add_food(cell);
+    }
+}
+
+/**
+ * @brief Chooses the moves on several threads.
+ *
+ * @param threads The number of threads, the caller included; 0 uses every hardware thread.
+ */
+void Arena::parallelize(size_t threads)
+{
+    m_pool = std::make_shared<ThreadPool>(threads);
+    m_scratch.resize(m_pool->size());
+}
+
+/**
+ * @brief Chooses a move for every snake, then applies them all.
+ *
+ * Each thread decides for every n-th snake with its own buffers, reading
+ * the board of the last tick. The moves are then checked against that
+ * same board and applied one snake after the other; since no move may
+ * enter a cell another snake occupied, the order only decides which
+ * generator draws place the new foods and snakes.
+ */
+void Arena::tick()
+{
+    if (m_pool == nullptr) {
+        for (Agent &agent : m_agents)
+            if (agent.alive)
+                decide(agent, m_scratch[0]);
+    }
+    else {
+        const size_t threads = m_pool->size();
+        m_pool->run([&](size_t thread) {
+            for (size_t i = thread; i < m_agents.size(); i += threads)
+                if (m_agents[i].alive)
+                    decide(m_agents[i], m_scratch[thread]);
+        });
+    }
+
+    // Count the snakes moving into each cell, on the board of the last tick.
+    for (size_t i = 0; i < m_agents.size(); ++i) {
+        const Agent &agent = m_agents[i];
+        cell_t target = agent.alive ? neighbor(to_cell(agent.snake.head(), m_cols), agent.move) : NO_CELL;
+        m_targets[i] = open(target) ? target : NO_CELL;
+        if (m_targets[i] != NO_CELL)
+            ++m_claims[m_targets[i]];
+    }
+
+    size_t eaten = 0;
+    for (size_t i = 0; i < m_agents.size(); ++i) {
+        Agent &agent = m_agents[i];
+        if (not agent.alive)
+            continue;
+
+        cell_t target = m_targets[i];
+        if (target == NO_CELL or m_claims[target] > 1) {
+            remove(agent);
+            continue;
+        }
+
+        Position head = agent.snake.head();
+        Position next = to_position(target, m_cols);
+        bool ate = m_cells[target] == Cell::cell_e::FOOD;
+
+        if (ate) {
+            agent.snake.stretch(next);
+            agent.score += 20;
+            remove_food(target);
+            ++eaten;
+        }
+        else {
+            m_cells[to_cell(agent.snake.move(next), m_cols)] = Cell::cell_e::FREE;
+        }
+
+        if (agent.snake.size() > 1)
+            m_cells[to_cell(head, m_cols)] = Cell::cell_e::SNAKE_BODY;
+        m_cells[target] = Cell::cell_e::SNAKE_HEAD;
+        agent.snake.direction(agent.move);
+    }
+
+    for (cell_t target : m_targets)
+        if (target != NO_CELL)
+            m_claims[target] = 0;
+
+    // Replace the eaten foods, then bring the dead snakes back.
+    for (size_t i = 0; i < eaten; ++i) {
+        cell_t cell = draw_free();
+        if (cell != NO_CELL)
+            add_food(cell);
+    }
+
+    for (Agent &agent : m_agents) {
+        if (agent.alive)
+            continue;
+
+        cell_t cell = draw_free();
+        if (cell != NO_CELL)
+            respawn(agent, cell);
+    }
+
+    ++m_ticks;
+}
+
+/**
+ * @brief Chooses the move of a snake from the board of the last tick.
+ *
+ * Only moves that do not kill the snake at once are considered; if there
+ * is none, the snake keeps its direction and dies. Planners that find no
+ * way to a food pick one of those moves at random.
+ *
+ * @param agent The snake to move; receives its move.
+ * @param scratch The buffers of the calling thread.
+ */
+void Arena::decide(Agent &agent, Scratch &scratch) const
+{
+    cell_t head = to_cell(agent.snake.head(), m_cols);
+
+    dir_e moves[4];
+    size_t count = 0;
+    for (const dir_e dir : { UP, LEFT, DOWN, RIGHT })
+        if (open(neighbor(head, dir)))
+            moves[count++] = dir;
+
+    agent.move = agent.snake.direction();
+    if (count == 0)
+        return;
+
+    bool found = false;
+    if (agent.policy == policy_e::GREEDY) {
+        dist_t best = INF;
+        for (size_t i = 0; i < count; ++i) {
+            dist_t dist = m_field[neighbor(head, moves[i])];
+            if (dist < best) {
+                best = dist;
+                agent.move = moves[i];
+                found = true;
+            }
+        }
+    }
+    else if (agent.policy == policy_e::SEARCH) {
+        found = search(head, scratch, agent.move);
+    }
+
+    if (not found)
+        agent.move = moves[agent.rng.below(count)];
+}
+
+/**
+ * @brief Returns the first move of a BFS from a head to the nearest food.
+ *
+ * The search goes around the walls and every snake as they were at the
+ * end of the last tick. Cells are marked with the number of the search,
+ * so the buffers are never cleared between searches.
+ *
+ * @param head The cell of the snake head.
+ * @param scratch The buffers of the calling thread.
+ * @param move Receives the first move of the path, if there is one.
+ * @return true if a food was reached, false otherwise.
+ */
+bool Arena::search(cell_t head, Scratch &scratch, dir_e &move) const
+{
+    if (scratch.seen.size() != m_cells.size()) {
+        scratch.seen.assign(m_cells.size(), 0);
+        scratch.first.assign(m_cells.size(), 0);
+        scratch.search = 0;
+    }
+
+    // After wrapping around, old marks would look like new ones.
+    if (++scratch.search == 0) {
+        std::fill(scratch.seen.begin(), scratch.seen.end(), 0);
+        scratch.search = 1;
+    }
+
+    const uint32_t mark = scratch.search;
+    scratch.queue.clear();
+    scratch.seen[head] = mark;
+    scratch.queue.push_back(head);
+
+    for (size_t front = 0; front < scratch.queue.size(); ++front) {
+        cell_t cell = scratch.queue[front];
+
+        for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+            cell_t next = neighbor(cell, dir);
+            if (not open(next) or scratch.seen[next] == mark)
+                continue;
+
+            scratch.seen[next] = mark;
+            scratch.first[next] = cell == head ? dir : scratch.first[cell];
+
+            if (m_cells[next] == Cell::cell_e::FOOD) {
+                move = static_cast<dir_e>(scratch.first[next]);
+                return true;
+            }
+            scratch.queue.push_back(next);
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Returns the cell reached by moving from a cell.
+ *
+ * @param id The cell where the move starts.
+ * @param dir The direction of the move.
+ * @return The neighbor cell, or NO_CELL if it is outside the maze.
+ */
+cell_t Arena::neighbor(cell_t id, dir_e dir) const
+{
+    size_t r = id / m_cols, c = id % m_cols;
+
+    switch (dir) {
+        case UP:    return r > 0 ? id - m_cols : NO_CELL;
+        case DOWN:  return r + 1 < m_rows ? id + m_cols : NO_CELL;
+        case LEFT:  return c > 0 ? id - 1 : NO_CELL;
+        case RIGHT: return c + 1 < m_cols ? id + 1 : NO_CELL;
+        default:    return NO_CELL;
+    }
+}
+
+/**
+ * @brief Returns a free cell drawn by `draw_cell()`.
+ *
+ * @return A free cell, or NO_CELL if the board is full.
+ */
+cell_t Arena::draw_free()
+{
+    return draw_cell(m_rng, m_rows, m_cols, [this](cell_t cell) {
+        return m_cells[cell] == Cell::cell_e::FREE;
+    });
+}
+
+/**
+ * @brief Puts a new snake of one cell on a free cell.
+ *
+ * @param agent The snake to place; its score and deaths are kept.
+ * @param cell The free cell of the head.
+ */
+void Arena::respawn(Agent &agent, cell_t cell)
+{
+    agent.snake = Snake(to_position(cell, m_cols), m_cols);
+    agent.alive = true;
+    m_cells[cell] = Cell::cell_e::SNAKE_HEAD;
+}
+
+/**
+ * @brief Takes a dead snake off the board, freeing all of its cells.
+ *
+ * @param agent The snake that died.
+ */
+void Arena::remove(Agent &agent)
+{
+    for (cell_t segment : agent.snake.body())
+        m_cells[segment] = Cell::cell_e::FREE;
+
+    agent.snake = Snake();
+    agent.alive = false;
+    ++agent.deaths;
+}
+
+/**
+ * @brief Puts a food on a free cell.
+ *
+ * Distances can only drop, so they are lowered outwards from the food.
+ *
+ * @param cell The cell of the food.
+ */
+void Arena::add_food(cell_t cell)
+{
+    m_cells[cell] = Cell::cell_e::FOOD;
+    m_food_slot[cell] = m_foods.size();
+    m_foods.push_back(cell);
+
+    m_field[cell] = 0;
+    std::vector<cell_t> queue { cell };
+    relax(queue);
+}
+
+/**
+ * @brief Takes an eaten food off the list.
+ *
+ * The last food takes the place of the eaten one, so this costs O(1);
+ * the cell itself is overwritten by the snake that ate it. Only the cells
+ * for which this food was a nearest one lose their distance, and they take
+ * it again from the cells around them, so the cost is the size of that
+ * region instead of the maze.
+ *
+ * @param cell The cell of the eaten food.
+ */
+void Arena::remove_food(cell_t cell)
+{
+    cell_t last = m_foods.back();
+    m_foods[m_food_slot[cell]] = last;
+    m_food_slot[last] = m_food_slot[cell];
+    m_foods.pop_back();
+
+    // A cell as close to this food as to the nearest one is one step further than a cell that is too.
+    std::vector<std::pair<cell_t, dist_t>> region { { cell, m_field[cell] } };
+    m_field[cell] = INF;
+    for (size_t front = 0; front < region.size(); ++front) {
+        auto [id, dist] = region[front];
+        for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+            cell_t next = neighbor(id, dir);
+            if (next != NO_CELL and m_field[next] == dist + 1) {
+                region.emplace_back(next, dist + 1);
+                m_field[next] = INF;
+            }
+        }
+    }
+
+    // The region takes its distances again from the cells around it.
+    std::vector<cell_t> queue;
+    for (const auto &entry : region) {
+        for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+            cell_t next = neighbor(entry.first, dir);
+            if (next != NO_CELL and m_field[next] != INF)
+                queue.push_back(next);
+        }
+    }
+    relax(queue);
+}
+
+/**
+ * @brief Lowers the distances of the neighbors of the queued cells.
+ *
+ * A neighbor takes the distance of a queued cell plus one whenever
+ * going through it is shorter, and is queued in turn. Walls are skipped;
+ * the snakes are not, so the field stays valid while they move.
+ *
+ * @param queue The cells whose distance has just been lowered or must be spread.
+ */
+void Arena::relax(std::vector<cell_t> &queue)
+{
+    for (size_t front = 0; front < queue.size(); ++front) {
+        cell_t cell = queue[front];
+
+        for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+            cell_t next = neighbor(cell, dir);
+            if (next == NO_CELL or m_field[next] <= m_field[cell] + 1)
+                continue;
+
+            Cell::cell_e type = m_layout->cells()[next].type();
+            if (type == Cell::cell_e::WALL or type == Cell::cell_e::INV_WALL)
+                continue;
+
+            m_field[next] = m_field[cell] + 1;
+            queue.push_back(next);
+        }
+    }
+}
+
+/**
+ * @brief Converts the board into a string representation.
+ *
+ * Walls are drawn as '#', foods as '*', and each snake with a letter of
+ * its own, upper case for the head.
+ *
+ * @return A string representation of the board.
+ */
+std::string Arena::to_string() const
+{
+    std::string board;
+    board.reserve(m_rows * (m_cols + 1));
+
+    for (size_t r = 0; r < m_rows; ++r) {
+        for (size_t c = 0; c < m_cols; ++c) {
+            Cell::cell_e type = m_cells[r * m_cols + c];
+            board += type == Cell::cell_e::WALL ? '#' : type == Cell::cell_e::FOOD ? '*' : ' ';
+        }
+        board += '\n';
+    }
+
+    for (size_t i = 0; i < m_agents.size(); ++i) {
+        for (cell_t segment : m_agents[i].snake.body())
+            board[segment / m_cols * (m_cols + 1) + segment % m_cols] = 'a' + i % 26;
+        if (m_agents[i].alive) {
+            cell_t head = to_cell(m_agents[i].snake.head(), m_cols);
+            board[head / m_cols * (m_cols + 1) + head % m_cols] = 'A' + i % 26;
+        }
+    }
+
+    return board;
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,170 @@
+/**
+ * @file arena.h
+ *
+ * @description
+ * This class runs many snakes on one maze at once. Each snake has its own
+ * planner, and every tick has two phases. First all snakes choose a move
+ * from the state of the last tick, which only reads shared data, so the
+ * choices are spread over a thread pool. Then the moves are applied as a
+ * batch, in the order of the snakes:
+ *
+ * - a snake moving into anything but a free cell or a food dies, tails
+ *   included, since every snake sees the board as it was;
+ * - snakes moving into the same cell all die, so no snake wins a tie for
+ *   being listed first;
+ * - a snake eating grows at once, and the food is replaced;
+ * - a dead snake leaves the board and comes back with a single cell.
+ *
+ * Applying a move only touches its head and tail, and each segment freed
+ * by a death was added by an earlier move, so the board is updated in
+ * O(snakes) per tick. Nothing depends on the number of threads, so a run
+ * is reproducible for a seed.
+ *
+ * The arena is not the game with more snakes, and its rules diverge:
+ *
+ * - entering a tail kills, even the tail a snake is leaving, which the
+ *   game and `GameState` allow, since the moves of a tick are resolved
+ *   against the board of the last one;
+ * - the policies are small planners of the arena's own, not the players
+ *   of `Player`, which plan on a `Level` holding a single snake.
+ *
+ * Foods and respawns are drawn with `draw_cell()`, like a level draws its
+ * foods.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cell.h"
+#include "common.h"
+#include "layout.h"
+#include "rng.h"
+#include "snake.h"
+#include "thread_pool.h"
+
+namespace snaze {
+
+class Arena {
+public:
+    //== Aliases
+    using count_t = unsigned;
+    using dist_t = uint32_t;
+
+    //== Enums
+
+    /// How a snake chooses its moves.
+    enum class policy_e : uint8_t {
+        RANDOM = 0, //!< Any move that does not kill it at once.
+        GREEDY,     //!< Closest to a food around the walls, ignoring the snakes.
+        SEARCH,     //!< First move of a BFS to the nearest food around everything.
+    };
+
+    /// Distance of a cell that reaches no food.
+    static constexpr dist_t INF = UINT32_MAX;
+
+    /// Default constructor.
+    Arena() = default;
+    /// Places the snakes and the foods on a maze; the first snake starts at its spawn point.
+    Arena(std::shared_ptr<const Layout>, size_t snakes, size_t foods, Rng::state_t seed);
+    /// Destructor.
+    ~Arena() = default;
+
+    /// Chooses the moves on the given number of threads; 0 uses every hardware thread.
+    void parallelize(size_t threads);
+    /// Sets the planner of a snake.
+    void policy(size_t snake, policy_e policy) { m_agents[snake].policy = policy; }
+    /// Chooses a move for every snake, then applies them all.
+    void tick();
+
+    /// Returns the number of rows in the maze.
+    size_t rows() const { return m_rows; }
+    /// Returns the number of cols in the maze.
+    size_t cols() const { return m_cols; }
+    /// Returns the type of a cell.
+    Cell::cell_e cell(cell_t id) const { return m_cells[id]; }
+    /// Returns the cells holding a food.
+    const std::vector<cell_t> &foods() const { return m_foods; }
+    /// Returns the number of snakes.
+    size_t size() const { return m_agents.size(); }
+    /// Returns a snake, which is empty while it waits to come back.
+    const Snake &snake(size_t id) const { return m_agents[id].snake; }
+    /// Returns whether a snake is on the board.
+    bool alive(size_t id) const { return m_agents[id].alive; }
+    /// Returns the score of a snake.
+    count_t score(size_t id) const { return m_agents[id].score; }
+    /// Returns how many times a snake died.
+    count_t deaths(size_t id) const { return m_agents[id].deaths; }
+    /// Returns the number of ticks run.
+    uint64_t ticks() const { return m_ticks; }
+
+    /// Returns the ASCII representation of the board, snakes as letters.
+    std::string to_string() const;
+
+private:
+    /// A snake and everything its planner keeps between ticks.
+    struct Agent {
+        Snake snake;                        //!< Cells of the snake, from tail to head.
+        policy_e policy = policy_e::GREEDY; //!< How the snake chooses its moves.
+        Rng rng;                            //!< Generator of the random choices of the snake.
+        dir_e move = UP;                    //!< Move chosen in the current tick.
+        count_t score = 0;                  //!< Points earned, 20 per food.
+        count_t deaths = 0;                 //!< Times the snake died.
+        bool alive = false;                 //!< Whether the snake is on the board.
+    };
+
+    /// Buffers of a thread for the searches of the snakes.
+    struct Scratch {
+        std::vector<uint32_t> seen;     //!< Search that last visited each cell.
+        std::vector<uint8_t> first;     //!< First move of the path to each visited cell.
+        std::vector<cell_t> queue;      //!< Cells to expand, in order.
+        uint32_t search = 0;            //!< Number of searches run so far.
+    };
+
+    /// Chooses the move of a snake from the board of the last tick.
+    void decide(Agent &, Scratch &) const;
+    /// Returns the first move of a BFS from a head to the nearest food.
+    bool search(cell_t head, Scratch &, dir_e &) const;
+    /// Returns the cell reached by moving from a cell, or NO_CELL outside the maze.
+    cell_t neighbor(cell_t, dir_e) const;
+    /// Checks whether a snake may move into a cell.
+    bool open(cell_t id) const {
+        return id != NO_CELL and (m_cells[id] == Cell::cell_e::FREE or m_cells[id] == Cell::cell_e::FOOD);
+    }
+    /// Returns a random free cell off the border, or NO_CELL if none is left.
+    cell_t draw_free();
+    /// Puts a new snake of one cell on a random free cell.
+    void respawn(Agent &, cell_t);
+    /// Takes a dead snake off the board.
+    void remove(Agent &);
+    /// Puts a food on a cell.
+    void add_food(cell_t);
+    /// Takes an eaten food off the list and repairs the distances that relied on it.
+    void remove_food(cell_t);
+    /// Lowers the distances of the neighbors of the queued cells until nothing changes.
+    void relax(std::vector<cell_t> &);
+
+    std::shared_ptr<const Layout> m_layout; //!< Walls shared with the levels.
+    size_t m_rows = 0;                      //!< The number of rows in the maze.
+    size_t m_cols = 0;                      //!< The number of cols in the maze.
+    std::vector<Cell::cell_e> m_cells;      //!< Type of each cell, row by row.
+    std::vector<Agent> m_agents;            //!< The snakes, in the order moves are applied.
+    std::vector<cell_t> m_foods;            //!< Cells holding a food.
+    std::vector<uint32_t> m_food_slot;      //!< Index in the foods of the food on each cell.
+    std::vector<dist_t> m_field;            //!< Distance from each cell to the nearest food, around the walls.
+    std::vector<uint8_t> m_claims;          //!< Snakes moving into each cell in the current tick.
+    std::vector<cell_t> m_targets;          //!< Cell each snake moves into in the current tick.
+    Rng m_rng;                              //!< Generator of the food and spawn positions.
+    uint64_t m_ticks = 0;                   //!< Ticks run so far.
+
+    std::shared_ptr<ThreadPool> m_pool;     //!< Pool choosing the moves, if parallel.
+    std::vector<Scratch> m_scratch;         //!< One set of search buffers per thread.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file binary_io.h
+ *
+ * @description
+ * Helpers for the binary files of the game (replays, checkpoints). Most
+ * numbers are small, so they are written as LEB128 varints: seven bits
+ * per byte, low bits first, the high bit set on every byte but the last.
+ * Signed deltas are zigzag-encoded first so small negative numbers stay
+ * short. Fixed-width numbers are little-endian.
+ */
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace snaze {
+namespace binary {
+
+/// Appends a varint to a buffer.
+inline void put_varint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/// Reads a varint from a buffer at an offset, moving the offset past it; false if it is cut short.
+inline bool get_varint(const std::string &in, size_t &offset, uint64_t &value)
+{
+    value = 0;
+    for (unsigned shift = 0; offset < in.size() and shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(in[offset++]);
+        value |= uint64_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/// Writes a varint to a stream.
+inline void write_varint(std::ostream &out, uint64_t value)
+{
+    std::string bytes;
+    put_varint(bytes, value);
+    out.write(bytes.data(), bytes.size());
+}
+
+/// Reads a varint from a stream; false if it is cut short.
+inline bool read_varint(std::istream &in, uint64_t &value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == std::istream::traits_type::eof())
+            return false;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/// Maps a signed number to an unsigned one, small magnitudes to small values.
+constexpr uint64_t zigzag(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+/// Undoes `zigzag()`.
+constexpr int64_t unzigzag(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+/// Writes a little-endian 64-bit number to a stream.
+inline void write_u64(std::ostream &out, uint64_t value)
+{
+    char bytes[8];
+    for (int i = 0; i < 8; ++i)
+        bytes[i] = static_cast<char>(value >> (8 * i));
+    out.write(bytes, 8);
+}
+
+/// Reads a little-endian 64-bit number from a buffer at an offset.
+inline uint64_t get_u64(const std::string &in, size_t offset)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+        value |= uint64_t(static_cast<uint8_t>(in[offset + i])) << (8 * i);
+    return value;
+}
+
+} // NAMESPACE BINARY
+} // NAMESPACE SNAZE
+
+#endif
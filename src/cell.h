@@ -8,7 +8,7 @@
 #ifndef CELL_H
 #define CELL_H
 
-#include "snake.h"
+#include <cstdint>
 
 namespace snaze {
 
@@ -17,7 +17,7 @@ public:
     //== Enums
 
     /// Identification of each cell in the maze.
-    enum class cell_e {
+    enum class cell_e : uint8_t {
         WALL = 0,           //!< The maze wall.
         INV_WALL,           //!< A invisible wall.
         FREE,               //!< A free passage through the maze.
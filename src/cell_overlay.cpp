@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <vector>
+
+#include "cell_overlay.h"
+#include "cell.h"
+
+namespace snaze {
+
+/**
+ * @brief Creates an overlay that reads every cell from the base.
+ *
+ * @param base The cells the overlay starts from, stored row by row.
+ */
+CellOverlay::CellOverlay(const std::vector<Cell> &base)
+    : m_base(base.data()), m_size(base.size()), m_chunks((base.size() + CHUNK - 1) / CHUNK),
+      m_owned(m_chunks.size())
+{
+    link();
+}
+
+/**
+ * @brief Copies an overlay.
+ *
+ * The copy owns its own chunks, so a write on one of the two never shows
+ * in the other.
+ *
+ * @param other The overlay to copy.
+ */
+CellOverlay::CellOverlay(const CellOverlay &other)
+    : m_base(other.m_base), m_size(other.m_size), m_chunks(other.m_chunks.size()),
+      m_owned(other.m_owned), m_copied(other.m_copied)
+{
+    link();
+}
+
+/**
+ * @brief Copies an overlay into this one.
+ *
+ * @param other The overlay to copy.
+ * @return This overlay.
+ */
+CellOverlay &CellOverlay::operator=(const CellOverlay &other)
+{
+    if (this != &other) {
+        m_base = other.m_base;
+        m_size = other.m_size;
+        m_chunks.resize(other.m_chunks.size());
+        m_owned = other.m_owned;
+        m_copied = other.m_copied;
+        link();
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Returns a cell for writing.
+ *
+ * The first write to a chunk copies it from the base, so the base is
+ * never written and other overlays on it see no change.
+ *
+ * @param id The linear index of the cell.
+ * @return A reference to the cell, owned by the overlay.
+ */
+Cell &CellOverlay::write(size_t id)
+{
+    const size_t chunk = id >> CHUNK_BITS;
+    std::vector<Cell> &owned = m_owned[chunk];
+
+    if (owned.empty()) {
+        const size_t first = chunk * CHUNK;
+        owned.assign(m_base + first, m_base + std::min(first + CHUNK, m_size));
+        m_chunks[chunk] = owned.data();
+        m_copied.push_back(chunk);
+    }
+
+    return owned[id & (CHUNK - 1)];
+}
+
+/**
+ * @brief Drops the copied chunks, reading every cell from the base again.
+ *
+ * Only the copied chunks are visited, so the cost is that of the cells
+ * the level changed, not of the maze.
+ */
+void CellOverlay::reset()
+{
+    for (size_t chunk : m_copied) {
+        m_owned[chunk] = {};
+        m_chunks[chunk] = m_base + chunk * CHUNK;
+    }
+    m_copied.clear();
+}
+
+/**
+ * @brief Points the table at the owned chunks and at the base for the others.
+ */
+void CellOverlay::link()
+{
+    for (size_t chunk = 0; chunk < m_chunks.size(); ++chunk)
+        m_chunks[chunk] = m_owned[chunk].empty() ? m_base + chunk * CHUNK : m_owned[chunk].data();
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,71 @@
+/**
+ * @file cell_overlay.h
+ *
+ * @description
+ * This class holds the cells of a level on top of the cells of its layout.
+ * The cells are split into chunks of a fixed size, and a table points each
+ * chunk either at the layout or at a copy owned by the overlay. A chunk is
+ * copied the first time one of its cells is written, so a game only pays
+ * for the chunks its snake and food went through, and a copy of a level
+ * only copies the chunks it owns.
+ */
+
+#ifndef CELL_OVERLAY_H
+#define CELL_OVERLAY_H
+
+#include <cstddef>
+#include <vector>
+
+#include "cell.h"
+
+namespace snaze {
+
+class CellOverlay {
+public:
+    /// Cells of a chunk, as a power of two.
+    static constexpr size_t CHUNK_BITS = 8;
+    /// Number of cells in a chunk.
+    static constexpr size_t CHUNK = size_t(1) << CHUNK_BITS;
+
+    /// Default constructor.
+    CellOverlay() = default;
+    /// Creates an overlay that reads every cell from the base, which must outlive it.
+    explicit CellOverlay(const std::vector<Cell> &);
+    /// Copies the owned chunks and points the table at the copies.
+    CellOverlay(const CellOverlay &);
+    /// Copies the owned chunks and points the table at the copies.
+    CellOverlay &operator=(const CellOverlay &);
+    /// Moves the owned chunks, whose storage keeps its address.
+    CellOverlay(CellOverlay &&) = default;
+    /// Moves the owned chunks, whose storage keeps its address.
+    CellOverlay &operator=(CellOverlay &&) = default;
+    /// Destructor.
+    ~CellOverlay() = default;
+
+    /// Returns the cell at a linear index.
+    const Cell &operator[](size_t id) const { return m_chunks[id >> CHUNK_BITS][id & (CHUNK - 1)]; }
+    /// Returns the cell at a linear index for writing, copying its chunk first if needed.
+    Cell &write(size_t id);
+    /// Returns the table of chunks, which keeps its address until the overlay is reassigned.
+    const Cell *const *chunks() const { return m_chunks.data(); }
+    /// Returns the indices of the copied chunks, in the order they were copied.
+    const std::vector<size_t> &copied() const { return m_copied; }
+    /// Checks whether any chunk was copied since the overlay was created or reset.
+    bool modified() const { return not m_copied.empty(); }
+    /// Drops the copied chunks, reading every cell from the base again.
+    void reset();
+
+private:
+    /// Points the table at the owned chunks and at the base for the others.
+    void link();
+
+    const Cell *m_base = nullptr;               //!< First cell of the base.
+    size_t m_size = 0;                          //!< The number of cells.
+    std::vector<const Cell *> m_chunks;         //!< First cell of each chunk, in the base or owned.
+    std::vector<std::vector<Cell>> m_owned;     //!< Copied chunks; empty for those read from the base.
+    std::vector<size_t> m_copied;               //!< Indices of the copied chunks.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
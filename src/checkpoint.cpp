@@ -0,0 +1,186 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "binary_io.h"
+
+namespace snaze {
+
+namespace {
+
+constexpr char MAGIC[4] = { 'S', 'N', 'Z', 'C' };   //!< First bytes of a checkpoint file.
+constexpr uint64_t VERSION = 1;                     //!< Version of the format.
+
+/**
+ * @brief Writes bytes into a file and flushes them to the disk.
+ *
+ * @param path The file, created or truncated.
+ * @param bytes The bytes to write.
+ * @return true if every byte reached the disk, false otherwise.
+ */
+bool write_synced(const std::string &path, const std::string &bytes)
+{
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+
+    bool written = true;
+    for (size_t done = 0; written and done < bytes.size();) {
+        const ssize_t count = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (count >= 0)
+            done += count;
+        else if (errno != EINTR)
+            written = false;
+    }
+
+    // Without the sync, a crash after the rename may leave an empty checkpoint.
+    written = written and ::fsync(fd) == 0;
+    return ::close(fd) == 0 and written;
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Returns the bytes of a checkpoint file.
+ *
+ * The file is the magic number and version, the header of the run as a
+ * replay stores it, the moves and searches, then the length and bytes of
+ * the snapshot of the game.
+ *
+ * @return The bytes of the file.
+ */
+std::string Checkpoint::encode() const
+{
+    std::string bytes(MAGIC, sizeof(MAGIC));
+    binary::put_varint(bytes, VERSION);
+    Replay::save(header, bytes);
+    binary::put_varint(bytes, moves);
+    binary::put_varint(bytes, searches);
+    binary::put_varint(bytes, game.size());
+    bytes += game;
+
+    return bytes;
+}
+
+/**
+ * @brief Reads a checkpoint file.
+ *
+ * @param path The path of the file.
+ * @return true if the file is a whole checkpoint, false otherwise.
+ */
+bool Checkpoint::read(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (not in.is_open())
+        return false;
+    std::string data(std::istreambuf_iterator<char>(in), {});
+
+    if (data.size() < sizeof(MAGIC) or std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+
+    size_t offset = sizeof(MAGIC);
+    uint64_t version, length;
+    if (not binary::get_varint(data, offset, version) or version != VERSION
+            or not Replay::load(data, offset, header)
+            or not binary::get_varint(data, offset, moves)
+            or not binary::get_varint(data, offset, searches)
+            or not binary::get_varint(data, offset, length)
+            or length != data.size() - offset)
+        return false;
+
+    game = data.substr(offset);
+    return true;
+}
+
+/**
+ * @brief Starts the worker writing checkpoints into a file.
+ *
+ * @param path The checkpoint file, replaced at each write.
+ */
+void CheckpointWriter::open(const std::string &path)
+{
+    close();
+
+    m_path = path;
+    m_has_pending = false;
+    m_stop = false;
+    m_good = true;
+    m_worker = std::thread(&CheckpointWriter::run, this);
+}
+
+/**
+ * @brief Hands a checkpoint to the worker.
+ *
+ * A checkpoint the worker did not start writing yet is replaced, only the
+ * newest one matters.
+ *
+ * @param bytes The bytes of the checkpoint file.
+ */
+void CheckpointWriter::write(std::string bytes)
+{
+    if (not is_open())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = std::move(bytes);
+        m_has_pending = true;
+    }
+    m_ready.notify_one();
+}
+
+/**
+ * @brief Writes the pending checkpoint and stops the worker.
+ */
+void CheckpointWriter::close()
+{
+    if (not is_open())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_ready.notify_one();
+    m_worker.join();
+}
+
+/**
+ * @brief Writes checkpoints as they are handed over, until closed.
+ *
+ * Each one is written to a temporary file next to the checkpoint and
+ * synced to the disk, then renamed over it.
+ */
+void CheckpointWriter::run()
+{
+    const std::string temporary = m_path + ".tmp";
+    std::string bytes;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ready.wait(lock, [this] { return m_has_pending or m_stop; });
+            if (not m_has_pending)
+                return;
+            bytes.swap(m_pending);
+            m_has_pending = false;
+        }
+
+        const bool written = write_synced(temporary, bytes)
+                         and std::rename(temporary.c_str(), m_path.c_str()) == 0;
+        if (not written) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_good = false;
+        }
+    }
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,82 @@
+/**
+ * @file checkpoint.h
+ *
+ * @description
+ * Checkpoints of long runs, so a run that was stopped can go on where it
+ * was. A checkpoint is taken at the start of a match, when the player has
+ * no plan yet, and holds the options of the run, its progress (moves
+ * played, searches run by the MCTS player, whose playouts are seeded from
+ * that count) and a snapshot of the game: level index, score, foods,
+ * lives, snake, foods on the board, generator and changed cells.
+ *
+ * Files are written by a worker thread, so the game only pays for the
+ * snapshot, a few bytes per snake cell. The worker writes the newest
+ * checkpoint it was handed, dropping older ones it did not get to, into
+ * a temporary file, synced to the disk before it replaces the checkpoint
+ * in one rename, so a run killed while writing, or a machine crashing
+ * after it, still leaves a whole checkpoint.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "replay.h"
+
+namespace snaze {
+
+class Checkpoint {
+public:
+    Replay::Header header;  //!< The options of the run.
+    uint64_t moves = 0;     //!< Moves played before the checkpoint.
+    uint64_t searches = 0;  //!< Searches run by the MCTS player.
+    std::string game;       //!< Snapshot of the game, as the frontend saves it.
+
+    /// Returns the bytes of a checkpoint file.
+    std::string encode() const;
+    /// Reads a checkpoint file; false if it is missing or invalid.
+    bool read(const std::string &path);
+};
+
+class CheckpointWriter {
+public:
+    /// Default constructor.
+    CheckpointWriter() = default;
+    /// Writes the pending checkpoint and stops the worker.
+    ~CheckpointWriter() { close(); }
+    CheckpointWriter(const CheckpointWriter &) = delete;
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+    /// Starts the worker writing checkpoints into a file.
+    void open(const std::string &path);
+    /// Returns whether checkpoints are written.
+    bool is_open() const { return m_worker.joinable(); }
+    /// Hands the bytes of a checkpoint to the worker and returns at once.
+    void write(std::string bytes);
+    /// Writes the pending checkpoint and stops the worker.
+    void close();
+    /// Returns whether every write so far succeeded.
+    bool good() const { std::lock_guard<std::mutex> lock(m_mutex); return m_good; }
+
+private:
+    /// Writes checkpoints as they are handed over, until closed.
+    void run();
+
+    std::string m_path;                 //!< The checkpoint file.
+    std::thread m_worker;               //!< Thread writing the files.
+    mutable std::mutex m_mutex;         //!< Guards everything below.
+    std::condition_variable m_ready;    //!< Signals a new checkpoint or the end.
+    std::string m_pending;              //!< Bytes of the newest checkpoint not written yet.
+    bool m_has_pending = false;         //!< Whether `m_pending` holds a checkpoint.
+    bool m_stop = false;                //!< Whether the worker must stop once idle.
+    bool m_good = true;                 //!< Whether every write so far succeeded.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -6,6 +6,7 @@
 
 #include "cmd_parse.h"
 #include "common.h"
+#include "thread_pool.h"
 
 namespace fs = std::filesystem;
 
@@ -22,7 +23,20 @@ void usage()
     std::cout << "     --fps <num>           Number of frames (board) presented per second.\n";
     std::cout << "     --lives <num>         Number of lives the snake shall have. Default = 5.\n";
     std::cout << "     --food <num>          Number of food pellets for the entire simulation. Default = 10.\n";
-    std::cout << "     --playertype <type>   Type of snake intelligence: random, backtracking. Default = backtracking.\n";
+    std::cout << "     --board <num>         Number of food pellets on the board at once. Default = 1.\n";
+    std::cout << "     --playertype <type>   Type of snake intelligence: random, backtracking, timed, hamiltonian, gradient, jps, hpa, incremental, mcts. Default = backtracking.\n";
+    std::cout << "     --heatmap             Draw the distance field of the gradient player under the maze.\n";
+    std::cout << "     --seed <num>          Seed of the food placement, to replay a run. Default = random.\n";
+    std::cout << "     --threads <num>       Threads of the mcts player and of the searches on large mazes. Default = every hardware thread.\n";
+    std::cout << "     --rollouts <num>      Playouts per move of the mcts player, for deterministic runs. Default = until the frame deadline.\n";
+    std::cout << "     --record <file>       Record the run into a replay file.\n";
+    std::cout << "     --replay <file>       Play a recorded run of the same level file instead of the player.\n";
+    std::cout << "     --seek <num>          Start drawing a replay at this move, jumping to the keyframe before it.\n";
+    std::cout << "     --headless            Draw only the final result, without waiting between frames.\n";
+    std::cout << "     --checkpoint <file>   Save the state of the run into this file every few seconds.\n";
+    std::cout << "     --resume              Go on with the run saved in the --checkpoint file.\n";
+    std::cout << "     --metrics <file>      Export the metrics every few seconds, as Prometheus text if the file ends in .prom or .txt, JSON otherwise.\n";
+    std::cout << "     --trace <file>        Trace the game loop into a Chrome trace file, for chrome://tracing or Perfetto.\n";
 }
 
 /**
@@ -134,6 +148,23 @@ optional<RunningOpt> parse_cmd(int argc, char* argv[])
                 return nullopt;
             }
         }
+        else if (!strcmp(argv[arg], "--board")) {
+            if (arg + 1 < argc) {
+                auto board = try_parse_int(argv[arg + 1], show_error);
+
+                if (board.has_value() and board.value() > 0)
+                    runOpt.board = board.value();
+                else {
+                    if (board.has_value())
+                        show_error("--board needs at least one food.");
+                    return nullopt;
+                }
+            }
+            else {
+                show_error("Missing arguments for --board.");
+                return nullopt;
+            }
+        }
         else if (!strcmp(argv[arg], "--playertype")) {
             if (arg + 1 < argc) {
                 if (!strcmp(argv[arg + 1], "backtracking")) {
@@ -142,6 +173,27 @@ optional<RunningOpt> parse_cmd(int argc, char* argv[])
                 else if (!strcmp(argv[arg + 1], "random")) {
                     runOpt.player_type = player_e::RANDOM;
                 }
+                else if (!strcmp(argv[arg + 1], "timed")) {
+                    runOpt.player_type = player_e::TIMED;
+                }
+                else if (!strcmp(argv[arg + 1], "hamiltonian")) {
+                    runOpt.player_type = player_e::HAMILTONIAN;
+                }
+                else if (!strcmp(argv[arg + 1], "gradient")) {
+                    runOpt.player_type = player_e::GRADIENT;
+                }
+                else if (!strcmp(argv[arg + 1], "jps")) {
+                    runOpt.player_type = player_e::JUMP_POINT;
+                }
+                else if (!strcmp(argv[arg + 1], "hpa")) {
+                    runOpt.player_type = player_e::HIERARCHICAL;
+                }
+                else if (!strcmp(argv[arg + 1], "incremental")) {
+                    runOpt.player_type = player_e::INCREMENTAL;
+                }
+                else if (!strcmp(argv[arg + 1], "mcts")) {
+                    runOpt.player_type = player_e::MCTS;
+                }
                 else {
                     show_error("\'" + std::string(argv[arg+1]) + "\' is not a valid argument.");
                     return nullopt;
@@ -152,6 +204,129 @@ optional<RunningOpt> parse_cmd(int argc, char* argv[])
                 return nullopt;
             }
         }
+        else if (!strcmp(argv[arg], "--heatmap")) {
+            runOpt.heatmap = true;
+        }
+        else if (!strcmp(argv[arg], "--seed")) {
+            if (arg + 1 < argc) {
+                auto seed = try_parse_int(argv[arg + 1], show_error);
+
+                if (seed.has_value())
+                    runOpt.seed = seed.value();
+                else
+                    return nullopt;
+            }
+            else {
+                show_error("Missing arguments for --seed.");
+                return nullopt;
+            }
+        }
+        else if (!strcmp(argv[arg], "--threads")) {
+            if (arg + 1 < argc) {
+                auto threads = try_parse_int(argv[arg + 1], show_error);
+
+                if (threads.has_value() and threads.value() <= snaze::ThreadPool::MAX_THREADS)
+                    runOpt.threads = threads.value();
+                else {
+                    if (threads.has_value())
+                        show_error("--threads takes at most " + std::to_string(snaze::ThreadPool::MAX_THREADS) + " threads.");
+                    return nullopt;
+                }
+            }
+            else {
+                show_error("Missing arguments for --threads.");
+                return nullopt;
+            }
+        }
+        else if (!strcmp(argv[arg], "--record")) {
+            if (arg + 1 < argc) {
+                // Skip the path, which may name an existing file that is not a level.
+                runOpt.record_path = argv[++arg];
+            }
+            else {
+                show_error("Missing arguments for --record.");
+                return nullopt;
+            }
+        }
+        else if (!strcmp(argv[arg], "--replay")) {
+            if (arg + 1 < argc) {
+                // Skip the path, which names an existing file that is not a level.
+                runOpt.replay_path = argv[++arg];
+            }
+            else {
+                show_error("Missing arguments for --replay.");
+                return nullopt;
+            }
+        }
+        else if (!strcmp(argv[arg], "--seek")) {
+            if (arg + 1 < argc) {
+                auto seek = try_parse_int(argv[arg + 1], show_error);
+
+                if (seek.has_value())
+                    runOpt.seek = seek.value();
+                else
+                    return nullopt;
+            }
+            else {
+                show_error("Missing arguments for --seek.");
+                return nullopt;
+            }
+        }
+        else if (!strcmp(argv[arg], "--headless")) {
+            runOpt.headless = true;
+        }
+        else if (!strcmp(argv[arg], "--checkpoint")) {
+            if (arg + 1 < argc) {
+                // Skip the path, which may name an existing file that is not a level.
+                runOpt.checkpoint_path = argv[++arg];
+            }
+            else {
+                show_error("Missing arguments for --checkpoint.");
+                return nullopt;
+            }
+        }
+        else if (!strcmp(argv[arg], "--resume")) {
+            runOpt.resume = true;
+        }
+        else if (!strcmp(argv[arg], "--metrics")) {
+            if (arg + 1 < argc) {
+                // Skip the path, which may name an existing file that is not a level.
+                runOpt.metrics_path = argv[++arg];
+            }
+            else {
+                show_error("Missing arguments for --metrics.");
+                return nullopt;
+            }
+        }
+        else if (!strcmp(argv[arg], "--trace")) {
+            if (arg + 1 < argc) {
+                // Skip the path, which may name an existing file that is not a level.
+                runOpt.trace_path = argv[++arg];
+            }
+            else {
+                show_error("Missing arguments for --trace.");
+                return nullopt;
+            }
+        }
+        else if (!strcmp(argv[arg], "--rollouts")) {
+            if (arg + 1 < argc) {
+                auto rollouts = try_parse_int(argv[arg + 1], show_error);
+
+                if (rollouts.has_value())
+                    runOpt.rollouts = rollouts.value();
+                else
+                    return nullopt;
+            }
+            else {
+                show_error("Missing arguments for --rollouts.");
+                return nullopt;
+            }
+        }
+    }
+
+    if (runOpt.resume and runOpt.checkpoint_path.empty()) {
+        show_error("--resume needs the file given to --checkpoint.");
+        return nullopt;
     }
 
     return runOpt;
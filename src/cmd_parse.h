@@ -21,7 +21,7 @@ using std::string;
 using std::set;
 
 // Set of recognized command line flags.
-static const set<string> flags { "--fps", "--lives", "--food", "--playertype" };
+static const set<string> flags { "--fps", "--lives", "--food", "--board", "--playertype", "--heatmap", "--seed", "--threads", "--rollouts", "--record", "--replay", "--seek", "--headless", "--checkpoint", "--resume", "--metrics", "--trace" };
 
 /// Prints usage information for the snaze game simulation.
 void usage();
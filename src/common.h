@@ -2,6 +2,8 @@
 #define COMMON_H
 
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <sstream>
 
 namespace snaze {
@@ -9,9 +11,9 @@ namespace snaze {
 struct Position {
     size_t row, col;
 
-    Position(size_t r = 0, size_t c = 0) : row(r), col(c) { /* empty */}
+    constexpr Position(size_t r = 0, size_t c = 0) : row(r), col(c) { /* empty */}
 
-    bool operator==(const Position &other) const {
+    constexpr bool operator==(const Position &other) const {
         return row == other.row and col == other.col;
     }
 
@@ -23,6 +25,17 @@ struct Position {
     }
 };
 
+/// Linear index of a cell in a row-major maze, a quarter of the size of a Position.
+using cell_t = uint32_t;
+
+/// Index that refers to no cell.
+constexpr cell_t NO_CELL = std::numeric_limits<cell_t>::max();
+
+/// Returns the linear index of a position in a maze with the given number of cols.
+constexpr cell_t to_cell(const Position &pos, size_t cols) { return static_cast<cell_t>(pos.row * cols + pos.col); }
+/// Returns the position of a linear index in a maze with the given number of cols.
+constexpr Position to_position(cell_t cell, size_t cols) { return Position(cell / cols, cell % cols); }
+
 enum dir_e { UP = 0, LEFT, DOWN, RIGHT };
 
 } //NAMESPACE SNAZE
@@ -30,6 +43,13 @@ enum dir_e { UP = 0, LEFT, DOWN, RIGHT };
 enum player_e {
     RANDOM = 0,
     BACKTRACKING,
+    TIMED,          //!< BFS that models the tail vacating cells as the snake moves.
+    HAMILTONIAN,    //!< Follows a Hamiltonian cycle precomputed for the level.
+    GRADIENT,       //!< Descends a distance field rooted at the food.
+    JUMP_POINT,     //!< Jump Point Search for large open arenas.
+    HIERARCHICAL,   //!< Hierarchical search over clusters for very large mazes.
+    INCREMENTAL,    //!< D* Lite, repairing the search as the snake moves.
+    MCTS,           //!< Monte Carlo Tree Search with random playouts.
 };
 
 struct RunningOpt {
@@ -37,7 +57,20 @@ struct RunningOpt {
     unsigned fps = 2;       //!< Default fps value.
     unsigned lives = 5;     //!< Default # of lives the snake shall have.
     unsigned foods = 10;    //!< Default # of food pellets for the entire simulation.
+    unsigned board = 1;     //!< Food pellets on the board at once.
     player_e player_type = player_e::BACKTRACKING; //!< Default player type.
+    bool heatmap = false;   //!< Whether the distance field is drawn under the maze.
+    unsigned seed = 0;      //!< Seed of the food placement; 0 draws a random one.
+    unsigned threads = 0;   //!< Threads of the parallel players; 0 uses every hardware thread.
+    unsigned rollouts = 0;  //!< Playouts per move of the MCTS player; 0 searches until the frame deadline.
+    std::string record_path;    //!< File to record the run into; empty records nothing.
+    std::string replay_path;    //!< File of a recorded run to play instead of the player; empty plays live.
+    unsigned seek = 0;          //!< Move of the replay to start drawing from.
+    bool headless = false;      //!< Whether only the final result is drawn, without waiting between frames.
+    std::string checkpoint_path; //!< File the state of the run is saved into; empty saves nothing.
+    bool resume = false;        //!< Whether the run goes on from the checkpoint file.
+    std::string metrics_path;   //!< File the metrics are exported into; empty exports nothing.
+    std::string trace_path;     //!< File the game loop is traced into; empty traces nothing.
 };
 
 #endif
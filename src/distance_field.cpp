@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <array>
+#include <queue>
+#include <vector>
+
+#include "distance_field.h"
+#include "cell.h"
+#include "common.h"
+#include "grid_view.h"
+#include "level.h"
+
+namespace snaze {
+
+/**
+ * @brief Computes the distance from every cell of the level to the target.
+ *
+ * @param level The maze the distances are computed on.
+ * @param target The cell every distance refers to, usually the food.
+ */
+DistanceField::DistanceField(const Level &level, const Position &target)
+    : DistanceField(level, std::vector<Position> { target })
+{
+    /* empty */
+}
+
+/**
+ * @brief Computes the distance from every cell of the level to the nearest target.
+ *
+ * Runs a single BFS rooted at every target at once. Walls and snake
+ * segments are blocked; the snake head is left blocked too, since the
+ * snake only reads the distances of its neighbors.
+ *
+ * @param level The maze the distances are computed on.
+ * @param targets The cells distances refer to, usually the foods.
+ */
+DistanceField::DistanceField(const Level &level, const std::vector<Position> &targets)
+    : m_rows(level.rows()), m_cols(level.cols()), m_target(targets.empty() ? Position() : targets.front()),
+      m_dist(m_rows * m_cols, INF), m_blocked(m_rows * m_cols, true)
+{
+    GridView grid = level.view();
+    for (cell_t cell = 0; cell < m_blocked.size(); ++cell)
+        m_blocked[cell] = not grid.open(cell);
+
+    std::queue<cell_t> queue;
+    for (const Position &target : targets) {
+        m_blocked[id(target)] = false;
+        m_dist[id(target)] = 0;
+        queue.push(id(target));
+    }
+
+    relax(queue);
+}
+
+/**
+ * @brief Returns the direction of the free neighbor closest to the target.
+ *
+ * Only four cells are read, so following the gradient costs O(1) per move.
+ *
+ * @param pos The current position of the snake head.
+ * @return The direction to move, or nullopt if no free neighbor reaches the target.
+ */
+std::optional<dir_e> DistanceField::descend(const Position &pos) const
+{
+    std::optional<dir_e> best;
+    dist_t best_dist = INF;
+
+    for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+        Position next = pos;
+        switch (dir) {
+            case UP:    next.row -= 1; break;
+            case DOWN:  next.row += 1; break;
+            case LEFT:  next.col -= 1; break;
+            case RIGHT: next.col += 1; break;
+        }
+
+        // Positions outside the maze wrap around to huge indices.
+        if (next.row >= m_rows or next.col >= m_cols or m_blocked[id(next)])
+            continue;
+
+        if (m_dist[id(next)] < best_dist) {
+            best_dist = m_dist[id(next)];
+            best = dir;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Marks a cell as occupied by the snake.
+ *
+ * Distances that relied on this cell are not raised: they belong to cells the
+ * snake has already passed, which are never closer to the target than the head.
+ *
+ * @param pos The cell entered by the snake.
+ */
+void DistanceField::occupy(const Position &pos)
+{
+    m_blocked[id(pos)] = true;
+    m_dist[id(pos)] = INF;
+}
+
+/**
+ * @brief Marks a cell as free and propagates the shorter distances it opens.
+ *
+ * The released cell takes the best distance among its neighbors, and any
+ * improvement is pushed outwards. Only the cells whose distance drops are
+ * visited.
+ *
+ * @param pos The cell left by the snake tail.
+ */
+void DistanceField::release(const Position &pos)
+{
+    cell_t cell = id(pos);
+    m_blocked[cell] = false;
+
+    for (cell_t next : neighbors(cell)) {
+        if (not m_blocked[next] and m_dist[next] != INF)
+            m_dist[cell] = std::min(m_dist[cell], m_dist[next] + 1);
+    }
+
+    if (m_dist[cell] == INF)
+        return;
+
+    std::queue<cell_t> queue;
+    queue.push(cell);
+    relax(queue);
+}
+
+/**
+ * @brief Lowers the distances of the neighbors of the queued cells.
+ *
+ * With unit edge costs this is a plain BFS wave: a neighbor is updated and
+ * queued whenever going through the current cell is shorter.
+ *
+ * @param queue The cells whose distance has just been lowered.
+ */
+void DistanceField::relax(std::queue<cell_t> &queue)
+{
+    while (not queue.empty()) {
+        cell_t cell = queue.front();
+        queue.pop();
+
+        for (cell_t next : neighbors(cell)) {
+            if (not m_blocked[next] and m_dist[next] > m_dist[cell] + 1) {
+                m_dist[next] = m_dist[cell] + 1;
+                queue.push(next);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns the linear indices of the four neighbors of a cell.
+ *
+ * Neighbors outside the maze are replaced by the cell itself, which never
+ * improves any distance.
+ *
+ * @param cell The linear index of the cell.
+ * @return The indices of the cells above, below, left and right.
+ */
+std::array<cell_t, 4> DistanceField::neighbors(cell_t cell) const
+{
+    const cell_t cols = m_cols;
+    size_t r = cell / cols, c = cell % cols;
+
+    return {
+        r > 0 ? cell - cols : cell,
+        r + 1 < m_rows ? cell + cols : cell,
+        c > 0 ? cell - 1 : cell,
+        c + 1 < m_cols ? cell + 1 : cell,
+    };
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,76 @@
+/**
+ * @file distance_field.h
+ *
+ * @description
+ * This class represents the distance from every cell of the maze to the
+ * nearest of its targets (the foods). It is computed once with a reverse BFS and
+ * then kept up to date as the snake body leaves cells, so the snake can
+ * reach the target by descending the gradient without storing a path.
+ */
+
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <vector>
+
+#include "common.h"
+#include "level.h"
+
+namespace snaze {
+
+class DistanceField {
+public:
+    //== Aliases
+    using dist_t = uint32_t;
+
+    /// Distance of a cell that cannot reach the target.
+    static constexpr dist_t INF = std::numeric_limits<dist_t>::max();
+
+    /// Default constructor.
+    DistanceField() = default;
+    /// Computes the distance from every cell of the level to the target.
+    DistanceField(const Level &, const Position &);
+    /// Computes the distance from every cell of the level to the nearest target.
+    DistanceField(const Level &, const std::vector<Position> &);
+    /// Destructor.
+    ~DistanceField() = default;
+
+    /// Returns the number of rows in the field.
+    size_t rows() const { return m_rows; }
+    /// Returns the number of cols in the field.
+    size_t cols() const { return m_cols; }
+    /// Returns the target position of the field, the first one if there are several.
+    Position target() const { return m_target; }
+    /// Returns the distance from a position to the target.
+    dist_t at(const Position &pos) const { return m_dist[id(pos)]; }
+    /// Returns the direction of the free neighbor closest to the target.
+    std::optional<dir_e> descend(const Position &) const;
+
+    /// Marks a cell as occupied by the snake.
+    void occupy(const Position &);
+    /// Marks a cell as free and propagates the shorter distances it opens.
+    void release(const Position &);
+
+private:
+    /// Returns the linear index of a position.
+    cell_t id(const Position &pos) const { return to_cell(pos, m_cols); }
+    /// Returns the linear indices of the four neighbors of a cell.
+    std::array<cell_t, 4> neighbors(cell_t) const;
+    /// Lowers the distances of the neighbors of the queued cells until nothing changes.
+    void relax(std::queue<cell_t> &);
+
+    size_t m_rows = 0;              //!< The number of rows in the maze.
+    size_t m_cols = 0;              //!< The number of cols in the maze.
+    Position m_target;              //!< The cell every distance refers to.
+    std::vector<dist_t> m_dist;     //!< Distance from each cell to the target.
+    std::vector<bool> m_blocked;    //!< Cells the snake cannot enter (walls and body).
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file draw_cell.h
+ *
+ * @description
+ * The draw every game of the simulation uses to place its foods, and the
+ * arena to place its snakes. Cells are drawn at random, a row and then a
+ * col, until one passes the caller's test; cells of the first row and col
+ * are never taken, like `Level::is_blocked()` rules. The draw takes O(1)
+ * tries while a fair share of the maze passes; after many misses, the maze
+ * is scanned once to stop if no cell passes at all. Levels, game states,
+ * vectorized games and arenas seeded alike therefore draw the same cells.
+ */
+
+#ifndef DRAW_CELL_H
+#define DRAW_CELL_H
+
+#include <cstddef>
+
+#include "common.h"
+#include "rng.h"
+
+namespace snaze {
+
+/// Draws a random cell off the first row and col that passes a test; NO_CELL if none does.
+template <typename Test>
+cell_t draw_cell(Rng &rng, size_t rows, size_t cols, Test &&passes)
+{
+    const size_t cells = rows * cols;
+
+    for (size_t tries = 0; ; ++tries) {
+        size_t r = rng.below(rows);
+        size_t c = rng.below(cols);
+        cell_t id = r * cols + c;
+
+        if (r > 0 and c > 0 and passes(id))
+            return id;
+
+        if (tries == 4 * cells) {
+            bool any = false;
+            for (cell_t cell = cols; cell < cells and not any; ++cell)
+                any = cell % cols > 0 and passes(cell);
+            if (not any)
+                return NO_CELL;
+        }
+    }
+}
+
+} // NAMESPACE SNAZE
+
+#endif
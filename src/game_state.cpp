@@ -0,0 +1,214 @@
+#include <cstddef>
+#include <vector>
+
+#include "game_state.h"
+#include "cell.h"
+#include "common.h"
+#include "draw_cell.h"
+#include "level.h"
+
+namespace snaze {
+
+/**
+ * @brief Copies the current state of a level.
+ *
+ * Right after eating, the level repeats the head at the front of the body
+ * so the tail waits one move; here that is stored as a pending growth. The
+ * hash is computed once here and then kept up to date by every step.
+ *
+ * @param level The level to copy, with the snake and the food placed.
+ * @param lives The remaining lives.
+ * @param score The current score.
+ * @param foods The number of foods eaten so far.
+ */
+GameState::GameState(const Level &level, count_t lives, count_t score, count_t foods)
+    : m_layout(level.layout()), m_rows(level.rows()), m_cols(level.cols()),
+      m_cells(m_rows * m_cols), m_ring(m_rows * m_cols),
+      m_direction(level.snake().direction()), m_rng(level.rng()),
+      m_score(score), m_lives(lives), m_foods(foods)
+{
+    GridView grid = level.view();
+    for (cell_t id = 0; id < m_cells.size(); ++id) {
+        m_cells[id] = grid.at(id);
+        m_hash ^= zobrist::cell_key(id, m_cells[id]);
+    }
+
+    const auto &body = level.snake().body();
+    m_grow = body.size() > 1 and body.front() == body.back();
+    for (size_t i = m_grow ? 1 : 0; i < body.size(); ++i) {
+        m_hash ^= zobrist::segment_key(body[i], i + 1 < body.size() ? zobrist::link(body[i], body[i + 1], m_cols) : zobrist::HEAD);
+        m_ring[m_length++] = body[i];
+    }
+    m_hash ^= m_grow ? zobrist::GROW : 0;
+
+    m_food = m_cells[to_cell(level.food(), m_cols)] == Cell::cell_e::FOOD ? to_cell(level.food(), m_cols) : NO_CELL;
+}
+
+/**
+ * @brief Moves the snake one cell in a direction.
+ *
+ * @param dir The direction of the move.
+ * @return Whether the snake moved, ate or died.
+ */
+GameState::outcome_e GameState::step(dir_e dir)
+{
+    Undo undo { m_rng.state(), m_hash, tail(), m_food, m_score, m_lives, m_direction, outcome_e::MOVED, m_grow, m_dead };
+
+    cell_t from = head();
+    cell_t next = neighbor(from, dir);
+    m_direction = dir;
+
+    // The tail leaves its cell on this move unless the snake is growing, as in the game.
+    bool vacated = not m_grow and m_length > 1 and next == tail();
+
+    if (m_dead or not (open(next) or vacated)) {
+        undo.outcome = outcome_e::DIED;
+
+        // Only the first death costs a life and points.
+        if (not m_dead) {
+            m_score = m_score < 20 ? 0 : m_score - 20;
+            m_lives -= m_lives > 0 ? 1 : 0;
+            m_dead = true;
+        }
+        m_log.push_back(undo);
+
+        return undo.outcome;
+    }
+
+    // Any food on the board may be eaten, not only the newest one.
+    bool ate = m_cells[next] == Cell::cell_e::FOOD;
+
+    // Only the links of the old head and the old tail change.
+    m_hash ^= zobrist::segment_key(from, zobrist::HEAD)
+            ^ zobrist::segment_key(from, zobrist::link(from, next, m_cols))
+            ^ zobrist::segment_key(next, zobrist::HEAD);
+
+    // Free the tail unless the snake is growing.
+    if (not m_grow) {
+        cell_t after = m_length > 1 ? m_ring[(m_first + 1) % m_ring.size()] : next;
+        m_hash ^= zobrist::segment_key(tail(), zobrist::link(tail(), after, m_cols));
+        put(tail(), Cell::cell_e::FREE);
+        m_first = (m_first + 1) % m_ring.size();
+        --m_length;
+    }
+
+    if (m_length > 0)
+        put(from, Cell::cell_e::SNAKE_BODY);
+    put(next, Cell::cell_e::SNAKE_HEAD);
+    m_ring[(m_first + m_length) % m_ring.size()] = next;
+    ++m_length;
+    m_hash ^= m_grow ? zobrist::GROW : 0;
+    m_grow = false;
+
+    if (ate) {
+        undo.outcome = outcome_e::ATE;
+        m_hash ^= zobrist::GROW;
+        m_grow = true;
+        m_score += 20;
+        ++m_foods;
+        m_food = draw_food();
+    }
+
+    m_log.push_back(undo);
+
+    return undo.outcome;
+}
+
+/**
+ * @brief Undoes every step taken since a snapshot.
+ *
+ * Each record restores the few cells its step changed, newest first, and
+ * the hash saved before the step.
+ *
+ * @param mark A value returned by `snapshot()`.
+ */
+void GameState::restore(mark_t mark)
+{
+    while (m_log.size() > mark) {
+        const Undo &undo = m_log.back();
+
+        if (undo.outcome != outcome_e::DIED) {
+            if (undo.outcome == outcome_e::ATE) {
+                --m_foods;
+                if (m_food != NO_CELL)
+                    m_cells[m_food] = Cell::cell_e::FREE;
+            }
+
+            // Take the head back; the old food, if eaten, reappears under it.
+            cell_t next = head();
+            m_cells[next] = undo.outcome == outcome_e::ATE ? Cell::cell_e::FOOD : Cell::cell_e::FREE;
+            --m_length;
+
+            if (not undo.grow) {
+                m_first = (m_first + m_ring.size() - 1) % m_ring.size();
+                m_ring[m_first] = undo.tail;
+                ++m_length;
+                m_cells[undo.tail] = Cell::cell_e::SNAKE_BODY;
+            }
+            m_cells[head()] = Cell::cell_e::SNAKE_HEAD;
+        }
+
+        m_rng.state(undo.rng);
+        m_hash = undo.hash;
+        m_food = undo.food;
+        m_score = undo.score;
+        m_lives = undo.lives;
+        m_direction = undo.direction;
+        m_grow = undo.grow;
+        m_dead = undo.dead;
+        m_log.pop_back();
+    }
+}
+
+/**
+ * @brief Sets the type of a cell and swaps its key in the hash.
+ *
+ * @param id The cell to change.
+ * @param type The new type of the cell.
+ */
+void GameState::put(cell_t id, Cell::cell_e type)
+{
+    m_hash ^= zobrist::cell_key(id, m_cells[id]) ^ zobrist::cell_key(id, type);
+    m_cells[id] = type;
+}
+
+/**
+ * @brief Returns the cell reached by moving from a cell.
+ *
+ * @param id The cell where the move starts.
+ * @param dir The direction of the move.
+ * @return The neighbor cell, or NO_CELL if it is outside the maze.
+ */
+cell_t GameState::neighbor(cell_t id, dir_e dir) const
+{
+    size_t r = id / m_cols, c = id % m_cols;
+
+    switch (dir) {
+        case UP:    return r > 0 ? id - m_cols : NO_CELL;
+        case DOWN:  return r + 1 < m_rows ? id + m_cols : NO_CELL;
+        case LEFT:  return c > 0 ? id - 1 : NO_CELL;
+        case RIGHT: return c + 1 < m_cols ? id + 1 : NO_CELL;
+        default:    return NO_CELL;
+    }
+}
+
+/**
+ * @brief Draws a new food on a free cell with `draw_cell()`.
+ *
+ * A level draws its foods the same way, so a state copied from a level
+ * predicts the same food the level would place.
+ *
+ * @return The cell of the new food, or NO_CELL if the maze is full.
+ */
+cell_t GameState::draw_food()
+{
+    cell_t id = draw_cell(m_rng, m_rows, m_cols, [this](cell_t cell) {
+        return m_cells[cell] == Cell::cell_e::FREE;
+    });
+    if (id != NO_CELL)
+        put(id, Cell::cell_e::FOOD);
+
+    return id;
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,151 @@
+/**
+ * @file game_state.h
+ *
+ * @description
+ * This class is a compact copy of a running game for lookahead planners.
+ * It holds one byte per cell over the shared layout, the snake in a ring
+ * buffer, the food, the counters and the generator state. Every step
+ * pushes a fixed-size record to an undo log, so a snapshot is just the
+ * size of the log and restoring it costs O(steps undone), not O(maze).
+ *
+ * The rules follow the game: the snake dies when it moves into anything
+ * but a free cell, the food or the tail cell it is leaving on the same
+ * move, eating grows it by keeping the tail in place for one move, and
+ * eating any of the foods on the board draws a new one from the same
+ * generator as `Level::add_food()`. A death ends the state until it is
+ * restored.
+ *
+ * The state also keeps a Zobrist hash, so transpositions can be found in
+ * O(1). It uses the cell and segment keys of `Level::hash()`, and equals
+ * it when no growth is pending. While one is, the level stores it as a
+ * repeated head at the tail end of the body and the state as the GROW
+ * key, so the two hashes differ; states are only compared with states.
+ */
+
+#ifndef GAME_STATE_H
+#define GAME_STATE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "cell.h"
+#include "common.h"
+#include "layout.h"
+#include "rng.h"
+#include "zobrist.h"
+
+namespace snaze {
+
+class Level;
+
+class GameState {
+public:
+    //== Aliases
+    using mark_t = size_t;
+    using count_t = unsigned;
+
+    //== Enums
+
+    /// Result of a single step.
+    enum class outcome_e : uint8_t {
+        MOVED = 0,  //!< The snake moved into a free cell.
+        ATE,        //!< The snake moved into the food and grew.
+        DIED,       //!< The snake hit a wall or itself.
+    };
+
+    /// Default constructor.
+    GameState() = default;
+    /// Copies the current state of a level.
+    GameState(const Level &, count_t lives, count_t score = 0, count_t foods = 0);
+    /// Destructor.
+    ~GameState() = default;
+
+    /// Moves the snake one cell in a direction.
+    outcome_e step(dir_e);
+    /// Returns a mark that `restore()` can roll back to.
+    mark_t snapshot() const { return m_log.size(); }
+    /// Undoes every step taken since a snapshot.
+    void restore(mark_t);
+    /// Drops the undo log, so the current state becomes the oldest one.
+    void commit() { m_log.clear(); }
+
+    /// Returns the number of rows in the maze.
+    size_t rows() const { return m_rows; }
+    /// Returns the number of cols in the maze.
+    size_t cols() const { return m_cols; }
+    /// Returns the type of a cell.
+    Cell::cell_e cell(cell_t id) const { return m_cells[id]; }
+    /// Returns the type of every cell, row by row, valid until the state changes size.
+    const Cell::cell_e *cells() const { return m_cells.data(); }
+    /// Returns the cell of the snake head.
+    cell_t head() const { return m_ring[(m_first + m_length - 1) % m_ring.size()]; }
+    /// Returns the cell of the snake tail.
+    cell_t tail() const { return m_ring[m_first]; }
+    /// Returns the number of cells taken by the snake.
+    size_t length() const { return m_length; }
+    /// Returns the direction of the last move.
+    dir_e direction() const { return m_direction; }
+    /// Returns the cell of the newest food, or NO_CELL if the maze is full.
+    cell_t food() const { return m_food; }
+    /// Returns the score.
+    count_t score() const { return m_score; }
+    /// Returns the remaining lives.
+    count_t lives() const { return m_lives; }
+    /// Returns the number of foods eaten.
+    count_t foods() const { return m_foods; }
+    /// Returns the generator of the next food.
+    const Rng &rng() const { return m_rng; }
+    /// Returns the Zobrist hash of the cells, the snake and a pending growth, as other states hash them.
+    zobrist::hash_t hash() const { return m_hash; }
+    /// Returns whether the snake died and the state must be restored.
+    bool dead() const { return m_dead; }
+    /// Returns the cell reached by moving from a cell, or NO_CELL outside the maze.
+    cell_t neighbor(cell_t, dir_e) const;
+    /// Checks whether the snake may move into a cell.
+    bool open(cell_t id) const {
+        return id != NO_CELL and (m_cells[id] == Cell::cell_e::FREE or m_cells[id] == Cell::cell_e::FOOD);
+    }
+
+private:
+    /// Everything a step changed, enough to undo it.
+    struct Undo {
+        Rng::state_t rng;       //!< Generator state before the step.
+        zobrist::hash_t hash;   //!< Hash before the step.
+        cell_t tail;            //!< Tail before the step.
+        cell_t food;            //!< Food before the step.
+        count_t score;          //!< Score before the step.
+        count_t lives;          //!< Lives before the step.
+        dir_e direction;        //!< Direction before the step.
+        outcome_e outcome;      //!< What the step did.
+        bool grow;              //!< Whether the tail was kept in place.
+        bool dead;              //!< Whether the snake was already dead.
+    };
+
+    /// Sets the type of a cell, keeping the hash up to date.
+    void put(cell_t, Cell::cell_e);
+    /// Draws a new food like `Level::add_food()` does.
+    cell_t draw_food();
+
+    std::shared_ptr<const Layout> m_layout; //!< Walls shared with the level.
+    size_t m_rows = 0;                      //!< The number of rows in the maze.
+    size_t m_cols = 0;                      //!< The number of cols in the maze.
+    std::vector<Cell::cell_e> m_cells;      //!< Type of each cell, row by row.
+    std::vector<cell_t> m_ring;             //!< Snake cells from tail to head, wrapping around.
+    size_t m_first = 0;                     //!< Ring slot of the tail.
+    size_t m_length = 0;                    //!< Number of snake cells in the ring.
+    bool m_grow = false;                    //!< Whether the next move keeps the tail in place.
+    dir_e m_direction = UP;                 //!< Direction of the last move.
+    cell_t m_food = NO_CELL;                //!< Cell of the newest food.
+    Rng m_rng;                              //!< Generator of the food positions.
+    count_t m_score = 0;                    //!< Score in the match.
+    count_t m_lives = 0;                    //!< Remaining lives.
+    count_t m_foods = 0;                    //!< Foods eaten.
+    bool m_dead = false;                    //!< Whether the last step killed the snake.
+    zobrist::hash_t m_hash = 0;             //!< Hash of the cells, the snake and a pending growth.
+    std::vector<Undo> m_log;                //!< One record per step, newest last.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
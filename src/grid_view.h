@@ -0,0 +1,59 @@
+/**
+ * @file grid_view.h
+ *
+ * @description
+ * This class is a read-only, non-owning view of the cells of a maze.
+ * It holds the chunk table of a level's overlay and its dimensions, so
+ * planners can query the live maze without copying it. A view is only
+ * valid while the level it was taken from is alive and not reassigned.
+ */
+
+#ifndef GRID_VIEW_H
+#define GRID_VIEW_H
+
+#include <cstddef>
+
+#include "cell.h"
+#include "cell_overlay.h"
+#include "common.h"
+
+namespace snaze {
+
+class GridView {
+public:
+    /// Default constructor.
+    GridView() = default;
+    /// Creates a view over the chunk table of an overlay.
+    GridView(const Cell *const *chunks, size_t rows, size_t cols)
+        : m_chunks(chunks), m_rows(rows), m_cols(cols) { /* empty */ }
+
+    /// Returns the number of rows in the maze.
+    size_t rows() const { return m_rows; }
+    /// Returns the number of cols in the maze.
+    size_t cols() const { return m_cols; }
+    /// Returns the linear index of a position.
+    size_t index(const Position &pos) const { return pos.row * m_cols + pos.col; }
+    /// Checks whether a position lies inside the maze.
+    bool contains(const Position &pos) const { return pos.row < m_rows and pos.col < m_cols; }
+
+    /// Returns the type of the cell at a position.
+    Cell::cell_e at(const Position &pos) const { return at(index(pos)); }
+    /// Returns the type of the cell at a linear index.
+    Cell::cell_e at(size_t id) const {
+        return m_chunks[id >> CellOverlay::CHUNK_BITS][id & (CellOverlay::CHUNK - 1)].type();
+    }
+    /// Checks whether the snake may enter the cell at a linear index.
+    bool open(size_t id) const {
+        Cell::cell_e type = at(id);
+        return type == Cell::cell_e::FREE or type == Cell::cell_e::FOOD;
+    }
+
+private:
+    const Cell *const *m_chunks = nullptr;  //!< First cell of each chunk of the maze.
+    size_t m_rows = 0;              //!< The number of rows in the maze.
+    size_t m_cols = 0;              //!< The number of cols in the maze.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,298 @@
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "hamiltonian.h"
+#include "common.h"
+
+namespace snaze {
+
+namespace {
+
+/// Spanning tree over a connected group of 2x2 free blocks.
+struct BlockTree {
+    size_t row_offset = 0;                          //!< Row of the first block grid line.
+    size_t col_offset = 0;                          //!< Col of the first block grid line.
+    size_t block_cols = 0;                          //!< Number of blocks per block row.
+    std::vector<size_t> blocks;                     //!< Blocks in the tree.
+    std::vector<std::pair<size_t, size_t>> edges;   //!< Tree edges (parent, child).
+};
+
+/**
+ * @brief Finds the largest group of connected 2x2 free blocks for a grid alignment.
+ *
+ * The maze is split into 2x2 blocks starting at the given offsets. Only blocks
+ * whose four cells are passable are kept, and a BFS spanning tree is built over
+ * the largest connected group of them.
+ *
+ * @param rows The number of rows in the maze.
+ * @param cols The number of cols in the maze.
+ * @param passable Row-major map of the cells the snake may walk on.
+ * @param row_offset Row where the block grid starts (0 or 1).
+ * @param col_offset Col where the block grid starts (0 or 1).
+ * @return The spanning tree of the largest block group.
+ */
+BlockTree largest_tree(size_t rows, size_t cols, const std::vector<bool> &passable,
+                       size_t row_offset, size_t col_offset)
+{
+    BlockTree best;
+    best.row_offset = row_offset;
+    best.col_offset = col_offset;
+
+    if (rows < row_offset + 2 or cols < col_offset + 2)
+        return best;
+
+    const size_t block_rows = (rows - row_offset) / 2;
+    const size_t block_cols = (cols - col_offset) / 2;
+    best.block_cols = block_cols;
+
+    // Checks whether all cells of a block are passable.
+    auto is_free = [&](size_t br, size_t bc) {
+        size_t r = row_offset + 2 * br, c = col_offset + 2 * bc;
+        return passable[r * cols + c] and passable[r * cols + c + 1]
+           and passable[(r + 1) * cols + c] and passable[(r + 1) * cols + c + 1];
+    };
+
+    std::vector<bool> seen(block_rows * block_cols, false);
+
+    for (size_t root = 0; root < seen.size(); ++root) {
+        if (seen[root] or not is_free(root / block_cols, root % block_cols))
+            continue;
+
+        BlockTree tree;
+        tree.row_offset = row_offset;
+        tree.col_offset = col_offset;
+        tree.block_cols = block_cols;
+
+        std::queue<size_t> queue;
+        queue.push(root);
+        seen[root] = true;
+
+        while (not queue.empty()) {
+            size_t block = queue.front();
+            queue.pop();
+            tree.blocks.push_back(block);
+
+            size_t br = block / block_cols, bc = block % block_cols;
+            std::pair<size_t, size_t> neighbors[] = {
+                { br - 1, bc }, { br + 1, bc }, { br, bc - 1 }, { br, bc + 1 },
+            };
+
+            for (const auto &[nr, nc] : neighbors) {
+                // Out of range coordinates wrap around to huge values.
+                if (nr >= block_rows or nc >= block_cols)
+                    continue;
+
+                size_t next = nr * block_cols + nc;
+                if (not seen[next] and is_free(nr, nc)) {
+                    seen[next] = true;
+                    tree.edges.push_back({ block, next });
+                    queue.push(next);
+                }
+            }
+        }
+
+        if (tree.blocks.size() > best.blocks.size())
+            best = std::move(tree);
+    }
+
+    return best;
+}
+
+/**
+ * @brief Checks whether the passable cells already form a single loop.
+ *
+ * Corridor mazes one cell wide have no 2x2 blocks, but when every passable cell
+ * has exactly two passable neighbors and they are all connected, the corridor
+ * itself is a Hamiltonian cycle.
+ *
+ * @param rows The number of rows in the maze.
+ * @param cols The number of cols in the maze.
+ * @param passable Row-major map of the cells the snake may walk on.
+ * @param succ Receives the successor of each cell along the loop.
+ * @return The first cell of the loop, or HamiltonianCycle::NONE if there is no loop.
+ */
+size_t simple_loop(size_t rows, size_t cols, const std::vector<bool> &passable, std::vector<size_t> &succ)
+{
+    // Collects the passable neighbors of a cell.
+    auto neighbors = [&](size_t id) {
+        std::vector<size_t> result;
+        size_t r = id / cols, c = id % cols;
+        if (r > 0 and passable[id - cols])        result.push_back(id - cols);
+        if (r + 1 < rows and passable[id + cols]) result.push_back(id + cols);
+        if (c > 0 and passable[id - 1])           result.push_back(id - 1);
+        if (c + 1 < cols and passable[id + 1])    result.push_back(id + 1);
+        return result;
+    };
+
+    size_t start = HamiltonianCycle::NONE, total = 0;
+    for (size_t id = 0; id < passable.size(); ++id) {
+        if (not passable[id])
+            continue;
+        if (neighbors(id).size() != 2)
+            return HamiltonianCycle::NONE;
+        if (start == HamiltonianCycle::NONE)
+            start = id;
+        ++total;
+    }
+
+    if (start == HamiltonianCycle::NONE)
+        return HamiltonianCycle::NONE;
+
+    // Walk the loop, never stepping back to the previous cell.
+    size_t prev = start, curr = neighbors(start).front(), length = 1;
+    succ[start] = curr;
+    while (curr != start) {
+        auto next = neighbors(curr);
+        size_t ahead = next[0] == prev ? next[1] : next[0];
+        succ[curr] = ahead;
+        prev = curr;
+        curr = ahead;
+        ++length;
+    }
+
+    // The loop must reach every passable cell.
+    return length == total ? start : HamiltonianCycle::NONE;
+}
+
+/**
+ * @brief Builds a cycle around a spanning tree of 2x2 free blocks.
+ *
+ * Every block of the largest tree starts as a small 4-cell loop. Each tree edge
+ * then merges the loops of its two blocks by swapping one pair of edges, which
+ * leaves a single cycle covering every cell of the tree. All four block grid
+ * alignments are tried and the one covering more cells is kept.
+ *
+ * @param rows The number of rows in the maze.
+ * @param cols The number of cols in the maze.
+ * @param passable Row-major map of the cells the snake may walk on.
+ * @param succ Receives the successor of each cell along the cycle.
+ * @return The first cell of the cycle, or HamiltonianCycle::NONE if no block is free
+ * or the merged loops do not form a single cycle.
+ */
+size_t merge_blocks(size_t rows, size_t cols, const std::vector<bool> &passable, std::vector<size_t> &succ)
+{
+    BlockTree tree;
+    for (size_t row_offset : { 0, 1 }) {
+        for (size_t col_offset : { 0, 1 }) {
+            BlockTree candidate = largest_tree(rows, cols, passable, row_offset, col_offset);
+            if (candidate.blocks.size() > tree.blocks.size())
+                tree = std::move(candidate);
+        }
+    }
+
+    if (tree.blocks.empty())
+        return HamiltonianCycle::NONE;
+
+    // Returns the linear index of the top-left cell of a block.
+    auto top_left = [&](size_t block) {
+        size_t r = tree.row_offset + 2 * (block / tree.block_cols);
+        size_t c = tree.col_offset + 2 * (block % tree.block_cols);
+        return r * cols + c;
+    };
+
+    // Each block starts as a loop: top-left, bottom-left, bottom-right, top-right.
+    for (size_t block : tree.blocks) {
+        size_t tl = top_left(block), tr = tl + 1, bl = tl + cols, br = bl + 1;
+        succ[tl] = bl;
+        succ[bl] = br;
+        succ[br] = tr;
+        succ[tr] = tl;
+    }
+
+    // Merge the loops of adjacent blocks along the tree edges.
+    for (auto [a, b] : tree.edges) {
+        if (a > b) std::swap(a, b);
+
+        // With a single block col, blocks one above the other also differ by one.
+        size_t first = top_left(a), second = top_left(b);
+        if (a / tree.block_cols == b / tree.block_cols) {
+            // Horizontal neighbors: cross over the right column of the left block.
+            succ[first + cols + 1] = second + cols;
+            succ[second] = first + 1;
+        }
+        else {
+            // Vertical neighbors: cross over the bottom row of the upper block.
+            succ[first + cols] = second;
+            succ[second + 1] = first + cols + 1;
+        }
+    }
+
+    // The merged loops must form one cycle through every cell of the tree.
+    const size_t start = top_left(tree.blocks.front()), cells = 4 * tree.blocks.size();
+    size_t curr = start, length = 0;
+    do {
+        curr = succ[curr];
+        ++length;
+    } while (curr != start and length < cells);
+
+    return curr == start and length == cells ? start : HamiltonianCycle::NONE;
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Builds the cycle over the free cells of a maze.
+ *
+ * If the free cells already form a single loop, that loop is the cycle.
+ * Otherwise the cycle is built around the largest group of 2x2 free blocks.
+ *
+ * @param rows The number of rows in the maze.
+ * @param cols The number of cols in the maze.
+ * @param passable Row-major map of the cells the snake may walk on.
+ */
+HamiltonianCycle::HamiltonianCycle(size_t rows, size_t cols, const std::vector<bool> &passable)
+    : m_rows(rows), m_cols(cols), m_order(rows * cols, NONE), m_next(rows * cols, 0)
+{
+    std::vector<size_t> succ(rows * cols, NONE);
+
+    size_t start = simple_loop(rows, cols, passable, succ);
+    if (start == NONE)
+        start = merge_blocks(rows, cols, passable, succ);
+    if (start == NONE)
+        return;
+
+    // Walk the cycle once to number its cells and cache the moves.
+    size_t curr = start;
+    do {
+        size_t next = succ[curr];
+        m_order[curr] = m_size++;
+
+        if (next == curr - cols)      m_next[curr] = UP;
+        else if (next == curr + cols) m_next[curr] = DOWN;
+        else if (next == curr - 1)    m_next[curr] = LEFT;
+        else                          m_next[curr] = RIGHT;
+
+        curr = next;
+    } while (curr != start);
+}
+
+/**
+ * @brief Returns the order of a position along the cycle.
+ *
+ * @param pos The position to look up.
+ * @return The order of the position, or NONE if it is not part of the cycle.
+ */
+HamiltonianCycle::index_t HamiltonianCycle::order(const Position &pos) const
+{
+    if (pos.row >= m_rows or pos.col >= m_cols)
+        return NONE;
+
+    return m_order[id(pos)];
+}
+
+/**
+ * @brief Returns how many steps along the cycle lead from one position to another.
+ *
+ * Both positions must be part of the cycle.
+ *
+ * @param from The position where the walk starts.
+ * @param to The position where the walk ends.
+ * @return The number of steps following the cycle order.
+ */
+size_t HamiltonianCycle::distance(const Position &from, const Position &to) const
+{
+    return (order(to) + m_size - order(from)) % m_size;
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,62 @@
+/**
+ * @file hamiltonian.h
+ *
+ * @description
+ * This class represents a Hamiltonian cycle over the free cells of a maze.
+ * Walls rarely allow a cycle through every cell, so the cycle is built from
+ * the largest group of connected 2x2 free blocks, or from the corridor
+ * itself when it is a single loop, which is the best approximation that
+ * can be found in linear time.
+ */
+
+#ifndef HAMILTONIAN_H
+#define HAMILTONIAN_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "common.h"
+
+namespace snaze {
+
+class HamiltonianCycle {
+public:
+    //== Aliases
+    using index_t = size_t;
+
+    /// Order of a cell that is not part of the cycle.
+    static constexpr index_t NONE = std::numeric_limits<index_t>::max();
+
+    /// Default constructor.
+    HamiltonianCycle() = default;
+    /// Builds the cycle from a row-major map of the cells the snake may walk on.
+    HamiltonianCycle(size_t rows, size_t cols, const std::vector<bool> &passable);
+    /// Destructor.
+    ~HamiltonianCycle() = default;
+
+    /// Returns the number of cells covered by the cycle.
+    size_t size() const { return m_size; }
+    /// Checks whether a position belongs to the cycle.
+    bool contains(const Position &pos) const { return order(pos) != NONE; }
+    /// Returns the order of a position along the cycle.
+    index_t order(const Position &pos) const;
+    /// Returns the direction that leads to the successor of a position.
+    dir_e next(const Position &pos) const { return static_cast<dir_e>(m_next[id(pos)]); }
+    /// Returns how many steps along the cycle separate two positions.
+    size_t distance(const Position &, const Position &) const;
+
+private:
+    /// Returns the linear index of a position.
+    size_t id(const Position &pos) const { return pos.row * m_cols + pos.col; }
+
+    size_t m_rows = 0;                  //!< The number of rows in the maze.
+    size_t m_cols = 0;                  //!< The number of cols in the maze.
+    size_t m_size = 0;                  //!< The number of cells in the cycle.
+    std::vector<index_t> m_order;       //!< Order of each cell along the cycle.
+    std::vector<unsigned char> m_next;  //!< Direction from each cell to its successor.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
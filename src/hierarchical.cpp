@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hierarchical.h"
+#include "cell.h"
+#include "common.h"
+#include "level.h"
+
+namespace snaze {
+
+namespace {
+
+/// Shortest run of border cells that gets two entrances instead of one.
+constexpr size_t WIDE_ENTRANCE = 6;
+
+std::atomic<uint64_t> maps_built { 0 }; //!< Maps built so far, which numbers them.
+
+/**
+ * @brief Checks whether the snake may enter a cell.
+ *
+ * @param level The maze being searched.
+ * @param pos The position to check.
+ * @return true if the cell is free, holds the food or is the spawn.
+ */
+bool walkable(const Level &level, const Position &pos)
+{
+    Cell::cell_e type = level.cell(pos);
+    return type == Cell::cell_e::FREE or type == Cell::cell_e::FOOD or type == Cell::cell_e::SPAWN;
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Builds the abstract graph of a level from its static walls.
+ *
+ * The maze is split into square clusters. Every run of free cells along a
+ * cluster border gets one entrance in its middle, or one at each end when
+ * the run is wide, and the entrances of each cluster are then connected by
+ * their distances inside the cluster.
+ *
+ * @param level The maze to be split, without the snake placed.
+ * @param cluster_size The side of a cluster, in cells.
+ */
+HierarchicalMap::HierarchicalMap(const Level &level, size_t cluster_size)
+    : m_cluster_size(cluster_size), m_rows(level.rows()), m_cols(level.cols()), m_id(++maps_built)
+{
+    const size_t k = m_cluster_size;
+    const size_t cluster_rows = (m_rows + k - 1) / k;
+    m_cluster_cols = (m_cols + k - 1) / k;
+
+    for (size_t cr = 0; cr < cluster_rows; ++cr) {
+        for (size_t cc = 0; cc < m_cluster_cols; ++cc) {
+            size_t row = cr * k, col = cc * k;
+            m_clusters.push_back({ row, col, std::min(k, m_rows - row), std::min(k, m_cols - col), {} });
+        }
+    }
+
+    // Borders between cluster rows, one cluster wide at a time.
+    for (size_t r = k; r < m_rows; r += k) {
+        for (size_t c = 0; c < m_cols; c += k)
+            scan_border(level, r, c, std::min(k, m_cols - c), true);
+    }
+
+    // Borders between cluster cols, one cluster tall at a time.
+    for (size_t c = k; c < m_cols; c += k) {
+        for (size_t r = 0; r < m_rows; r += k)
+            scan_border(level, c, r, std::min(k, m_rows - r), false);
+    }
+
+    for (size_t cluster = 0; cluster < m_clusters.size(); ++cluster) {
+        std::vector<edges_t> edges = connect(level, cluster);
+        for (size_t n : m_clusters[cluster].nodes)
+            m_nodes[n].intra = std::move(edges[m_nodes[n].slot]);
+    }
+}
+
+/**
+ * @brief Finds the waypoints of a path from start to goal.
+ *
+ * The repairs of the clusters the snake moved through are brought up to
+ * date first. The start and the goal are then linked to the entrances of
+ * their clusters, and A* runs over the abstract graph with the Manhattan
+ * distance as heuristic.
+ *
+ * @param level The live maze, with the snake and the food placed.
+ * @param start The starting position, usually the snake head.
+ * @param goal The target position, usually the food.
+ * @param repairs The distances around the snake kept by the planner, updated.
+ * @return The waypoints from start to goal, or an empty vector if the goal is unreachable.
+ */
+std::vector<Position> HierarchicalMap::abstract_path(const Level &level, const Position &start, const Position &goal,
+                                                     Repairs &repairs) const
+{
+    using node = std::pair<cost_t, size_t>; //!< Pair of estimated cost and node.
+
+    repair(level, repairs);
+
+    const size_t source = m_nodes.size(), target = source + 1;
+    const size_t start_cluster = cluster_of(start), goal_cluster = cluster_of(goal);
+
+    // Link the start to the entrances it reaches inside its cluster.
+    std::vector<std::pair<size_t, cost_t>> from_start;
+    LocalSearch around_start = search_cluster(level, start_cluster, start);
+    const Cluster &sc = m_clusters[start_cluster];
+
+    for (size_t n : sc.nodes) {
+        const Position &pos = m_nodes[n].pos;
+        cost_t dist = around_start.dist[(pos.row - sc.row) * sc.cols + pos.col - sc.col];
+        if (dist != INF)
+            from_start.push_back({ n, dist });
+    }
+    if (start_cluster == goal_cluster) {
+        cost_t direct = around_start.dist[(goal.row - sc.row) * sc.cols + goal.col - sc.col];
+        if (direct != INF)
+            from_start.push_back({ target, direct });
+    }
+
+    // Link the entrances of the goal cluster to the goal.
+    std::unordered_map<size_t, cost_t> to_goal;
+    LocalSearch around_goal = search_cluster(level, goal_cluster, goal);
+    const Cluster &gc = m_clusters[goal_cluster];
+
+    for (size_t n : gc.nodes) {
+        const Position &pos = m_nodes[n].pos;
+        cost_t dist = around_goal.dist[(pos.row - gc.row) * gc.cols + pos.col - gc.col];
+        if (dist != INF)
+            to_goal[n] = dist;
+    }
+
+    // Position of an abstract node, including the temporary start and goal.
+    auto position = [&](size_t n) { return n == source ? start : n == target ? goal : m_nodes[n].pos; };
+    auto heuristic = [&](size_t n) {
+        Position pos = position(n);
+        return static_cast<cost_t>(std::labs(long(pos.row) - long(goal.row)) + std::labs(long(pos.col) - long(goal.col)));
+    };
+
+    std::vector<cost_t> cost(m_nodes.size() + 2, INF);
+    std::vector<size_t> parent(m_nodes.size() + 2, source);
+    std::priority_queue<node, std::vector<node>, std::greater<node>> open;
+
+    cost[source] = 0;
+    open.push({ heuristic(source), source });
+
+    while (not open.empty()) {
+        auto [estimate, n] = open.top();
+        open.pop();
+
+        if (estimate > cost[n] + heuristic(n))
+            continue;
+
+        if (n == target) {
+            std::vector<Position> waypoints;
+            for (size_t curr = target; curr != source; curr = parent[curr]) {
+                if (waypoints.empty() or not (waypoints.back() == position(curr)))
+                    waypoints.push_back(position(curr));
+            }
+            if (not (waypoints.back() == start))
+                waypoints.push_back(start);
+            std::reverse(waypoints.begin(), waypoints.end());
+
+            return waypoints;
+        }
+
+        // Relaxes an abstract edge.
+        auto visit = [&](size_t next, cost_t weight) {
+            if (cost[n] + weight < cost[next]) {
+                cost[next] = cost[n] + weight;
+                parent[next] = n;
+                open.push({ cost[next] + heuristic(next), next });
+            }
+        };
+
+        if (n == source) {
+            for (const auto &[next, weight] : from_start)
+                visit(next, weight);
+            continue;
+        }
+
+        for (const auto &[next, weight] : m_nodes[n].inter) {
+            // Entrances covered by the snake cannot be crossed.
+            if (walkable(level, m_nodes[next].pos))
+                visit(next, weight);
+        }
+        // Clusters covered by the snake use their repaired edges.
+        auto repaired = repairs.intra.find(m_nodes[n].cluster);
+        const edges_t &intra = repaired == repairs.intra.end() ? m_nodes[n].intra : repaired->second[m_nodes[n].slot];
+        for (const auto &[next, weight] : intra)
+            visit(next, weight);
+
+        auto exit = to_goal.find(n);
+        if (exit != to_goal.end())
+            visit(target, exit->second);
+    }
+
+    return {};
+}
+
+/**
+ * @brief Refines the segment between two consecutive waypoints.
+ *
+ * Waypoints either sit on both sides of a cluster border, one step apart,
+ * or inside the same cluster, where a BFS bounded to the cluster finds the
+ * steps. The live level is used, so the segment avoids the snake as it is now.
+ *
+ * @param level The live maze, with the snake and the food placed.
+ * @param from The waypoint the snake is standing on.
+ * @param to The next waypoint.
+ * @return The steps after from up to and including to, or an empty vector if the segment is blocked.
+ */
+std::vector<Position> HierarchicalMap::refine(const Level &level, const Position &from, const Position &to) const
+{
+    long dr = long(to.row) - long(from.row), dc = long(to.col) - long(from.col);
+    if (std::labs(dr) + std::labs(dc) == 1)
+        return { to };
+
+    const size_t cluster = cluster_of(from);
+    const Cluster &cl = m_clusters[cluster];
+    LocalSearch search = search_cluster(level, cluster, from);
+
+    // The goal of an intra-cluster segment is always inside the same cluster.
+    if (cluster_of(to) != cluster or search.dist[(to.row - cl.row) * cl.cols + to.col - cl.col] == INF)
+        return {};
+
+    std::vector<Position> steps;
+    for (Position curr = to; not (curr == from); ) {
+        steps.push_back(curr);
+
+        dir_e dir = static_cast<dir_e>(search.parent[(curr.row - cl.row) * cl.cols + curr.col - cl.col]);
+        curr = level.move_to(curr, static_cast<dir_e>((dir + 2) % 4));
+    }
+    std::reverse(steps.begin(), steps.end());
+
+    return steps;
+}
+
+/**
+ * @brief Returns the cluster that contains a position.
+ *
+ * @param pos The position to look up.
+ * @return The index of the cluster.
+ */
+size_t HierarchicalMap::cluster_of(const Position &pos) const
+{
+    return (pos.row / m_cluster_size) * m_cluster_cols + pos.col / m_cluster_size;
+}
+
+/**
+ * @brief Returns the entrance node placed on a cell, creating it if needed.
+ *
+ * A cell on a cluster corner may be an entrance of two borders, so nodes
+ * are shared between them.
+ *
+ * @param pos The cell of the entrance.
+ * @return The index of the node.
+ */
+size_t HierarchicalMap::node_at(const Position &pos)
+{
+    size_t cell = pos.row * m_cols + pos.col;
+    auto found = m_node_of.find(cell);
+    if (found != m_node_of.end())
+        return found->second;
+
+    size_t n = m_nodes.size();
+    std::vector<size_t> &siblings = m_clusters[cluster_of(pos)].nodes;
+    m_nodes.push_back({ pos, cluster_of(pos), siblings.size(), {}, {} });
+    siblings.push_back(n);
+    m_node_of[cell] = n;
+
+    return n;
+}
+
+/**
+ * @brief Links two entrance cells on both sides of a cluster border.
+ *
+ * @param inside The entrance cell on one side of the border.
+ * @param outside The entrance cell on the other side of the border.
+ */
+void HierarchicalMap::add_entrance(const Position &inside, const Position &outside)
+{
+    size_t a = node_at(inside), b = node_at(outside);
+    m_nodes[a].inter.push_back({ b, 1 });
+    m_nodes[b].inter.push_back({ a, 1 });
+}
+
+/**
+ * @brief Scans one cluster-wide stretch of a border for entrances.
+ *
+ * @param level The maze being split.
+ * @param line The first row (or col) after the border.
+ * @param from The first col (or row) of the stretch.
+ * @param length The number of cells in the stretch.
+ * @param horizontal Whether the border separates cluster rows.
+ */
+void HierarchicalMap::scan_border(const Level &level, size_t line, size_t from, size_t length, bool horizontal)
+{
+    // Cells on each side of the border at a given offset of the stretch.
+    auto before = [&](size_t i) { return horizontal ? Position(line - 1, from + i) : Position(from + i, line - 1); };
+    auto after = [&](size_t i) { return horizontal ? Position(line, from + i) : Position(from + i, line); };
+    auto open = [&](size_t i) { return walkable(level, before(i)) and walkable(level, after(i)); };
+
+    for (size_t i = 0; i < length; ) {
+        if (not open(i)) {
+            ++i;
+            continue;
+        }
+
+        size_t first = i;
+        while (i < length and open(i))
+            ++i;
+        size_t last = i - 1;
+
+        if (last - first + 1 < WIDE_ENTRANCE) {
+            size_t middle = (first + last) / 2;
+            add_entrance(before(middle), after(middle));
+        }
+        else {
+            add_entrance(before(first), after(first));
+            add_entrance(before(last), after(last));
+        }
+    }
+}
+
+/**
+ * @brief Computes the distances between the entrances of a cluster.
+ *
+ * Entrances covered by the snake are left without edges.
+ *
+ * @param level The maze, as it is now.
+ * @param cluster The index of the cluster.
+ * @return The edges of each entrance of the cluster, by node slot.
+ */
+std::vector<HierarchicalMap::edges_t> HierarchicalMap::connect(const Level &level, size_t cluster) const
+{
+    const Cluster &cl = m_clusters[cluster];
+    std::vector<edges_t> edges(cl.nodes.size());
+
+    for (size_t a : cl.nodes) {
+        if (not walkable(level, m_nodes[a].pos))
+            continue;
+
+        LocalSearch search = search_cluster(level, cluster, m_nodes[a].pos);
+        for (size_t b : cl.nodes) {
+            const Position &pos = m_nodes[b].pos;
+            cost_t dist = search.dist[(pos.row - cl.row) * cl.cols + pos.col - cl.col];
+
+            if (b != a and dist != INF)
+                edges[m_nodes[a].slot].push_back({ b, dist });
+        }
+    }
+
+    return edges;
+}
+
+/**
+ * @brief Recomputes the clusters whose cells the snake entered or left since the last search.
+ *
+ * The cells in only one of the previous and the current body are the ones
+ * the head entered and the tail left. Their clusters are connected again
+ * around the snake if it still covers them, or dropped from the repairs
+ * if it left them, so they get the edges computed at load time back. Any
+ * other cluster keeps its edges, repaired or not.
+ *
+ * @param level The maze, as it is now.
+ * @param repairs The distances around the snake at the last search, updated.
+ */
+void HierarchicalMap::repair(const Level &level, Repairs &repairs) const
+{
+    // Repairs computed on another map start over.
+    if (repairs.map != m_id)
+        repairs = { m_id, {}, {} };
+
+    std::vector<cell_t> body(level.snake().body().begin(), level.snake().body().end());
+    std::sort(body.begin(), body.end());
+
+    std::vector<cell_t> moved;
+    std::set_symmetric_difference(body.begin(), body.end(), repairs.body.begin(), repairs.body.end(),
+                                  std::back_inserter(moved));
+
+    std::vector<size_t> changed, covered;
+    for (cell_t cell : moved)
+        changed.push_back(cluster_of(to_position(cell, m_cols)));
+    for (cell_t cell : body)
+        covered.push_back(cluster_of(to_position(cell, m_cols)));
+
+    for (auto *clusters : { &changed, &covered }) {
+        std::sort(clusters->begin(), clusters->end());
+        clusters->erase(std::unique(clusters->begin(), clusters->end()), clusters->end());
+    }
+
+    for (size_t cluster : changed) {
+        if (std::binary_search(covered.begin(), covered.end(), cluster))
+            repairs.intra[cluster] = connect(level, cluster);
+        else
+            repairs.intra.erase(cluster);
+    }
+
+    repairs.body = std::move(body);
+}
+
+/**
+ * @brief Runs a BFS from a position that never leaves its cluster.
+ *
+ * The source itself does not need to be walkable, since it is usually the
+ * snake head.
+ *
+ * @param level The maze, as it is now.
+ * @param cluster The index of the cluster to search.
+ * @param source The position where the search starts.
+ * @return The distances and parent directions of the cells of the cluster.
+ */
+HierarchicalMap::LocalSearch HierarchicalMap::search_cluster(const Level &level, size_t cluster, const Position &source) const
+{
+    const Cluster &cl = m_clusters[cluster];
+    LocalSearch search { std::vector<cost_t>(cl.rows * cl.cols, INF), std::vector<short>(cl.rows * cl.cols, -1) };
+
+    // Local index of a position inside the cluster.
+    auto local = [&](const Position &pos) { return (pos.row - cl.row) * cl.cols + pos.col - cl.col; };
+
+    std::queue<Position> queue;
+    search.dist[local(source)] = 0;
+    queue.push(source);
+
+    while (not queue.empty()) {
+        Position curr = queue.front();
+        queue.pop();
+
+        for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+            Position next = level.move_to(curr, dir);
+
+            // Out of range positions wrap around, so they fail the bounds check too.
+            if (next.row < cl.row or next.row >= cl.row + cl.rows or next.col < cl.col or next.col >= cl.col + cl.cols)
+                continue;
+
+            if (search.dist[local(next)] == INF and walkable(level, next)) {
+                search.dist[local(next)] = search.dist[local(curr)] + 1;
+                search.parent[local(next)] = dir;
+                queue.push(next);
+            }
+        }
+    }
+
+    return search;
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,116 @@
+/**
+ * @file hierarchical.h
+ *
+ * @description
+ * This class implements hierarchical pathfinding (HPA*) over a maze.
+ * The maze is split into square clusters, and the entrances between
+ * neighboring clusters form an abstract graph that is precomputed from
+ * the static walls when the level is loaded. A search then runs on the
+ * small abstract graph, and only the segments the snake is about to walk
+ * are refined into single steps.
+ *
+ * The map never changes once built, so copies of a level share it between
+ * threads. The entrance distances of the clusters the snake covers are
+ * kept by each planner in a `Repairs`, and only the clusters whose cells
+ * the snake entered or left since its previous search are recomputed.
+ */
+
+#ifndef HIERARCHICAL_H
+#define HIERARCHICAL_H
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+
+namespace snaze {
+
+class Level;
+
+class HierarchicalMap {
+public:
+    //== Aliases
+    using cost_t = uint32_t;
+    using edges_t = std::vector<std::pair<size_t, cost_t>>;
+
+    /// Cost of an unreachable cell.
+    static constexpr cost_t INF = std::numeric_limits<cost_t>::max();
+
+    /// Entrance distances around the snake, kept by a planner across its searches.
+    struct Repairs {
+        uint64_t map = 0;                                           //!< Id of the map they were computed on.
+        std::vector<cell_t> body;                                   //!< Cells of the snake then, sorted.
+        std::unordered_map<size_t, std::vector<edges_t>> intra;     //!< Edges of the covered clusters, by node slot.
+    };
+
+    /// Default constructor.
+    HierarchicalMap(const Level &, size_t cluster_size = 16);
+    /// Destructor.
+    ~HierarchicalMap() = default;
+
+    /// Returns the number of clusters.
+    size_t clusters() const { return m_clusters.size(); }
+    /// Returns the number of entrance nodes in the abstract graph.
+    size_t nodes() const { return m_nodes.size(); }
+
+    /// Returns the waypoints of a path from start to goal, or an empty vector if there is none.
+    std::vector<Position> abstract_path(const Level &, const Position &, const Position &, Repairs &) const;
+    /// Returns the single steps between two consecutive waypoints, excluding the first one.
+    std::vector<Position> refine(const Level &, const Position &, const Position &) const;
+
+private:
+    //== Structs
+
+    /// An entrance cell on the border of a cluster.
+    struct Node {
+        Position pos;                                   //!< The cell of the entrance.
+        size_t cluster;                                 //!< The cluster the cell belongs to.
+        size_t slot;                                    //!< Index of the node among the entrances of its cluster.
+        edges_t inter;                                  //!< Edges to entrances of other clusters.
+        edges_t intra;                                  //!< Edges to entrances of the same cluster, without the snake.
+    };
+
+    /// A square region of the maze.
+    struct Cluster {
+        size_t row, col;            //!< Top-left cell of the cluster.
+        size_t rows, cols;          //!< Size of the cluster, smaller on the maze border.
+        std::vector<size_t> nodes;  //!< Entrances of the cluster.
+    };
+
+    /// Result of a BFS bounded to one cluster.
+    struct LocalSearch {
+        std::vector<cost_t> dist;   //!< Distance from the source to each cell of the cluster.
+        std::vector<short> parent;  //!< Direction used to enter each cell of the cluster.
+    };
+
+    /// Returns the cluster that contains a position.
+    size_t cluster_of(const Position &) const;
+    /// Returns the entrance node placed on a cell, creating it if needed.
+    size_t node_at(const Position &);
+    /// Links two entrance cells on both sides of a cluster border.
+    void add_entrance(const Position &, const Position &);
+    /// Scans one cluster-wide stretch of a border for entrances.
+    void scan_border(const Level &, size_t, size_t, size_t, bool);
+    /// Computes the distances between the entrances of a cluster, by node slot.
+    std::vector<edges_t> connect(const Level &, size_t) const;
+    /// Recomputes the clusters whose cells the snake entered or left since the last search.
+    void repair(const Level &, Repairs &) const;
+    /// Runs a BFS from a position that never leaves its cluster.
+    LocalSearch search_cluster(const Level &, size_t, const Position &) const;
+
+    size_t m_cluster_size;                          //!< Side of a cluster, in cells.
+    size_t m_rows;                                  //!< The number of rows in the maze.
+    size_t m_cols;                                  //!< The number of cols in the maze.
+    size_t m_cluster_cols;                          //!< Number of clusters per cluster row.
+    std::vector<Cluster> m_clusters;                //!< The clusters of the maze.
+    std::vector<Node> m_nodes;                      //!< The entrances of all clusters.
+    std::unordered_map<size_t, size_t> m_node_of;   //!< Entrance node placed on each cell.
+    uint64_t m_id;                                  //!< Tells the maps apart, for the repairs kept by planners.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+#include "incremental.h"
+#include "cell.h"
+#include "common.h"
+#include "level.h"
+
+namespace snaze {
+
+/**
+ * @brief Starts a search towards a new goal.
+ *
+ * The search is rooted at the goal, so a new goal invalidates every value.
+ * Instead of clearing them, the search counter is bumped and stale values
+ * are reset lazily when touched, which keeps the cost of a new search
+ * proportional to the cells it explores rather than to the maze size.
+ *
+ * @param level The live maze, with the snake and the food placed.
+ * @param start The starting position, usually the snake head.
+ * @param goal The target position, usually the food.
+ * @return true if the goal is reachable from the start, false otherwise.
+ */
+bool IncrementalPlanner::plan(const Level &level, const Position &start, const Position &goal)
+{
+    m_level = &level;
+
+    if (m_rows != level.rows() or m_cols != level.cols()) {
+        m_rows = level.rows();
+        m_cols = level.cols();
+        m_states.assign(m_rows * m_cols, State());
+        m_generation = 0;
+    }
+
+    // Start a new search; on wrap-around, forget every stamp.
+    if (++m_generation == 0) {
+        std::fill(m_states.begin(), m_states.end(), State());
+        m_generation = 1;
+    }
+
+    m_queue = {};
+    m_km = 0;
+    m_expanded = 0;
+    m_start = to_cell(start, m_cols);
+    m_goal = to_cell(goal, m_cols);
+
+    state(m_goal).rhs = 0;
+    update_vertex(m_goal);
+
+    compute();
+
+    return distance() != INF;
+}
+
+/**
+ * @brief Moves the start and repairs the search around the cells that changed.
+ *
+ * The distances are rooted at the goal, so moving the start only raises
+ * `km` by the heuristic distance it moved, which keeps the queued
+ * priorities valid lower bounds. A cell that was entered or left changes
+ * the cost of the edges into it, so only the cell and its neighbors get
+ * their lookahead values recomputed; the cells that become inconsistent
+ * are expanded again, up to the new start. The old start is a
+ * neighbor of the new head, so it is repaired as the body it became.
+ *
+ * @param level The live maze, after the move.
+ * @param start The new starting position.
+ * @param changed The cells that were entered or left by the snake.
+ * @return true if the goal is still reachable from the start, false otherwise.
+ */
+bool IncrementalPlanner::move(const Level &level, const Position &start, const std::vector<Position> &changed)
+{
+    m_level = &level;
+
+    const cell_t last = m_start;
+    m_start = to_cell(start, m_cols);
+    m_km += heuristic(last);
+
+    std::array<cell_t, 4> around;
+    for (const Position &pos : changed) {
+        const cell_t cell = to_cell(pos, m_cols);
+        update_vertex(cell);
+
+        const size_t count = neighbors(cell, around);
+        for (size_t i = 0; i < count; ++i)
+            update_vertex(around[i]);
+    }
+
+    compute();
+
+    return distance() != INF;
+}
+
+/**
+ * @brief Returns the direction of the best move from the start.
+ *
+ * @return The direction to the open neighbor with the shortest distance to
+ * the goal, or nullopt if none of them reaches it.
+ */
+std::optional<dir_e> IncrementalPlanner::next() const
+{
+    std::optional<dir_e> best;
+    cost_t best_cost = INF;
+    const Position from = to_position(m_start, m_cols);
+
+    for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+        Position next = m_level->move_to(from, dir);
+        if (next.row >= m_rows or next.col >= m_cols)
+            continue;
+
+        cell_t cell = to_cell(next, m_cols);
+        cost_t g = peek(cell).g;
+        if (blocked(cell) or g == INF)
+            continue;
+
+        if (g + 1 < best_cost) {
+            best_cost = g + 1;
+            best = dir;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Returns the state of a cell, resetting it if it belongs to an older search.
+ *
+ * @param cell The linear index of the cell.
+ * @return A reference to the state of the cell.
+ */
+IncrementalPlanner::State &IncrementalPlanner::state(cell_t cell)
+{
+    State &s = m_states[cell];
+    if (s.stamp != m_generation) {
+        s = State();
+        s.stamp = m_generation;
+    }
+
+    return s;
+}
+
+/**
+ * @brief Returns the state of a cell without modifying it.
+ *
+ * @param cell The linear index of the cell.
+ * @return The state of the cell, or a fresh one if it belongs to an older search.
+ */
+IncrementalPlanner::State IncrementalPlanner::peek(cell_t cell) const
+{
+    return m_states[cell].stamp == m_generation ? m_states[cell] : State();
+}
+
+/**
+ * @brief Checks whether the snake may not enter a cell.
+ *
+ * Only the cell entered decides the cost of a move. The start is part of
+ * the snake, so it cannot be entered, but it still gets a distance through
+ * its open neighbors; the other snake cells and the walls get none.
+ *
+ * @param cell The linear index of the cell.
+ * @return true if the cell is a wall or part of the snake.
+ */
+bool IncrementalPlanner::blocked(cell_t cell) const
+{
+    Cell::cell_e type = m_level->cell(to_position(cell, m_cols));
+    return type != Cell::cell_e::FREE and type != Cell::cell_e::FOOD;
+}
+
+/**
+ * @brief Returns the Manhattan distance from the start to a cell.
+ *
+ * @param cell The linear index of the cell.
+ * @return The Manhattan distance.
+ */
+IncrementalPlanner::cost_t IncrementalPlanner::heuristic(cell_t cell) const
+{
+    long dr = long(cell / m_cols) - long(m_start / m_cols);
+    long dc = long(cell % m_cols) - long(m_start % m_cols);
+
+    return std::labs(dr) + std::labs(dc);
+}
+
+/**
+ * @brief Returns the priority of a cell.
+ *
+ * @param s The state of the cell.
+ * @param cell The linear index of the cell.
+ * @return The pair (min(g, rhs) + h + km, min(g, rhs)).
+ */
+IncrementalPlanner::key_t IncrementalPlanner::key(const State &s, cell_t cell) const
+{
+    cost_t best = std::min(s.g, s.rhs);
+
+    if (best == INF)
+        return { INF, INF };
+
+    return { best + heuristic(cell) + m_km, best };
+}
+
+/**
+ * @brief Stores the neighbors of a cell inside the maze.
+ *
+ * @param cell The linear index of the cell.
+ * @param out Receives the linear indices of the neighbors.
+ * @return The number of neighbors stored.
+ */
+size_t IncrementalPlanner::neighbors(cell_t cell, std::array<cell_t, 4> &out) const
+{
+    size_t count = 0;
+    size_t r = cell / m_cols, c = cell % m_cols;
+
+    if (r > 0)          out[count++] = cell - m_cols;
+    if (r + 1 < m_rows) out[count++] = cell + m_cols;
+    if (c > 0)          out[count++] = cell - 1;
+    if (c + 1 < m_cols) out[count++] = cell + 1;
+
+    return count;
+}
+
+/**
+ * @brief Recomputes the lookahead value of a cell and queues it if inconsistent.
+ *
+ * The queue is never searched: a cell is queued again with its new priority,
+ * and entries whose priority no longer matches are skipped when popped.
+ * A blocked cell other than the start never reaches the goal.
+ *
+ * @param cell The linear index of the cell.
+ */
+void IncrementalPlanner::update_vertex(cell_t cell)
+{
+    State &s = state(cell);
+
+    if (cell != m_start and blocked(cell)) {
+        s.rhs = INF;
+    }
+    else if (cell != m_goal) {
+        std::array<cell_t, 4> around;
+        const size_t count = neighbors(cell, around);
+
+        s.rhs = INF;
+        for (size_t i = 0; i < count; ++i) {
+            cost_t g = state(around[i]).g;
+            if (g != INF and not blocked(around[i]))
+                s.rhs = std::min(s.rhs, g + 1);
+        }
+    }
+
+    s.queued = s.g != s.rhs;
+    if (s.queued) {
+        s.key = key(s, cell);
+        m_queue.push({ s.key, cell });
+    }
+}
+
+/**
+ * @brief Expands cells until the start is consistent.
+ */
+void IncrementalPlanner::compute()
+{
+    std::array<cell_t, 4> around;
+
+    while (not m_queue.empty()) {
+        auto [old_key, cell] = m_queue.top();
+
+        // Drop entries that were requeued or are no longer inconsistent.
+        State &s = state(cell);
+        if (not s.queued or s.key != old_key) {
+            m_queue.pop();
+            continue;
+        }
+
+        const State &start = state(m_start);
+        if (not (old_key < key(start, m_start)) and start.rhs == start.g)
+            break;
+
+        m_queue.pop();
+        ++m_expanded;
+
+        const size_t count = neighbors(cell, around);
+        key_t new_key = key(s, cell);
+        if (old_key < new_key) {
+            // The start moved since the cell was queued.
+            s.key = new_key;
+            m_queue.push({ new_key, cell });
+        }
+        else if (s.g > s.rhs) {
+            // The cell got closer to the goal.
+            s.g = s.rhs;
+            s.queued = false;
+            for (size_t i = 0; i < count; ++i)
+                update_vertex(around[i]);
+        }
+        else {
+            // The cell got farther from the goal.
+            s.g = INF;
+            update_vertex(cell);
+            for (size_t i = 0; i < count; ++i)
+                update_vertex(around[i]);
+        }
+    }
+}
+
+} // NAMESPACE SNAZE
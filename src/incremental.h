@@ -0,0 +1,109 @@
+/**
+ * @file incremental.h
+ *
+ * @description
+ * This class implements D* Lite, an incremental planner that keeps its
+ * search state while the snake walks to a food. The search is rooted at
+ * the food, so the distances it keeps stay valid as the head moves; the
+ * moving start only shifts the priorities by the heuristic offset `km`.
+ * Every move changes two cells, the new head and the cell the tail left,
+ * and only the part of the search that depended on them is repaired, so
+ * a move costs what it changed rather than the size of the maze.
+ *
+ * A new food moves the root, so its first search starts over. Instead of
+ * clearing the values, each search bumps a counter and stale values are
+ * reset when touched, so it only costs the cells it explores.
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "level.h"
+
+namespace snaze {
+
+class IncrementalPlanner {
+public:
+    //== Aliases
+    using cost_t = uint32_t;
+
+    /// Cost of an unreachable cell.
+    static constexpr cost_t INF = std::numeric_limits<cost_t>::max();
+
+    /// Default constructor.
+    IncrementalPlanner() = default;
+    /// Destructor.
+    ~IncrementalPlanner() = default;
+
+    /// Starts a search towards a new goal; false if the goal is unreachable.
+    bool plan(const Level &, const Position &, const Position &);
+    /// Moves the start and repairs the search around the cells that changed; false if the goal became unreachable.
+    bool move(const Level &, const Position &, const std::vector<Position> &);
+    /// Returns the direction of the best move from the start, if any reaches the goal.
+    std::optional<dir_e> next() const;
+
+    /// Returns the goal of the current search.
+    Position goal() const { return to_position(m_goal, m_cols); }
+    /// Returns the length of the shortest path from the start to the goal, or INF.
+    cost_t distance() const { return peek(m_start).g; }
+    /// Returns the number of cells expanded since the last plan.
+    size_t expanded() const { return m_expanded; }
+
+private:
+    //== Aliases
+    using key_t = std::pair<cost_t, cost_t>;                //!< Priority of a cell in the queue.
+    using entry_t = std::pair<key_t, cell_t>;               //!< Queued cell with its priority.
+
+    //== Structs
+
+    /// Search values of a cell.
+    struct State {
+        cost_t g = INF;             //!< Current distance to the goal.
+        cost_t rhs = INF;           //!< One-step lookahead distance to the goal.
+        key_t key;                  //!< Priority the cell was queued with.
+        uint32_t stamp = 0;         //!< Search the values belong to.
+        bool queued = false;        //!< Whether the cell is in the queue.
+    };
+
+    /// Returns the state of a cell, resetting it if it belongs to an older search.
+    State &state(cell_t);
+    /// Returns the state of a cell, or a fresh one if it belongs to an older search.
+    State peek(cell_t) const;
+    /// Checks whether the snake may not enter a cell.
+    bool blocked(cell_t) const;
+    /// Returns the Manhattan distance from the start to a cell.
+    cost_t heuristic(cell_t) const;
+    /// Returns the priority of a cell.
+    key_t key(const State &, cell_t) const;
+    /// Stores the neighbors of a cell inside the maze and returns how many there are.
+    size_t neighbors(cell_t, std::array<cell_t, 4> &) const;
+    /// Recomputes the lookahead value of a cell and queues it if inconsistent.
+    void update_vertex(cell_t);
+    /// Expands cells until the start is consistent.
+    void compute();
+
+    const Level *m_level = nullptr;     //!< The maze of the current call.
+    size_t m_rows = 0;                  //!< The number of rows in the maze.
+    size_t m_cols = 0;                  //!< The number of cols in the maze.
+    cell_t m_start = 0;                 //!< Linear index of the start (the snake head).
+    cell_t m_goal = 0;                  //!< Linear index of the goal (the food).
+    cost_t m_km = 0;                    //!< Heuristic offset accumulated by start moves.
+    uint32_t m_generation = 0;          //!< Current search; older states are ignored.
+    size_t m_expanded = 0;              //!< Cells expanded since the last plan.
+    std::vector<State> m_states;        //!< Search values of every cell.
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> m_queue; //!< Inconsistent cells.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
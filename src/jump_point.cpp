@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "jump_point.h"
+#include "cell.h"
+#include "common.h"
+#include "level.h"
+
+namespace snaze {
+
+/**
+ * @brief Finds a shortest path between two positions.
+ *
+ * Runs A* with the Manhattan distance over jump points only. From each jump
+ * point the search keeps moving straight until it hits the goal or a cell
+ * where a turn could lead somewhere a straight line could not (a forced
+ * neighbor). Moving vertically, every cell also probes the horizontal lines
+ * through it, so no turn is missed; horizontal jumps remember their result
+ * for every cell they pass, so no cell is scanned twice in a direction and
+ * each step of a vertical jump costs O(1) amortized.
+ *
+ * The level is read live, so snake segments are treated as obstacles
+ * exactly as they are at the moment of the search.
+ *
+ * @param level The maze to be searched.
+ * @param start The starting position in the maze.
+ * @param goal The target position to reach in the maze.
+ * @return The jump points from start to goal, or an empty vector if the goal is unreachable.
+ */
+std::vector<Position> JumpPointSearch::search(const Level &level, const Position &start, const Position &goal)
+{
+    using node = std::pair<uint32_t, cell_t>; //!< Pair of estimated cost and cell.
+
+    m_grid = level.view();
+    if (m_rows != long(level.rows()) or m_cols != long(level.cols())) {
+        m_rows = level.rows();
+        m_cols = level.cols();
+        const size_t cells = m_rows * m_cols;
+        m_cost.assign(cells, 0);
+        m_parent.assign(cells, NO_CELL);
+        m_left.assign(cells, 0);
+        m_right.assign(cells, 0);
+        m_cost_search.assign(cells, 0);
+        m_search = 0;
+    }
+
+    // Start a new search; on wrap-around, forget every stamp.
+    if (++m_search == 0) {
+        std::fill(m_cost_search.begin(), m_cost_search.end(), 0);
+        std::fill(m_left.begin(), m_left.end(), 0);
+        std::fill(m_right.begin(), m_right.end(), 0);
+        m_search = 1;
+    }
+
+    m_expanded = 0;
+
+    const cell_t origin = to_cell(start, m_cols);
+    m_goal = to_cell(goal, m_cols);
+
+    // Manhattan distance from a cell to the goal.
+    auto heuristic = [&](cell_t cell) {
+        return static_cast<uint32_t>(std::labs(cell / m_cols - static_cast<long>(goal.row))
+                                   + std::labs(cell % m_cols - static_cast<long>(goal.col)));
+    };
+
+    std::priority_queue<node, std::vector<node>, std::greater<node>> open;
+    m_cost[origin] = 0;
+    m_parent[origin] = NO_CELL;
+    m_cost_search[origin] = m_search;
+    open.push({ heuristic(origin), origin });
+
+    while (not open.empty()) {
+        auto [estimate, cell] = open.top();
+        open.pop();
+
+        // Skip entries superseded by a cheaper one.
+        if (estimate > cost(cell) + heuristic(cell))
+            continue;
+
+        if (cell == m_goal) {
+            std::vector<Position> points;
+            for (cell_t curr = cell; curr != NO_CELL; curr = m_parent[curr])
+                points.push_back(to_position(curr, m_cols));
+            std::reverse(points.begin(), points.end());
+
+            return points;
+        }
+
+        ++m_expanded;
+
+        long r = cell / m_cols, c = cell % m_cols;
+        std::vector<std::pair<long, long>> moves;
+
+        if (m_parent[cell] == NO_CELL) {
+            // The start explores every direction.
+            moves = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+        }
+        else {
+            long pr = m_parent[cell] / m_cols, pc = m_parent[cell] % m_cols;
+            long dr = (r > pr) - (r < pr), dc = (c > pc) - (c < pc);
+
+            // Keep going straight or turn to either side.
+            if (dc != 0)
+                moves = { { -1, 0 }, { 1, 0 }, { 0, dc } };
+            else
+                moves = { { 0, -1 }, { 0, 1 }, { dr, 0 } };
+        }
+
+        for (const auto &[dr, dc] : moves) {
+            if (not walkable(r + dr, c + dc))
+                continue;
+
+            cell_t point = jump(r, c, dr, dc);
+            if (point == NO_CELL)
+                continue;
+
+            // Jump points are on a straight line, so the cost is their Manhattan distance.
+            uint32_t reached = m_cost[cell] + std::labs(point / m_cols - r) + std::labs(point % m_cols - c);
+            if (reached < cost(point)) {
+                m_cost[point] = reached;
+                m_parent[point] = cell;
+                m_cost_search[point] = m_search;
+                open.push({ reached + heuristic(point), point });
+            }
+        }
+    }
+
+    return {};
+}
+
+/**
+ * @brief Checks whether the snake may enter a cell.
+ *
+ * @param r The row of the cell.
+ * @param c The col of the cell.
+ * @return true if the cell is free or holds the food, false otherwise.
+ */
+bool JumpPointSearch::walkable(long r, long c) const
+{
+    if (r < 0 or c < 0 or r >= m_rows or c >= m_cols)
+        return false;
+
+    return m_grid.open(r * m_cols + c);
+}
+
+/**
+ * @brief Moves straight from a cell until a jump point is found.
+ *
+ * A cell is a jump point if it is the goal, if it has a forced neighbor
+ * (a free cell to the side whose cell behind is blocked), or, when moving
+ * vertically, if a horizontal jump from it finds a jump point. Horizontal
+ * jumps are read from the tables of their row.
+ *
+ * @param r The row where the jump starts.
+ * @param c The col where the jump starts.
+ * @param dr The row step (-1, 0 or 1).
+ * @param dc The col step (-1, 0 or 1).
+ * @return The linear index of the jump point, or NO_CELL if the jump hits an obstacle.
+ */
+cell_t JumpPointSearch::jump(long r, long c, long dr, long dc)
+{
+    if (dc != 0)
+        return horizontal(r, c, dc);
+
+    while (true) {
+        r += dr;
+        c += dc;
+
+        if (not walkable(r, c))
+            return NO_CELL;
+
+        cell_t cell = r * m_cols + c;
+        if (cell == m_goal)
+            return cell;
+
+        if ((walkable(r, c - 1) and not walkable(r - dr, c - 1))
+         or (walkable(r, c + 1) and not walkable(r - dr, c + 1)))
+            return cell;
+
+        if (horizontal(r, c, -1) != NO_CELL or horizontal(r, c, 1) != NO_CELL)
+            return cell;
+    }
+}
+
+/**
+ * @brief Jumps horizontally from a cell.
+ *
+ * Every cell passed by the jump jumps to the same point, so the result is
+ * remembered for all of them, and a later jump stops at the first cell
+ * whose result is known. Each cell is thus scanned at most once per
+ * direction and search, however many vertical jumps probe its row.
+ *
+ * @param r The row where the jump starts.
+ * @param c The col where the jump starts.
+ * @param dc The col step (-1 or 1).
+ * @return The linear index of the jump point, or NO_CELL if the jump hits an obstacle.
+ */
+cell_t JumpPointSearch::horizontal(long r, long c, long dc)
+{
+    std::vector<uint64_t> &memo = dc > 0 ? m_right : m_left;
+    const uint64_t stamp = uint64_t(m_search) << 32;
+    const cell_t row = r * m_cols;
+
+    cell_t found = NO_CELL;
+    long x = c;
+    while (true) {
+        if ((memo[row + x] & ~uint64_t(UINT32_MAX)) == stamp) {
+            found = static_cast<cell_t>(memo[row + x]);
+            break;
+        }
+
+        x += dc;
+        if (not walkable(r, x))
+            break;
+        if (row + x == m_goal or forced(r, x, dc)) {
+            found = row + x;
+            break;
+        }
+    }
+
+    for (long y = c; y != x; y += dc)
+        memo[row + y] = stamp | found;
+
+    return found;
+}
+
+/**
+ * @brief Checks whether a cell entered moving horizontally has a forced neighbor.
+ *
+ * @param r The row of the cell.
+ * @param c The col of the cell.
+ * @param dc The col step of the move (-1 or 1).
+ * @return true if a free cell above or below has its cell behind blocked.
+ */
+bool JumpPointSearch::forced(long r, long c, long dc) const
+{
+    return (walkable(r - 1, c) and not walkable(r - 1, c - dc))
+        or (walkable(r + 1, c) and not walkable(r + 1, c - dc));
+}
+
+} // NAMESPACE SNAZE
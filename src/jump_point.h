@@ -0,0 +1,66 @@
+/**
+ * @file jump_point.h
+ *
+ * @description
+ * This class implements Jump Point Search on the 4-connected maze grid.
+ * Long runs of open cells are skipped in a single jump, so large open
+ * arenas are searched without expanding their symmetric frontiers, while
+ * the resulting paths are as short as the ones found by BFS.
+ *
+ * The arrays of a search are kept for the next one and stamped with the
+ * number of the search, so a search only touches the cells it reaches.
+ */
+
+#ifndef JUMP_POINT_H
+#define JUMP_POINT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "common.h"
+#include "grid_view.h"
+#include "level.h"
+
+namespace snaze {
+
+class JumpPointSearch {
+public:
+    /// Default constructor.
+    JumpPointSearch() = default;
+    /// Destructor.
+    ~JumpPointSearch() = default;
+
+    /// Returns the jump points of a shortest path on a level, or an empty vector if there is none.
+    std::vector<Position> search(const Level &, const Position &, const Position &);
+    /// Returns the number of jump points expanded by the last search.
+    size_t expanded() const { return m_expanded; }
+
+private:
+    /// Checks whether the snake may enter a cell; out of range cells are blocked.
+    bool walkable(long, long) const;
+    /// Jumps from a cell in a direction and returns the jump point found, if any.
+    cell_t jump(long, long, long, long);
+    /// Jumps horizontally from a cell, remembering the jump point for every cell passed.
+    cell_t horizontal(long, long, long);
+    /// Checks whether a cell entered moving horizontally has a forced neighbor.
+    bool forced(long, long, long) const;
+
+    /// Returns the best known distance from the start to a cell in this search.
+    uint32_t cost(cell_t cell) const { return m_cost_search[cell] == m_search ? m_cost[cell] : UINT32_MAX; }
+
+    GridView m_grid;                //!< The maze being searched.
+    long m_rows = 0;                //!< The number of rows in the maze.
+    long m_cols = 0;                //!< The number of cols in the maze.
+    cell_t m_goal = NO_CELL;        //!< Linear index of the goal of the current search.
+    size_t m_expanded = 0;          //!< Jump points expanded by the last search.
+    std::vector<uint32_t> m_cost;   //!< Best known distance from the start to each cell.
+    std::vector<uint32_t> m_cost_search;    //!< Search in which `m_cost` and `m_parent` were set for each cell.
+    std::vector<cell_t> m_parent;   //!< Previous jump point of each reached cell.
+    std::vector<uint64_t> m_left;   //!< Search number (high half) and jump point found jumping left from each cell.
+    std::vector<uint64_t> m_right;  //!< Search number (high half) and jump point found jumping right from each cell.
+    uint32_t m_search = 0;          //!< Number of the current search.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,86 @@
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "layout.h"
+#include "cell.h"
+#include "common.h"
+#include "hamiltonian.h"
+
+namespace snaze {
+
+/**
+ * @brief Constructs the static layer of a maze from a given 2D character vector.
+ *
+ * The characters are mapped to specific cell types, and the data that only
+ * depends on the walls is precomputed once.
+ *
+ * @param input A 2D vector of characters representing the maze.
+ *
+ * @throws std::invalid_argument if an invalid character is found in the input.
+ */
+Layout::Layout(const std::vector<std::vector<char>> &input)
+{
+    // Mapping of characters to cell types.
+    std::unordered_map<char, Cell::cell_e> map = {
+        { '#', Cell::cell_e::WALL },      //!< Wall cell.
+        { '.', Cell::cell_e::INV_WALL },  //!< Invisible wall cell.
+        { ' ', Cell::cell_e::FREE },      //!< Free space cell.
+        { '&', Cell::cell_e::SPAWN },     //!< Snake spawn cell.
+    };
+
+    // Set number of rows and columns based on input size.
+    m_rows = input.size();
+    m_cols = input[0].size();
+
+    m_cells.reserve(m_rows * m_cols);
+
+    for (size_t r = 0; r < m_rows; ++r) {
+        for (size_t c = 0; c < m_cols; ++c) {
+            char cell = input[r][c];
+
+            // Check if the character is valid and map it to the corresponding cell type.
+            if (map.find(cell) != map.end()) {
+                m_cells.push_back(Cell(map[cell]));
+
+                // Handle the snake spawn point.
+                if (map[cell] == Cell::cell_e::SPAWN)
+                    m_spawn = Position(r, c);
+            }
+            else {
+                // Throw an error if an invalid character is found.
+                std::stringstream error_msg;
+                error_msg << "Invalid character: \'" << cell << "\'.\n";
+                throw std::invalid_argument(error_msg.str());
+            }
+        }
+    }
+
+    // Hash the cells, so games can start from it.
+    for (size_t id = 0; id < m_cells.size(); ++id)
+        m_hash ^= zobrist::cell_key(id, m_cells[id].type());
+}
+
+/**
+ * @brief Returns the Hamiltonian cycle of the maze.
+ *
+ * The cycle is built by the first call, over every cell that is not a
+ * wall; copies of a level on other threads may ask for it at once.
+ *
+ * @return The cycle.
+ */
+const HamiltonianCycle &Layout::cycle() const
+{
+    std::call_once(m_cycle_built, [this] {
+        std::vector<bool> passable(m_rows * m_cols);
+        for (size_t id = 0; id < m_cells.size(); ++id) {
+            Cell::cell_e type = m_cells[id].type();
+            passable[id] = type != Cell::cell_e::WALL and type != Cell::cell_e::INV_WALL;
+        }
+        m_cycle = HamiltonianCycle(m_rows, m_cols, passable);
+    });
+
+    return m_cycle;
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,58 @@
+/**
+ * @file layout.h
+ *
+ * @description
+ * This class represents the static part of a maze: the walls, the spawn
+ * point and the data precomputed from them. It never changes during play,
+ * so every game on the same maze shares a single instance through a
+ * reference-counted pointer, and only the snake and the food are kept
+ * per game. The Hamiltonian cycle, three words per cell, is only built
+ * for the players that ask for it.
+ */
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <mutex>
+#include <vector>
+
+#include "cell.h"
+#include "common.h"
+#include "hamiltonian.h"
+#include "zobrist.h"
+
+namespace snaze {
+
+class Layout {
+public:
+    /// Default constructor.
+    Layout(const std::vector<std::vector<char>> &);
+    /// Destructor.
+    ~Layout() = default;
+
+    /// Returns the number of rows in the matrix.
+    size_t rows() const { return m_rows; }
+    /// Returns the number of cols in the matrix.
+    size_t cols() const { return m_cols; }
+    /// Returns the cells as loaded, stored row by row.
+    const std::vector<Cell> &cells() const { return m_cells; }
+    /// Returns the spawn point read from the maze.
+    Position spawn() const { return m_spawn; }
+    /// Returns the Hamiltonian cycle of the maze, built by the first call.
+    const HamiltonianCycle &cycle() const;
+    /// Returns the Zobrist hash of the cells as loaded.
+    zobrist::hash_t hash() const { return m_hash; }
+
+private:
+    size_t m_rows;              //!< The number of rows in the matrix.
+    size_t m_cols;              //!< The number of cols in the matrix.
+    std::vector<Cell> m_cells;  //!< The matrix as loaded, stored row by row.
+    Position m_spawn;           //!< The spawn point read from the maze.
+    mutable std::once_flag m_cycle_built;   //!< Builds the cycle once, whichever thread asks first.
+    mutable HamiltonianCycle m_cycle;       //!< Cycle over the cells that are not walls.
+    zobrist::hash_t m_hash = 0; //!< Hash of the cells as loaded.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -1,12 +1,19 @@
+#include <algorithm>
 #include <cstddef>
-#include <random>
+#include <cstdint>
 #include <iostream>
+#include <queue>
 #include <sstream>
-#include <stdexcept>
+#include <utility>
 
 #include "level.h"
+#include "binary_io.h"
 #include "cell.h"
 #include "common.h"
+#include "draw_cell.h"
+#include "hierarchical.h"
+#include "layout.h"
+#include "metrics.h"
 #include "snake.h"
 
 namespace snaze {
@@ -26,58 +33,52 @@ Level::render = {
 /**
  * @brief Constructs a Level object from a given 2D character vector.
  * 
- * This constructor initializes a Level object using a 2D vector of characters
- * to define the maze structure. The characters are mapped to specific cell types.
+ * This constructor builds a new static layer from a 2D vector of characters
+ * that defines the maze structure. The characters are mapped to specific
+ * cell types.
  * 
  * @param input A 2D vector of characters representing the maze.
  * 
  * @throws std::invalid_argument if an invalid character is found in the input.
  */
 Level::Level(const std::vector<std::vector<char>> &input)
+    : Level(std::make_shared<const Layout>(input))
 {
-    // Mapping of characters to cell types.
-    unmap<char, Cell::cell_e> map = {
-        { '#', Cell::cell_e::WALL },      //!< Wall cell.
-        { '.', Cell::cell_e::INV_WALL },  //!< Invisible wall cell.
-        { ' ', Cell::cell_e::FREE },      //!< Free space cell.
-        { '&', Cell::cell_e::SPAWN },     //!< Snake spawn cell.
-    };
-
-    // Set number of rows and columns based on input size.
-    m_rows = input.size();
-    m_cols = input[0].size();
-
-    // Clear the existing maze.
-    m_maze.clear();
-
-    for (size_t r = 0; r < m_rows; ++r) {
-        std::vector<Cell> buff;
-
-        for (size_t c = 0; c < m_cols; ++c) {
-            char cell = input[r][c];
-
-            // Check if the character is valid and map it to the corresponding cell type.
-            if (map.find(cell) != map.end()) {
-                buff.push_back(Cell(map[cell]));
-
-                // Handle the snake spawn point.
-                if (map[cell] == Cell::cell_e::SPAWN) {
-                    m_snake_spawn = Position(r, c);
-                    m_snake = Snake(Position(r, c));
-                    buff[c] = Cell::cell_e::SPAWN;
-                }
-            }
-            else {
-                // Throw an error if an invalid character is found.
-                std::stringstream error_msg;
-                error_msg << "Invalid character: \'" << cell << "\'.\n";
-                throw std::invalid_argument(error_msg.str());
-            }
-        }
+    /* empty */
+}
 
-        // Add the row to the maze
-        m_maze.push_back(buff);
-    }
+/**
+ * @brief Constructs a Level object over an existing static layer.
+ * 
+ * No cell is copied: the level reads the layout until a chunk of it is first
+ * modified, so any number of games can start on the same maze almost for free.
+ * 
+ * @param layout The walls and precomputed data of the maze.
+ */
+Level::Level(std::shared_ptr<const Layout> layout)
+    : m_rows(layout->rows()), m_cols(layout->cols()), m_layout(std::move(layout)),
+      m_maze(m_layout->cells()), m_snake(m_layout->spawn(), m_cols), m_snake_spawn(m_layout->spawn()),
+      m_hash(m_layout->hash())
+{
+    /* empty */
+}
+
+/**
+ * @brief Returns a copy of the current state of the maze.
+ * 
+ * The cells are stored row by row; this rebuilds them as a matrix. Hot
+ * paths should use `cell()` or `view()` instead, which do not copy.
+ * 
+ * @return The maze as a vector of rows.
+ */
+Level::maze_t Level::maze() const
+{
+    maze_t maze(m_rows);
+    for (coord_t r = 0; r < m_rows; ++r)
+        for (coord_t c = 0; c < m_cols; ++c)
+            maze[r].push_back(at(r * m_cols + c));
+
+    return maze;
 }
 
 /**
@@ -91,8 +92,8 @@ Level::Level(const std::vector<std::vector<char>> &input)
 void Level::place_snake(const Position &pos)
 {
     // Iterate through each segment of the snake's body and fill it in the maze.
-    for (const auto &segments : m_snake.body())
-        fill(segments, Cell::cell_e::SNAKE_BODY);
+    for (cell_t segment : m_snake.body())
+        fill(to_position(segment, m_cols), Cell::cell_e::SNAKE_BODY);
 
     // Fill the position of the snake's head in the maze.
     fill(pos, Cell::cell_e::SNAKE_HEAD);
@@ -110,39 +111,25 @@ void Level::place_snake(const Position &pos)
  */
 void Level::update(const Position &pos, dir_e direction, bool ate_food)
 {
+    metrics::Timer timer(metrics::UPDATE_NS);
+
     // Update the snake's direction.
     m_snake.direction(direction);
 
     // If the snake has eaten food.
     if (ate_food) {
+        // The eaten food leaves the board; `add_food()` replaces it.
+        auto eaten = std::find(m_foods.begin(), m_foods.end(), pos);
+        if (eaten != m_foods.end())
+            m_foods.erase(eaten);
+
         /**
          * @details
-         * If the snake only consists of the head, it is necessary to know 
-         * its last direction when eating the food as the tail will be 
-         * inserted in the opposite position.
+         * The head is repeated at the tail end of the body, so the tail
+         * waits one move, whatever the length of the snake; this is how
+         * `GameState` keeps a pending growth.
          */
-        Position tail;
-        if (m_snake.size() == 1) {
-            // Determine the tail position based on the direction.
-            if (direction == UP) {
-                tail = move_to(pos, DOWN);
-            }
-            else if (direction == DOWN) {
-                tail = move_to(pos, UP);
-            }
-            else if (direction == RIGHT) {
-                tail = move_to(pos, LEFT);
-            }
-            else if (direction == LEFT) {
-                tail = move_to(pos, RIGHT);
-            }
-            // Grow the snake at the tail position.
-            m_snake.grow(tail);
-        }
-        else {
-            // Grow the snake at the current position.
-            m_snake.grow(pos);
-        }
+        m_snake.grow(pos);
     }
     else {
         // Move the snake to the next position.
@@ -152,18 +139,14 @@ void Level::update(const Position &pos, dir_e direction, bool ate_food)
         Position old_tail = m_snake.move(next);
         fill(old_tail, Cell::cell_e::FREE);
 
-        // Update the maze with the new snake body and head positions.
-        if (m_snake.size() > 1) {
-            for (const Position &p : m_snake.body()) {
-                fill(p, Cell::cell_e::SNAKE_BODY);
-            }
-
-            Position head = m_snake.body().back();
-            fill(head, Cell::cell_e::SNAKE_HEAD);
-        }
-        else {
-            fill(next, Cell::cell_e::SNAKE_HEAD);
-        }
+        /**
+         * @details
+         * Only the old head and the new head change. Right after eating, the
+         * old tail repeats the old head, so the old head is filled after it.
+         */
+        if (m_snake.size() > 1)
+            fill(pos, Cell::cell_e::SNAKE_BODY);
+        fill(next, Cell::cell_e::SNAKE_HEAD);
     }
 }
 
@@ -171,28 +154,22 @@ void Level::update(const Position &pos, dir_e direction, bool ate_food)
  * @brief Resets the level to its initial state.
  * 
  * This function resets the snake to its spawn position, clears the food position,
- * and removes any snake body or head cells from the maze.
+ * and removes any snake body or head cells from the maze, by discarding the cells
+ * changed since the layout was loaded.
  */
 void Level::reset()
 {
     // Reset the snake to its spawn position.
-    m_snake = Snake(Position(m_snake_spawn));
+    m_snake = Snake(m_snake_spawn, m_cols);
 
-    // Clear the food position.
-    fill(m_food_pos, Cell::cell_e::FREE);
-
-    // Iterate through each cell in the maze.
-    for (coord_t r = 0; r < rows(); ++r) {
-        for (coord_t c = 0; c < cols(); ++c) {
-            Cell &cell = m_maze[r][c];
+    // Drop the snake and the food by going back to the shared layout.
+    m_maze.reset();
+    m_foods.clear();
+    m_hash = m_layout->hash();
 
-            // Check if the cell is part of the snake and clear it.
-            if (cell.type() == Cell::cell_e::SNAKE_HEAD || cell.type() == Cell::cell_e::SNAKE_BODY) {
-                Position pos = Position(r, c);
-                fill(pos, Cell::cell_e::FREE);
-            }
-        }
-    }
+    // The snake already left the spawn point of the layout.
+    if (not (m_snake_spawn == m_layout->spawn()))
+        fill(m_layout->spawn(), Cell::cell_e::FREE);
 }
 
 /**
@@ -213,19 +190,19 @@ bool Level::is_blocked(const Position &pos, dir_e dir) const
     switch (dir) {
         case UP:
             r = r - 1;
-            cell = m_maze[r][c];
+            cell = at(r * m_cols + c);
             return pos.row > 0 && cell.type() != Cell::cell_e::FREE && cell.type() != Cell::cell_e::FOOD;
         case DOWN:
             r = r + 1;
-            cell = m_maze[r][c];
+            cell = at(r * m_cols + c);
             return pos.row < m_rows && cell.type() != Cell::cell_e::FREE && cell.type() != Cell::cell_e::FOOD;
         case LEFT:
             c = c - 1;
-            cell = m_maze[r][c];
+            cell = at(r * m_cols + c);
             return pos.col > 0 && cell.type() != Cell::cell_e::FREE && cell.type() != Cell::cell_e::FOOD;
         case RIGHT:
             c = c + 1;
-            cell = m_maze[r][c];
+            cell = at(r * m_cols + c);
             return pos.col < m_cols && cell.type() != Cell::cell_e::FREE && cell.type() != Cell::cell_e::FOOD;
     }
 
@@ -245,7 +222,7 @@ bool Level::is_blocked(const Position &pos) const
 {
     // Check if the position is within the maze boundaries.
     if (pos.row > 0 && pos.row < rows() && pos.col > 0 && pos.col < cols()) {
-        const Cell &cell = m_maze[pos.row][pos.col];
+        const Cell &cell = at(pos.row * m_cols + pos.col);
         // Return true if the cell is not free.
         return cell.type() != Cell::cell_e::FREE;
     }
@@ -278,27 +255,39 @@ Position Level::move_to(const Position &pos, dir_e dir) const
 }
 
 /**
- * @brief Adds food to a random position in the maze.
+ * @brief Places food until the board holds as many as it should.
  * 
- * This function chooses a random position in the maze to place food. If the chosen
- * position is blocked, it recursively tries to find an unblocked position.
+ * Foods already on the board stay where they are, so after eating only
+ * the eaten one is replaced. Stops early if no free cell is left.
  */
 void Level::add_food()
 {
-    // Choose a random position to spawn food.
-    Position spawn_food = choose_position();
-
-    // If the position is blocked, recursively try to add food again.
-    if (is_blocked(spawn_food)) {
-        add_food();
-    }
-    else {
-        // Place food at the chosen position and update the food position.
-        fill(spawn_food, Cell::cell_e::FOOD);
-        m_food_pos = spawn_food;
+    while (m_foods.size() < m_board and place_food()) {
+        /* empty */
     }
 }
 
+/**
+ * @brief Places one food on a free cell drawn by `draw_cell()`.
+ * 
+ * @return true if a food was placed, false if the maze is full.
+ */
+bool Level::place_food()
+{
+    cell_t id = draw_cell(m_rng, m_rows, m_cols, [this](cell_t cell) {
+        return at(cell).type() == Cell::cell_e::FREE;
+    });
+    if (id == NO_CELL)
+        return false;
+
+    // Place food at the chosen position and update the food position.
+    Position spawn_food = to_position(id, m_cols);
+    fill(spawn_food, Cell::cell_e::FOOD);
+    m_foods.push_back(spawn_food);
+    m_food_pos = spawn_food;
+    return true;
+}
+
 /**
  * @brief Sets a new spawn position for the snake.
  * 
@@ -312,34 +301,24 @@ void Level::spawn(const Position &new_spawn)
 }
 
 /**
- * @brief Chooses a random position within the maze.
+ * @brief Builds the cluster graph used by the hierarchical planner.
  * 
- * This function generates a random position within the bounds of the maze
- * using a uniform distribution for both rows and columns.
+ * The graph only depends on the walls, so it must be built before the snake
+ * is placed. Copies of the level share it and never change it; each
+ * planner keeps the repairs of the clusters the snake moves through.
  * 
- * @return A randomly chosen position within the maze.
+ * @param cluster_size The side of a cluster, in cells.
  */
-Position Level::choose_position() const
+void Level::build_hierarchy(size_t cluster_size)
 {
-    std::random_device rd;
-    std::mt19937 rng(rd());
-
-    // Define uniform distributions for rows and columns within valid ranges.
-    std::uniform_int_distribution<size_t> random_row(0, rows() - 1);
-    std::uniform_int_distribution<size_t> random_col(0, cols() - 1);
-
-    // Generate random row and column indices.
-    size_t r = random_row(rng);
-    size_t c = random_col(rng);
-
-    return Position(r, c);
+    m_hierarchy = std::make_shared<HierarchicalMap>(*this, cluster_size);
 }
 
 /**
  * @brief Fills a cell at the given position with the specified cell type.
  * 
  * This function updates the cell at the specified position in the maze
- * with the provided cell type.
+ * with the provided cell type, and updates the hash of the cells in O(1).
  * 
  * @param pos The position in the maze to fill.
  * @param cell_type The type of cell to fill the position with.
@@ -347,12 +326,136 @@ Position Level::choose_position() const
 void Level::fill(const Position &pos, Cell::cell_e cell_type)
 {
     // Get a reference to the cell at the specified position.
-    Cell &cell = m_maze[pos.row][pos.col];
-    
+    cell_t id = to_cell(pos, m_cols);
+    Cell &cell = m_maze.write(id);
+
+    // Swap the key of the old type for the key of the new one.
+    m_hash ^= zobrist::cell_key(id, cell.type()) ^ zobrist::cell_key(id, cell_type);
+
     // Set the cell type to the specified value.
     cell.type(cell_type);
 }
 
+/**
+ * @brief Appends the state of the level to a buffer.
+ *
+ * The walls are not written, since they come with the layout; only the
+ * cells that differ from it are, as the gap from the previous one and the
+ * new type. Every number is a varint, see binary_io.h.
+ *
+ * @param out The buffer to append to.
+ */
+void Level::save(std::string &out) const
+{
+    const auto &body = m_snake.body();
+    binary::put_varint(out, body.size());
+    for (cell_t segment : body)
+        binary::put_varint(out, segment);
+    binary::put_varint(out, m_snake.direction());
+
+    binary::put_varint(out, to_cell(m_snake_spawn, m_cols));
+    binary::put_varint(out, to_cell(m_food_pos, m_cols));
+    binary::put_varint(out, m_foods.size());
+    for (const Position &food : m_foods)
+        binary::put_varint(out, to_cell(food, m_cols));
+    binary::put_varint(out, m_board);
+    binary::put_varint(out, m_rng.state());
+
+    // Only the copied chunks may differ from the layout; the gaps need them in order.
+    std::vector<size_t> chunks = m_maze.copied();
+    std::sort(chunks.begin(), chunks.end());
+
+    const auto &base = m_layout->cells();
+    std::string changes;
+    size_t count = 0, last = 0;
+    for (size_t chunk : chunks) {
+        const size_t first = chunk * CellOverlay::CHUNK, end = std::min(first + CellOverlay::CHUNK, base.size());
+        for (size_t id = first; id < end; ++id) {
+            if (m_maze[id].type() == base[id].type())
+                continue;
+            binary::put_varint(changes, id - last);
+            binary::put_varint(changes, static_cast<uint64_t>(m_maze[id].type()));
+            last = id;
+            ++count;
+        }
+    }
+    binary::put_varint(out, m_maze.modified() ? count + 1 : 0);
+    out += changes;
+}
+
+/**
+ * @brief Restores the state of the level from a buffer.
+ *
+ * The level must be on the same maze as the one saved. The hashes are
+ * rebuilt from the restored cells and snake.
+ *
+ * @param in The buffer to read from.
+ * @param offset Where the state starts; moved past it.
+ * @return true if the state was restored, false if it is cut short or does not fit the maze.
+ */
+bool Level::load(const std::string &in, size_t &offset)
+{
+    const uint64_t cells = m_rows * m_cols;
+    uint64_t size, value;
+    auto cell = [&](uint64_t &id) { return binary::get_varint(in, offset, id) and id < cells; };
+
+    if (not binary::get_varint(in, offset, size) or size == 0 or size > cells + 1)
+        return false;
+    std::vector<cell_t> body(size);
+    for (cell_t &segment : body) {
+        if (not cell(value))
+            return false;
+        segment = static_cast<cell_t>(value);
+    }
+    uint64_t direction, spawn, food, foods;
+    if (not binary::get_varint(in, offset, direction) or direction > RIGHT or not cell(spawn) or not cell(food))
+        return false;
+    if (not binary::get_varint(in, offset, foods) or foods > cells)
+        return false;
+    std::vector<Position> food_list(foods);
+    for (Position &pos : food_list) {
+        if (not cell(value))
+            return false;
+        pos = to_position(static_cast<cell_t>(value), m_cols);
+    }
+    uint64_t board, rng, changes;
+    if (not binary::get_varint(in, offset, board) or not binary::get_varint(in, offset, rng)
+            or not binary::get_varint(in, offset, changes))
+        return false;
+
+    // The hash follows the cells as they are written over the layout.
+    CellOverlay maze(m_layout->cells());
+    zobrist::hash_t hash = m_layout->hash();
+    uint64_t id = 0, gap, type;
+    for (uint64_t i = 1; i < changes; ++i) {
+        if (not binary::get_varint(in, offset, gap) or not binary::get_varint(in, offset, type))
+            return false;
+        id += gap;
+        if (id >= cells or type > static_cast<uint64_t>(Cell::cell_e::DEATH_SNAKE_BODY))
+            return false;
+
+        Cell &cell = maze.write(id);
+        hash ^= zobrist::cell_key(id, cell.type()) ^ zobrist::cell_key(id, static_cast<Cell::cell_e>(type));
+        cell.type(static_cast<Cell::cell_e>(type));
+    }
+
+    // Rebuild the snake from the head backwards, as eating grows it.
+    m_snake = Snake(to_position(body.back(), m_cols), m_cols);
+    for (size_t i = body.size() - 1; i-- > 0;)
+        m_snake.grow(to_position(body[i], m_cols));
+    m_snake.direction(static_cast<dir_e>(direction));
+
+    m_snake_spawn = to_position(static_cast<cell_t>(spawn), m_cols);
+    m_food_pos = to_position(static_cast<cell_t>(food), m_cols);
+    m_foods = std::move(food_list);
+    m_board = board;
+    m_rng = Rng(rng);
+    m_maze = std::move(maze);
+    m_hash = hash;
+
+    return true;
+}
+
 /**
  * @brief Converts the maze into a string representation.
  * 
@@ -369,7 +472,7 @@ std::string Level::to_string() const
     // Iterate through each cell in the maze.
     for (coord_t r = 0; r < rows(); ++r) {
         for (coord_t c = 0; c < cols(); ++c) {
-            Cell cell = m_maze[r][c];
+            Cell cell = at(r * m_cols + c);
 
             // Determine the character representation based on the cell type.
             if (cell.type() == Cell::cell_e::SNAKE_HEAD) {
@@ -3,22 +3,36 @@
  *
  * @description
  * This class represents the maze.
+ * Any number of foods may lie on the board at once; the planners head for
+ * whichever of them they reach first or find nearest.
+ * The walls live in a Layout shared by every copy of the level; the level
+ * itself only owns the snake, the food and the chunks of cells they
+ * changed, each copied from the layout the first time it is modified.
  */
 
 #ifndef LEVEL_H
 #define LEVEL_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <unordered_map>
 
 #include "cell.h"
+#include "cell_overlay.h"
 #include "common.h"
+#include "grid_view.h"
+#include "hamiltonian.h"
+#include "layout.h"
+#include "rng.h"
 #include "snake.h"
+#include "zobrist.h"
 
 namespace snaze {
 
+class HierarchicalMap;
+
 class Level {
 public:
     //== Aliases
@@ -31,6 +45,8 @@ public:
     Level() = default;
     /// Default constructor.
     Level(const std::vector<std::vector<char>> &);
+    /// Creates a level over a shared static layer.
+    Level(std::shared_ptr<const Layout>);
     /// Destructor.
     ~Level() = default;
 
@@ -41,8 +57,12 @@ public:
     coord_t rows() const { return m_rows; }
     /// Returns the number of cols in the matrix.
     coord_t cols() const { return m_cols; }
-    /// Returns the current state of the maze.
-    maze_t maze() const { return m_maze; }
+    /// Returns a copy of the current state of the maze.
+    maze_t maze() const;
+    /// Returns a read-only view of the cells, valid while the level is alive.
+    GridView view() const { return GridView(m_maze.chunks(), m_rows, m_cols); }
+    /// Returns the static layer shared by every copy of the level.
+    std::shared_ptr<const Layout> layout() const { return m_layout; }
 
     /// Given a coordinate in the matrix, fill the cell with the cell type.
     void fill(const Position &, Cell::cell_e);
@@ -57,29 +77,66 @@ public:
     Position spawn() const { return m_snake_spawn; }
     /// Sets the initial position of the snake.
     void spawn(const Position &);
-    /// Returns the position of the food in the maze.
+    /// Returns the snake currently placed in the maze.
+    const Snake &snake() const { return m_snake; }
+    /// Returns the type of the cell at the given position.
+    Cell::cell_e cell(const Position &pos) const { return at(pos.row * m_cols + pos.col).type(); }
+    /// Returns the Hamiltonian cycle of the maze, built by the first call.
+    const HamiltonianCycle &cycle() const { return m_layout->cycle(); }
+    /// Builds the cluster graph used by the hierarchical planner.
+    void build_hierarchy(size_t cluster_size = 16);
+    /// Returns the cluster graph of the maze, or nullptr if it was not built.
+    const HierarchicalMap *hierarchy() const { return m_hierarchy.get(); }
+    /// Returns the position of the newest food.
     Position food() const { return m_food_pos; }
-    /// Sets the position of the food in the maze.
+    /// Returns the positions of every food on the board, oldest first.
+    const std::vector<Position> &foods() const { return m_foods; }
+    /// Returns how many foods are kept on the board at once.
+    size_t board() const { return m_board; }
+    /// Sets how many foods are kept on the board at once.
+    void board(size_t count) { m_board = count; }
+    /// Places food until the board holds as many as it should, or no cell is left.
     void add_food();
+    /// Seeds the generator used to place the food.
+    void seed(Rng::state_t seed) { m_rng = Rng(seed); }
+    /// Returns the generator used to place the food.
+    const Rng &rng() const { return m_rng; }
     /// Checks whether a position is blocked in the maze.
     bool is_blocked(const Position &, dir_e) const;
     bool is_blocked(const Position &) const;
     /// Returns the position of the neighbor cell based on the provided direction.
     Position move_to(const Position &, dir_e) const;
 
+    /// Returns the Zobrist hash of the cells and the snake, kept up to date by every change.
+    zobrist::hash_t hash() const { return m_hash ^ m_snake.hash(); }
+
     /// Returns the ASCII representation of the maze.
     std::string to_string() const;
 
+    /// Appends the snake, the foods, the generator and the changed cells to a buffer.
+    void save(std::string &out) const;
+    /// Restores what `save()` wrote on a level of the same maze; false if the data is invalid.
+    bool load(const std::string &in, size_t &offset);
+
 private:
-    /// Returns a random position in the maze.
-    Position choose_position() const;
+    /// Places one food on a random free cell, if any is left.
+    bool place_food();
+    /// Returns the cell at a linear index, from the overlay or the layout.
+    const Cell &at(size_t id) const { return m_maze[id]; }
 
-    coord_t m_rows;             //!< The number of rows in the matrix.
-    coord_t m_cols;             //!< The number of cols in the matrix.
-    maze_t m_maze;              //!< The matrix.
+    coord_t m_rows = 0;         //!< The number of rows in the matrix.
+    coord_t m_cols = 0;         //!< The number of cols in the matrix.
+    std::shared_ptr<const Layout> m_layout;  //!< Walls and precomputed data, shared by copies.
+    CellOverlay m_maze;                      //!< The matrix, stored row by row over the layout.
     Snake m_snake;              //!< The snake to be inserted into the maze.
     Position m_snake_spawn;     //!< The initial position of the snake.
-    Position m_food_pos;        //!< The position of the food in the maze.
+    Position m_food_pos;        //!< The position of the newest food.
+    std::vector<Position> m_foods;  //!< Every food on the board, oldest first.
+    size_t m_board = 1;         //!< Foods kept on the board at once.
+    Rng m_rng;                  //!< Generator of the food positions.
+    zobrist::hash_t m_hash = 0; //!< Hash of the cells, without the snake links.
+
+    std::shared_ptr<const HierarchicalMap> m_hierarchy;  //!< Cluster graph over the walls, shared by copies.
 };
 
 } // NAMESPACE SNAZE
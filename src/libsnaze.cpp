@@ -0,0 +1,322 @@
+#include <iterator>
+#include <list>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "libsnaze.h"
+#include "cell.h"
+#include "common.h"
+#include "game_state.h"
+#include "layout.h"
+#include "maze_file.h"
+#include "observer.h"
+#include "session.h"
+
+// The constants of the C interface are the values of the enums they mirror.
+static_assert(sizeof(snaze::Cell::cell_e) == 1, "A board holds one byte per cell.");
+static_assert(SNAZE_CELL_WALL == static_cast<int>(snaze::Cell::cell_e::WALL)
+          and SNAZE_CELL_INV_WALL == static_cast<int>(snaze::Cell::cell_e::INV_WALL)
+          and SNAZE_CELL_FREE == static_cast<int>(snaze::Cell::cell_e::FREE)
+          and SNAZE_CELL_FOOD == static_cast<int>(snaze::Cell::cell_e::FOOD)
+          and SNAZE_CELL_SPAWN == static_cast<int>(snaze::Cell::cell_e::SPAWN)
+          and SNAZE_CELL_SNAKE_HEAD == static_cast<int>(snaze::Cell::cell_e::SNAKE_HEAD)
+          and SNAZE_CELL_SNAKE_BODY == static_cast<int>(snaze::Cell::cell_e::SNAKE_BODY),
+              "SNAZE_CELL_* must match snaze::Cell::cell_e.");
+static_assert(SNAZE_UP == static_cast<int>(snaze::UP) and SNAZE_LEFT == static_cast<int>(snaze::LEFT)
+          and SNAZE_DOWN == static_cast<int>(snaze::DOWN) and SNAZE_RIGHT == static_cast<int>(snaze::RIGHT),
+              "SNAZE_UP to SNAZE_RIGHT must match snaze::dir_e.");
+static_assert(SNAZE_MOVED == static_cast<int>(snaze::GameState::outcome_e::MOVED)
+          and SNAZE_ATE == static_cast<int>(snaze::GameState::outcome_e::ATE)
+          and SNAZE_DIED == static_cast<int>(snaze::GameState::outcome_e::DIED),
+              "SNAZE_MOVED, SNAZE_ATE and SNAZE_DIED must match snaze::GameState::outcome_e.");
+static_assert(SNAZE_FORMAT_CODES == static_cast<int>(snaze::Observer::format_e::CODES)
+          and SNAZE_FORMAT_PLANES == static_cast<int>(snaze::Observer::format_e::PLANES)
+          and SNAZE_FORMAT_WINDOW == static_cast<int>(snaze::Observer::format_e::WINDOW),
+              "SNAZE_FORMAT_* must match snaze::Observer::format_e.");
+
+/// The opaque handle of the C interface.
+struct snaze_session {
+    snaze::Session session; //!< The game behind the handle.
+};
+
+/// The opaque observer of the C interface.
+struct snaze_observer {
+    snaze::Observer observer; //!< The observer behind the handle.
+};
+
+namespace {
+
+/**
+ * @brief Creates a session on a maze and starts an episode with seed 0, catching every error.
+ *
+ * @param maze The rows of the maze.
+ * @param lives The lives at the start of an episode.
+ * @param foods The foods that win an episode.
+ * @return The new session, or NULL if the maze is invalid.
+ */
+snaze_session *create(const snaze::maze_t &maze, unsigned lives, unsigned foods)
+{
+    if (maze.empty() or maze.front().empty())
+        return nullptr;
+
+    try {
+        auto layout = std::make_shared<const snaze::Layout>(maze);
+        auto session = std::make_unique<snaze_session>(snaze_session{ snaze::Session(layout, lives, foods) });
+        session->session.reset(0);
+        return session.release();
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Checks whether a session is on a maze of the size of an observer.
+ *
+ * The observer reads the cells of the game without bounds checks, so a
+ * board is only written for a maze of the size it was created for.
+ *
+ * @param observer The observer.
+ * @param session The session.
+ * @return true if the maze of the session has the rows and cols of the observer.
+ */
+bool fits(const snaze_observer *observer, const snaze_session *session)
+{
+    const snaze::Layout &layout = *session->session.layout();
+    return layout.rows() == observer->observer.rows() and layout.cols() == observer->observer.cols();
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Creates a session on a maze of a level file.
+ *
+ * @param path The path to the level file.
+ * @param level The index of the maze in the file, from 0.
+ * @param lives The lives at the start of an episode.
+ * @param foods The foods that win an episode.
+ * @return The new session, or NULL if the file or the maze is invalid.
+ */
+snaze_session *snaze_create(const char *path, size_t level, unsigned lives, unsigned foods)
+{
+    std::list<snaze::maze_t> mazes;
+    if (path == nullptr or not snaze::read_mazes(std::string(path), mazes) or level >= mazes.size())
+        return nullptr;
+
+    return create(*std::next(mazes.begin(), level), lives, foods);
+}
+
+/**
+ * @brief Creates a session on a maze given as text.
+ *
+ * @param text The rows of the maze, one per line, in the level file format.
+ * @param rows The number of rows to read.
+ * @param lives The lives at the start of an episode.
+ * @param foods The foods that win an episode.
+ * @return The new session, or NULL if the text is too short or the maze is invalid.
+ */
+snaze_session *snaze_create_grid(const char *text, size_t rows, unsigned lives, unsigned foods)
+{
+    if (text == nullptr)
+        return nullptr;
+
+    std::istringstream in(text);
+    snaze::maze_t maze;
+    std::string line;
+    for (size_t r = 0; r < rows; ++r) {
+        if (not std::getline(in, line))
+            return nullptr;
+        maze.emplace_back(line.begin(), line.end());
+    }
+
+    return create(maze, lives, foods);
+}
+
+/**
+ * @brief Destroys a session.
+ *
+ * @param session The session to destroy, or NULL.
+ */
+void snaze_destroy(snaze_session *session)
+{
+    delete session;
+}
+
+/**
+ * @brief Starts a new episode.
+ *
+ * @param session The session.
+ * @param seed The seed of the food positions.
+ * @return 0, or -1 if the episode cannot be started.
+ */
+int snaze_reset(snaze_session *session, uint64_t seed)
+{
+    try {
+        session->session.reset(seed);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+/**
+ * @brief Moves the snake one cell.
+ *
+ * @param session The session.
+ * @param direction One of the `SNAZE_UP`, `SNAZE_LEFT`, `SNAZE_DOWN` or `SNAZE_RIGHT` constants.
+ * @param reward Where to store the reward of the step, or NULL.
+ * @param done Where to store whether the episode ended, or NULL.
+ * @return The outcome of the step, or -1 if the direction is invalid or the step failed.
+ */
+int snaze_step(snaze_session *session, int direction, float *reward, int *done)
+{
+    if (direction < SNAZE_UP or direction > SNAZE_RIGHT)
+        return -1;
+
+    try {
+        auto transition = session->session.step(static_cast<snaze::dir_e>(direction));
+        if (reward != nullptr)
+            *reward = transition.reward;
+        if (done != nullptr)
+            *done = transition.done;
+
+        return static_cast<int>(transition.outcome);
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+/**
+ * @brief Fills an observation of the game, without copying the board.
+ *
+ * @param session The session.
+ * @param observation The observation to fill.
+ */
+void snaze_observe(const snaze_session *session, snaze_observation *observation)
+{
+    auto view = session->session.observe();
+
+    observation->cells = reinterpret_cast<const uint8_t *>(view.cells);
+    observation->rows = static_cast<uint32_t>(view.rows);
+    observation->cols = static_cast<uint32_t>(view.cols);
+    observation->head = view.head;
+    observation->food = view.food;
+    observation->direction = view.direction;
+    observation->length = static_cast<uint32_t>(view.length);
+    observation->score = view.score;
+    observation->lives = view.lives;
+    observation->foods = view.foods;
+    observation->done = view.done;
+    observation->won = view.won;
+}
+
+/**
+ * @brief Creates an observer for the maze of a session.
+ *
+ * @param session The session whose maze is observed; any session on the same maze may be filled.
+ * @param format One of the `SNAZE_FORMAT_*` constants.
+ * @param radius Cells on each side of the head in `SNAZE_FORMAT_WINDOW`.
+ * @return The new observer, or NULL if the format is invalid or the observer cannot be created.
+ */
+snaze_observer *snaze_observer_create(const snaze_session *session, int format, size_t radius)
+{
+    if (format < SNAZE_FORMAT_CODES or format > SNAZE_FORMAT_WINDOW)
+        return nullptr;
+
+    try {
+        auto type = static_cast<snaze::Observer::format_e>(format);
+        return new snaze_observer{ snaze::Observer(*session->session.layout(), type, radius) };
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Destroys an observer.
+ *
+ * @param observer The observer to destroy, or NULL.
+ */
+void snaze_observer_destroy(snaze_observer *observer)
+{
+    delete observer;
+}
+
+/**
+ * @brief Stores the shape of a board.
+ *
+ * @param observer The observer.
+ * @param shape Where to store the channels, the height and the width.
+ */
+void snaze_observer_shape(const snaze_observer *observer, size_t shape[3])
+{
+    shape[0] = observer->observer.channels();
+    shape[1] = observer->observer.height();
+    shape[2] = observer->observer.width();
+}
+
+/**
+ * @brief Returns the number of bytes of a board.
+ *
+ * @param observer The observer.
+ * @return The product of the shape.
+ */
+size_t snaze_observer_size(const snaze_observer *observer)
+{
+    return observer->observer.size();
+}
+
+/**
+ * @brief Writes the board of a session into a buffer.
+ *
+ * @param observer The observer.
+ * @param session The session, on the maze of the observer.
+ * @param out The board, `snaze_observer_size()` bytes.
+ * @return 0, or -1 if the board cannot be written, as when the maze of the
+ * session is not of the size of the observer's; nothing is written then.
+ */
+int snaze_observer_fill(const snaze_observer *observer, const snaze_session *session, uint8_t *out)
+{
+    if (not fits(observer, session))
+        return -1;
+
+    try {
+        session->session.observe(observer->observer, out);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+/**
+ * @brief Writes the boards of many sessions into a buffer.
+ *
+ * @param observer The observer.
+ * @param sessions The sessions, all on the maze of the observer.
+ * @param count The number of sessions.
+ * @param out The boards, session after session, `count * snaze_observer_size()` bytes.
+ * @return 0, or -1 if a board cannot be written. Every maze is checked
+ * against the size of the observer first, so a session on another maze
+ * fails the batch before any board is written.
+ */
+int snaze_observer_fill_batch(const snaze_observer *observer, const snaze_session *const *sessions, size_t count, uint8_t *out)
+{
+    for (size_t i = 0; i < count; ++i)
+        if (not fits(observer, sessions[i]))
+            return -1;
+
+    try {
+        const size_t size = observer->observer.size();
+        for (size_t i = 0; i < count; ++i)
+            sessions[i]->session.observe(observer->observer, out + i * size);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
@@ -0,0 +1,124 @@
+/**
+ * @file libsnaze.h
+ *
+ * @description
+ * C interface of the game library, for loading it from other languages.
+ * A session is an opaque handle over `snaze::Session`: create it from a
+ * level file or from the text of a maze, with an episode started from
+ * seed 0, start another one with a seed, step it with a direction and
+ * read the board with an observation. No
+ * function prints, reads input or sleeps, and none lets an exception out;
+ * failures are reported by the return value.
+ *
+ * The board of an observation points into the session and stays valid
+ * until the next call to `snaze_step()`, `snaze_reset()` or
+ * `snaze_destroy()`. It holds one byte per cell, row by row, with the
+ * values of the `SNAZE_CELL_*` constants.
+ *
+ * An observer writes the board into a buffer of the caller instead, in
+ * one of the `SNAZE_FORMAT_*` layouts described in observer.h: a dense
+ * C-order array of bytes of shape `channels x height x width`, repeated
+ * session after session by `snaze_observer_fill_batch()`. Nothing is
+ * allocated by a fill, so the buffer can be wrapped as a tensor once.
+ */
+
+#ifndef LIBSNAZE_H
+#define LIBSNAZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// A running game, created by `snaze_create()` or `snaze_create_grid()`.
+typedef struct snaze_session snaze_session;
+
+/// Type of a cell of the board, as `snaze::Cell::cell_e`.
+enum {
+    SNAZE_CELL_WALL = 0,
+    SNAZE_CELL_INV_WALL,
+    SNAZE_CELL_FREE,
+    SNAZE_CELL_FOOD,
+    SNAZE_CELL_SPAWN,
+    SNAZE_CELL_SNAKE_HEAD,
+    SNAZE_CELL_SNAKE_BODY,
+};
+
+/// Direction of a move, as `snaze::dir_e`.
+enum {
+    SNAZE_UP = 0,
+    SNAZE_LEFT,
+    SNAZE_DOWN,
+    SNAZE_RIGHT,
+};
+
+/// What a step did, as `snaze::GameState::outcome_e`.
+enum {
+    SNAZE_MOVED = 0,
+    SNAZE_ATE,
+    SNAZE_DIED,
+};
+
+/// Layout of the boards written by an observer, as `snaze::Observer::format_e`.
+enum {
+    SNAZE_FORMAT_CODES = 0,
+    SNAZE_FORMAT_PLANES,
+    SNAZE_FORMAT_WINDOW,
+};
+
+/// Cell index of the head or the food when there is none.
+#define SNAZE_NO_CELL UINT32_MAX
+
+/// Writes boards of one maze into caller buffers, created by `snaze_observer_create()`.
+typedef struct snaze_observer snaze_observer;
+
+/// A view of the game; see the file comment for how long `cells` lives.
+typedef struct snaze_observation {
+    const uint8_t *cells;   //!< Type of each cell, row by row.
+    uint32_t rows;          //!< The number of rows in the maze.
+    uint32_t cols;          //!< The number of cols in the maze.
+    uint32_t head;          //!< Cell of the snake head, row * cols + col.
+    uint32_t food;          //!< Cell of the newest food, or SNAZE_NO_CELL if the maze is full.
+    uint32_t direction;     //!< Direction of the last move.
+    uint32_t length;        //!< Number of cells taken by the snake.
+    uint32_t score;         //!< Score in the episode.
+    uint32_t lives;         //!< Remaining lives.
+    uint32_t foods;         //!< Foods eaten in the episode.
+    uint8_t done;           //!< Whether the episode ended.
+    uint8_t won;            //!< Whether the episode ended by eating every food.
+} snaze_observation;
+
+/// Creates a session on a maze of a level file, with an episode started from seed 0, or returns NULL.
+snaze_session *snaze_create(const char *path, size_t level, unsigned lives, unsigned foods);
+/// Creates a session on a maze given as `rows` lines of text, as `snaze_create()`, or returns NULL.
+snaze_session *snaze_create_grid(const char *text, size_t rows, unsigned lives, unsigned foods);
+/// Destroys a session; NULL is ignored.
+void snaze_destroy(snaze_session *);
+
+/// Starts a new episode, placing the foods from a seed; returns 0, or -1 on failure.
+int snaze_reset(snaze_session *, uint64_t seed);
+/// Moves the snake once and returns a `SNAZE_*` outcome, or -1 for a bad direction or a failure.
+int snaze_step(snaze_session *, int direction, float *reward, int *done);
+/// Fills an observation of the game.
+void snaze_observe(const snaze_session *, snaze_observation *);
+
+/// Creates an observer for the maze of a session, or returns NULL for a bad format or a failure.
+snaze_observer *snaze_observer_create(const snaze_session *, int format, size_t radius);
+/// Destroys an observer; NULL is ignored.
+void snaze_observer_destroy(snaze_observer *);
+/// Stores the channels, height and width of a board.
+void snaze_observer_shape(const snaze_observer *, size_t shape[3]);
+/// Returns the number of bytes of a board.
+size_t snaze_observer_size(const snaze_observer *);
+/// Writes the board of a session, on the maze of the observer; returns 0, or -1 on failure or a maze of another size.
+int snaze_observer_fill(const snaze_observer *, const snaze_session *, uint8_t *out);
+/// Writes the boards of many sessions, one after the other; returns 0, or -1 on failure or a maze of another size.
+int snaze_observer_fill_batch(const snaze_observer *, const snaze_session *const *sessions, size_t count, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
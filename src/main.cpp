@@ -13,7 +13,6 @@
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
-#include <fstream>
 #include <iostream>
 #include <string>
 #include <limits>
@@ -22,65 +21,10 @@
 #include <thread>
 #include <list>
 #include "common.h"
+#include "maze_file.h"
 #include "snake_game.h"
 #include "cmd_parse.h"
-
-#define READ_OK 0
-#define READ_FAILED 1
-
-using maze = std::vector<std::vector<char>>;
-
-/**
- * @brief Reads mazes from a file and stores them in a list.
- *
- * This function reads a file containing multiple mazes, each defined by
- * its number of rows and columns followed by the maze layout. Each maze is
- * stored as a vector of vectors of characters, representing the grid layout.
- * The function stores these mazes in a list.
- *
- * @param path The path to the input file containing maze definitions.
- * @param mazes A reference to a list where the read mazes will be stored.
- * @return READ_OK if the file is read successfully, READ_FAILED otherwise.
- */
-int read_file(const std::string &path, std::list<maze> &mazes)
-{
-    std::ifstream fin(path);
-
-    if (not fin.is_open()) return READ_FAILED; // Unable to open file.
-
-    while (true) {
-        size_t rows, cols;
-        if (not (fin >> rows >> cols)) {
-            if (fin.eof()) break;   // End of file reached.
-
-            return READ_FAILED;     // Error reading dimensions.
-        }
-
-        fin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignore rest of the first line.
-
-        std::string line;
-        maze maze;
-        for (size_t r = 0; r < rows; ++r) {
-            std::vector<char> buff;
-
-            if (std::getline(fin, line)) { // Read each line of the maze.
-                for (const char &c : line) {
-                    buff.push_back(c); // Store each character in the row vector.
-                }
-                maze.push_back(buff); // Store the row vector in the maze.
-            } 
-            else {
-                return READ_FAILED; // Error reading line.
-            }
-        }
-
-        mazes.push_back(maze);
-    }
-
-    fin.close();
-
-    return READ_OK; // Successfully read maze.
-}
+#include "trace.h"
 
 /**
  * @brief Clears the console screen and moves the cursor to the top-left corner.
@@ -127,24 +71,27 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
-    std::list<maze> levels;
+    std::list<snaze::maze_t> levels;
 
-    int read = read_file(runOpt.level_path, levels);
-
-    if (read == READ_FAILED) {
+    if (not snaze::read_mazes(runOpt.level_path, levels)) {
         std::cerr << "Unable to read file: " << strerror(errno) << ".\n";
         return EXIT_FAILURE;
     }
 
     snaze::SnakeGame snaze(runOpt);
-    snaze.initialize(levels);
+    if (not snaze.initialize(levels))
+        return EXIT_FAILURE;
 
     while (not snaze.game_over()) {
         snaze.process_events();
         snaze.update();
-        refresh();
+        if (snaze.drawing())
+            refresh();
         snaze.render();
-        wait(snaze.fps());
+        if (snaze.drawing()) {
+            snaze::trace::Span span("wait", snaze.trace_tags());
+            wait(snaze.fps());
+        }
     }
 
     return EXIT_SUCCESS;
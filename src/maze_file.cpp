@@ -0,0 +1,78 @@
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include "maze_file.h"
+
+namespace snaze {
+
+/**
+ * @brief Reads every maze of a stream and stores them in a list.
+ *
+ * Each maze is defined by its number of rows and columns followed by the
+ * maze layout, and is stored as a vector of vectors of characters.
+ *
+ * @param in The stream holding the maze definitions.
+ * @param mazes A reference to a list where the read mazes will be stored.
+ * @return true if the stream is read successfully, false otherwise.
+ */
+bool read_mazes(std::istream &in, std::list<maze_t> &mazes)
+{
+    while (true) {
+        size_t rows, cols;
+        if (not (in >> rows >> cols)) {
+            if (in.eof()) break;   // End of file reached.
+
+            return false;          // Error reading dimensions.
+        }
+
+        in.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignore rest of the first line.
+
+        std::string line;
+        maze_t maze;
+        for (size_t r = 0; r < rows; ++r) {
+            if (not std::getline(in, line))
+                return false;      // Error reading line.
+
+            maze.emplace_back(line.begin(), line.end());
+        }
+
+        mazes.push_back(maze);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads every maze of a level file and stores them in a list.
+ *
+ * @param path The path to the input file containing maze definitions.
+ * @param mazes A reference to a list where the read mazes will be stored.
+ * @return true if the file is read successfully, false otherwise.
+ */
+bool read_mazes(const std::string &path, std::list<maze_t> &mazes)
+{
+    std::ifstream fin(path);
+
+    if (not fin.is_open()) return false; // Unable to open file.
+
+    return read_mazes(fin, mazes);
+}
+
+/**
+ * @brief Appends a maze to a stream in the level file format.
+ *
+ * @param out The stream, a level file that may already hold other mazes.
+ * @param maze The maze.
+ */
+void write_maze(std::ostream &out, const maze_t &maze)
+{
+    out << maze.size() << ' ' << (maze.empty() ? 0 : maze.front().size()) << '\n';
+
+    for (const auto &row : maze) {
+        out.write(row.data(), row.size());
+        out.put('\n');
+    }
+}
+
+} // NAMESPACE SNAZE
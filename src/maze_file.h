@@ -0,0 +1,33 @@
+/**
+ * @file maze_file.h
+ *
+ * @description
+ * Reading and writing of level files. A file holds any number of mazes, each one a
+ * line with its number of rows and cols followed by that many rows of
+ * characters.
+ */
+
+#ifndef MAZE_FILE_H
+#define MAZE_FILE_H
+
+#include <istream>
+#include <ostream>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace snaze {
+
+//== Aliases
+using maze_t = std::vector<std::vector<char>>;
+
+/// Reads every maze of a stream, in order.
+bool read_mazes(std::istream &, std::list<maze_t> &);
+/// Reads every maze of a level file, in order.
+bool read_mazes(const std::string &path, std::list<maze_t> &);
+/// Appends a maze to a stream in the level file format.
+void write_maze(std::ostream &, const maze_t &);
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "maze_gen.h"
+
+namespace snaze {
+
+namespace {
+
+constexpr char WALL = '#';      //!< Character of a wall.
+constexpr char FREE = ' ';      //!< Character of a free cell.
+constexpr char SPAWN = '&';     //!< Character of the spawn.
+constexpr size_t ROOM_BLOCK = 12;   //!< Side of the block each room is drawn in.
+
+/// Random bits drawn 64 at a time, for the many coin flips of a large maze.
+class Coins {
+public:
+    /// Draws from a generator.
+    explicit Coins(Rng &rng) : m_rng(rng) { /* empty */ }
+
+    /// Returns a random bit.
+    bool flip() {
+        if (m_left == 0) {
+            m_bits = m_rng.next();
+            m_left = 64;
+        }
+        --m_left;
+        bool bit = m_bits & 1;
+        m_bits >>= 1;
+        return bit;
+    }
+
+private:
+    Rng &m_rng;             //!< The generator.
+    uint64_t m_bits = 0;    //!< Bits not used yet.
+    unsigned m_left = 0;    //!< Number of bits not used yet.
+};
+
+/**
+ * @brief Carves a perfect maze with Eller's algorithm.
+ *
+ * The cells sit at odd coordinates and the maze is carved one row of cells
+ * at a time, keeping only which cells of the row are connected so far:
+ * each set is a circular list of its cells, in column order, so two
+ * neighbors are in the same set when one follows the other. Neighbors of
+ * different sets are joined on a coin flip, then each cell opens down on a
+ * coin flip, unless it is the last cell of its set left; a cell that does
+ * not open leaves its set. The last row joins every set left.
+ *
+ * Each cell costs a few array accesses, and the rows are written in order.
+ *
+ * @param maze A maze filled with walls.
+ * @param rng The generator.
+ */
+void carve_perfect(maze_t &maze, Rng &rng)
+{
+    const size_t height = (maze.size() - 1) / 2, width = (maze.front().size() - 1) / 2;
+    std::vector<uint32_t> left(width), right(width);
+    Coins coins(rng);
+
+    for (size_t c = 0; c < width; ++c)
+        left[c] = right[c] = c;
+
+    for (size_t r = 0; r < height; ++r) {
+        char *row = maze[2 * r + 1].data();
+        char *below = r + 1 < height ? maze[2 * r + 2].data() : nullptr;
+
+        for (size_t c = 0; c < width; ++c) {
+            row[2 * c + 1] = FREE;
+
+            // Join the set of the next cell, always on the last row.
+            const size_t next = c + 1;
+            if (next < width and next != right[c] and (below == nullptr or coins.flip())) {
+                right[left[next]] = right[c];
+                left[right[c]] = left[next];
+                right[c] = next;
+                left[next] = c;
+                row[2 * c + 2] = FREE;
+            }
+
+            if (below == nullptr)
+                continue;
+
+            // Leave the set without a passage down, or open one.
+            if (c != right[c] and coins.flip()) {
+                left[right[c]] = left[c];
+                right[left[c]] = right[c];
+                left[c] = right[c] = c;
+            }
+            else {
+                below[2 * c + 1] = FREE;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Carves one room per block of the maze, and corridors between them.
+ *
+ * Every room is joined to the one on its right, and to the one below when
+ * it is in the first column or on a coin flip, so every room is reachable.
+ *
+ * @param maze A maze filled with walls.
+ * @param rng The generator.
+ * @return The center of the top left room.
+ */
+std::pair<size_t, size_t> carve_rooms(maze_t &maze, Rng &rng)
+{
+    const size_t inner_rows = maze.size() - 2, inner_cols = maze.front().size() - 2;
+    const size_t blocks_r = std::max<size_t>(1, inner_rows / ROOM_BLOCK);
+    const size_t blocks_c = std::max<size_t>(1, inner_cols / ROOM_BLOCK);
+    const size_t block_h = inner_rows / blocks_r, block_w = inner_cols / blocks_c;
+
+    // Draws a size in [3, side - 1], or the whole side if it is too small.
+    auto extent = [&rng](size_t side) {
+        return side <= 3 ? side : 3 + rng.below(side - 3);
+    };
+
+    std::vector<std::pair<size_t, size_t>> centers(blocks_r * blocks_c);
+    for (size_t br = 0; br < blocks_r; ++br) {
+        for (size_t bc = 0; bc < blocks_c; ++bc) {
+            const size_t h = extent(block_h), w = extent(block_w);
+            const size_t top = 1 + br * block_h + rng.below(block_h - h + 1);
+            const size_t left = 1 + bc * block_w + rng.below(block_w - w + 1);
+
+            for (size_t r = top; r < top + h; ++r)
+                std::fill(maze[r].begin() + left, maze[r].begin() + left + w, FREE);
+            centers[br * blocks_c + bc] = { top + h / 2, left + w / 2 };
+        }
+    }
+
+    // Carves a corridor along the row of the first center, then the column of the second one.
+    auto corridor = [&maze](std::pair<size_t, size_t> from, std::pair<size_t, size_t> to) {
+        auto [c0, c1] = std::minmax(from.second, to.second);
+        std::fill(maze[from.first].begin() + c0, maze[from.first].begin() + c1 + 1, FREE);
+        auto [r0, r1] = std::minmax(from.first, to.first);
+        for (size_t r = r0; r <= r1; ++r)
+            maze[r][to.second] = FREE;
+    };
+
+    for (size_t br = 0; br < blocks_r; ++br) {
+        for (size_t bc = 0; bc < blocks_c; ++bc) {
+            const auto &center = centers[br * blocks_c + bc];
+            if (bc + 1 < blocks_c)
+                corridor(center, centers[br * blocks_c + bc + 1]);
+            if (br + 1 < blocks_r and (bc == 0 or rng.below(2) == 0))
+                corridor(center, centers[(br + 1) * blocks_c + bc]);
+        }
+    }
+
+    return centers.front();
+}
+
+/**
+ * @brief Scatters obstacles over an open room, leaving the cells around the spawn free.
+ *
+ * @param maze A maze filled with walls.
+ * @param rng The generator.
+ * @param density The share of inner cells that are obstacles.
+ * @param spawn The row and col of the spawn.
+ */
+void carve_arena(maze_t &maze, Rng &rng, double density, std::pair<size_t, size_t> spawn)
+{
+    // Each draw decides four cells, a cell being an obstacle when its 16 bits are below the threshold.
+    const uint32_t threshold = static_cast<uint32_t>(density * 65536);
+    const size_t cols = maze.front().size();
+
+    for (size_t r = 1; r + 1 < maze.size(); ++r) {
+        char *row = maze[r].data();
+        for (size_t c = 1; c + 1 < cols; c += 4) {
+            const uint64_t bits = rng.next();
+            const size_t cells = std::min<size_t>(4, cols - 1 - c);
+            for (size_t k = 0; k < cells; ++k)
+                row[c + k] = ((bits >> (16 * k)) & 0xffff) < threshold ? WALL : FREE;
+        }
+    }
+
+    // Obstacles around the spawn would wall the snake in before its first move.
+    const auto [sr, sc] = spawn;
+    const std::pair<size_t, size_t> neighbors[] = { { sr - 1, sc }, { sr + 1, sc }, { sr, sc - 1 }, { sr, sc + 1 } };
+    for (const auto &[r, c] : neighbors)
+        if (r > 0 and r + 1 < maze.size() and c > 0 and c + 1 < cols)
+            maze[r][c] = FREE;
+}
+
+/**
+ * @brief Carves horizontal corridors one cell high, with one gap in each wall between them.
+ *
+ * @param maze A maze filled with walls.
+ * @param rng The generator.
+ */
+void carve_corridors(maze_t &maze, Rng &rng)
+{
+    const size_t cols = maze.front().size();
+
+    for (size_t r = 1; r + 1 < maze.size(); r += 2)
+        std::fill(maze[r].begin() + 1, maze[r].end() - 1, FREE);
+
+    // The walls between two corridors; a last row without a corridor below stays closed.
+    for (size_t r = 2; r + 2 < maze.size(); r += 2)
+        maze[r][1 + rng.below(cols - 2)] = FREE;
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Generates a maze.
+ *
+ * @param style The style of the maze.
+ * @param rows The number of rows, walls included.
+ * @param cols The number of cols, walls included.
+ * @param seed The seed; the same seed gives the same maze.
+ * @param density The share of obstacles of an arena, in [0, 1]; ignored by the other styles.
+ * @return The maze, as read from a level file.
+ * @throws std::invalid_argument if the maze has less than 3 rows or cols, or too many cells.
+ */
+maze_t generate_maze(maze_style_e style, size_t rows, size_t cols, Rng::state_t seed, double density)
+{
+    if (rows < 3 or cols < 3)
+        throw std::invalid_argument("A maze needs at least 3 rows and 3 cols.");
+    if (rows * cols > UINT32_MAX)
+        throw std::invalid_argument("A maze holds at most 2^32 cells.");
+
+    Rng rng(seed);
+    maze_t maze(rows, std::vector<char>(cols, WALL));
+    std::pair<size_t, size_t> spawn { 1, 1 };
+
+    switch (style) {
+    case maze_style_e::PERFECT:
+        carve_perfect(maze, rng);
+        break;
+    case maze_style_e::ROOMS:
+        spawn = carve_rooms(maze, rng);
+        break;
+    case maze_style_e::ARENA:
+        carve_arena(maze, rng, std::clamp(density, 0.0, 1.0), spawn);
+        break;
+    case maze_style_e::CORRIDORS:
+        carve_corridors(maze, rng);
+        break;
+    }
+    maze[spawn.first][spawn.second] = SPAWN;
+
+    return maze;
+}
+
+/**
+ * @brief Returns the style of a name.
+ *
+ * @param name One of "perfect", "rooms", "arena" or "corridors".
+ * @return The style, or nothing if the name is unknown.
+ */
+std::optional<maze_style_e> maze_style(const std::string &name)
+{
+    if (name == "perfect")
+        return maze_style_e::PERFECT;
+    if (name == "rooms")
+        return maze_style_e::ROOMS;
+    if (name == "arena")
+        return maze_style_e::ARENA;
+    if (name == "corridors")
+        return maze_style_e::CORRIDORS;
+
+    return std::nullopt;
+}
+
+} // NAMESPACE SNAZE
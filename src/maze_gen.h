@@ -0,0 +1,45 @@
+/**
+ * @file maze_gen.h
+ *
+ * @description
+ * Procedural mazes, of any size, for the scaling questions the bundled
+ * levels are too small to answer. The same style, size and seed always
+ * give the same maze, on any platform, as every draw comes from `Rng`.
+ * The mazes are surrounded by walls, connected, and have their spawn in
+ * the top left free cell; arenas are the exception, their obstacles may
+ * close pockets of free cells, though never the cells next to the spawn.
+ *
+ * Each style costs a few operations per cell, so a 10000x10000 maze takes
+ * well under a second.
+ */
+
+#ifndef MAZE_GEN_H
+#define MAZE_GEN_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "maze_file.h"
+#include "rng.h"
+
+namespace snaze {
+
+//== Enums
+
+/// Styles of generated mazes.
+enum class maze_style_e : short {
+    PERFECT = 0,    //!< Corridors one cell wide with exactly one path between two cells.
+    ROOMS,          //!< Rectangular rooms joined by corridors.
+    ARENA,          //!< An open room with scattered obstacles.
+    CORRIDORS,      //!< Long horizontal corridors, each wall between them with one gap.
+};
+
+/// Generates a maze; `density` is the share of obstacles of an arena. Throws if it is too small.
+maze_t generate_maze(maze_style_e, size_t rows, size_t cols, Rng::state_t seed, double density = 0.2);
+/// Returns the style of a name ("perfect", "rooms", "arena" or "corridors"), if any.
+std::optional<maze_style_e> maze_style(const std::string &);
+
+} // NAMESPACE SNAZE
+
+#endif
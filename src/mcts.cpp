@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "mcts.h"
+#include "common.h"
+
+namespace snaze {
+
+namespace {
+
+constexpr size_t JOBS_PER_THREAD = 8;     //!< Leaves selected per thread in each wave.
+constexpr size_t MAX_NODES = 1 << 20;     //!< Size of the tree beyond which leaves are not expanded.
+constexpr float EXPLORATION = 1.0f;       //!< Weight of the exploration term of UCT.
+constexpr float VIRTUAL_LOSS = 1.0f;      //!< Loss counted for each playout in flight.
+constexpr float DISCOUNT = 0.98f;         //!< Discount per move, so sooner food and later deaths are preferred.
+constexpr float CLOSENESS = 0.5f;         //!< Weight of the distance to the food at the end of a playout.
+constexpr uint64_t GREEDY = 2;            //!< A playout moves towards the food once every this many moves.
+constexpr size_t TABLE_SLOTS = 1 << 16;   //!< Slots of the transposition table.
+constexpr uint16_t PRIOR_VISITS = 32;     //!< Most visits a leaf takes over from a transposition.
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Sets how the search runs.
+ *
+ * @param threads The number of threads running playouts; 0 uses every hardware thread.
+ * @param rollouts The number of playouts per move; 0 searches until the deadline instead.
+ * @param budget The time allowed per move when searching until the deadline.
+ * @param seed The seed of the playouts.
+ */
+void MonteCarloPlanner::configure(size_t threads, size_t rollouts, clock::duration budget, Rng::state_t seed)
+{
+    m_pool = std::make_shared<ThreadPool>(threads);
+    m_threads = m_pool->size();
+    m_budget = rollouts;
+    m_deadline = budget;
+    m_seed = seed;
+}
+
+/**
+ * @brief Searches the best move from the snake head.
+ *
+ * A move that is the only one allowed is returned without searching.
+ *
+ * @param level The live level, with the snake and the food placed.
+ * @return The move visited the most, or nothing if the snake cannot move.
+ */
+std::optional<dir_e> MonteCarloPlanner::search(const Level &level)
+{
+    auto start = clock::now();
+
+    if (m_pool == nullptr)
+        m_pool = std::make_shared<ThreadPool>(m_threads);
+    // A copy of the planner, such as a speculative one, searches with a table of its own.
+    if (m_table == nullptr or m_table.use_count() > 1)
+        m_table = std::make_shared<TranspositionTable>(TABLE_SLOTS);
+
+    // A state seen again is searched with other playouts, so the snake cannot loop forever.
+    GameState root(level, 1);
+    m_root_seed = Rng(m_seed ^ root.hash() ^ m_searches++).next();
+    m_horizon = 2 * (root.rows() + root.cols());
+
+    m_nodes.clear();
+    m_nodes.emplace_back();
+    m_nodes[0].reached = true;
+    m_nodes[0].hash = root.hash();
+
+    uint8_t open = open_moves(root);
+    if (open == 0)
+        return std::nullopt;
+
+    expand(0, open);
+    if (m_nodes[0].children == 1)
+        return m_nodes[1].dir;
+
+    m_table->clear();
+    m_field = DistanceField(level, level.foods());
+    m_states.assign(m_threads, root);
+    m_jobs.resize(JOBS_PER_THREAD * m_threads);
+
+    uint64_t done = 0;
+    auto deadline = start + m_deadline;
+
+    do {
+        size_t count = m_budget > 0 ? std::min<uint64_t>(m_jobs.size(), m_budget - done) : m_jobs.size();
+
+        for (size_t i = 0; i < count; ++i)
+            select(m_jobs[i]);
+
+        // Each thread takes every n-th job, so the split does not depend on timing.
+        m_pool->run([&](size_t thread) {
+            for (size_t i = thread; i < count; i += m_threads)
+                simulate(m_jobs[i], m_states[thread], done + i);
+        });
+
+        for (size_t i = 0; i < count; ++i)
+            backup(m_jobs[i]);
+
+        done += count;
+    } while (m_budget > 0 ? done < m_budget : clock::now() < deadline);
+
+    // Play the most visited move, breaking ties by the mean return.
+    const Node &node = m_nodes[0];
+    uint32_t best = node.first;
+    for (uint32_t child = node.first + 1; child < node.first + node.children; ++child) {
+        const Node &a = m_nodes[child], &b = m_nodes[best];
+        if (a.visits > b.visits or (a.visits == b.visits and a.value * b.visits > b.value * a.visits))
+            best = child;
+    }
+
+    m_rollouts += done;
+    m_elapsed += clock::now() - start;
+
+    return m_nodes[best].dir;
+}
+
+/**
+ * @brief Returns the number of playouts per second spent searching so far.
+ */
+double MonteCarloPlanner::rate() const
+{
+    double seconds = std::chrono::duration<double>(m_elapsed).count();
+    return seconds > 0 ? m_rollouts / seconds : 0;
+}
+
+/**
+ * @brief Picks a leaf with UCT and adds a virtual loss along its path.
+ *
+ * Children never tried come first, in direction order. Playouts still in
+ * flight count as visits that lost, so the other leaves of the wave are
+ * drawn towards branches not being explored yet.
+ *
+ * @param job Receives the path from the root to the leaf.
+ */
+void MonteCarloPlanner::select(Job &job)
+{
+    job.path.clear();
+    job.path.push_back(0);
+
+    uint32_t id = 0;
+    while (m_nodes[id].expanded and m_nodes[id].children > 0) {
+        const Node &parent = m_nodes[id];
+        float log_n = std::log(static_cast<float>(parent.visits + parent.pending) + 1);
+
+        uint32_t best = parent.first;
+        float best_score = -std::numeric_limits<float>::infinity();
+        for (uint32_t child = parent.first; child < parent.first + parent.children; ++child) {
+            const Node &node = m_nodes[child];
+            float n = static_cast<float>(node.visits + node.pending);
+            float score = n == 0 ? std::numeric_limits<float>::infinity()
+                                 : (node.value - node.pending * VIRTUAL_LOSS) / n + EXPLORATION * std::sqrt(log_n / n);
+            if (score > best_score) {
+                best = child;
+                best_score = score;
+            }
+        }
+
+        id = best;
+        job.path.push_back(id);
+    }
+
+    for (uint32_t node : job.path)
+        ++m_nodes[node].pending;
+}
+
+/**
+ * @brief Replays a job from the root and plays it out at random.
+ *
+ * The playout picks uniformly among the moves that do not kill the snake
+ * at once, except that every few moves, while the first food is not eaten,
+ * it takes the one closest to any food instead, until it dies or reaches
+ * the horizon. Every food eaten adds to
+ * the return and a death takes from it, both discounted by the number of
+ * moves from the root; a snake still alive at the end that has not eaten
+ * earns a little for being close to the food, measured around the walls.
+ * The state is restored before returning. The state at the leaf is looked
+ * up in the transposition table, which no thread writes during a wave.
+ *
+ * @param job The leaf to play out; receives the return and the leaf moves.
+ * @param state A copy of the root state owned by the calling thread.
+ * @param index The index of the playout in the search, which seeds it.
+ */
+void MonteCarloPlanner::simulate(Job &job, GameState &state, uint64_t index) const
+{
+    auto mark = state.snapshot();
+    Rng rng(m_root_seed ^ (index * 0x9e3779b97f4a7c15ULL));
+
+    float value = 0, discount = 1;
+    job.dead = false;
+
+    for (size_t k = 1; k < job.path.size() and not job.dead; ++k) {
+        auto outcome = state.step(m_nodes[job.path[k]].dir);
+        discount *= DISCOUNT;
+        value += outcome == GameState::outcome_e::ATE ? discount : 0;
+        value -= outcome == GameState::outcome_e::DIED ? discount : 0;
+        job.dead = outcome == GameState::outcome_e::DIED;
+    }
+
+    job.open = job.dead ? 0 : open_moves(state);
+    job.hash = state.hash();
+    job.shared = not job.dead and m_table->probe(job.hash, job.prior);
+
+    bool dead = job.dead;
+    for (size_t t = 0; t < m_horizon and not dead; ++t) {
+        dir_e moves[4];
+        size_t count = 0;
+        uint8_t open = open_moves(state);
+        for (const dir_e dir : { UP, LEFT, DOWN, RIGHT })
+            if (open & (1 << dir))
+                moves[count++] = dir;
+
+        dir_e move = count > 0 ? moves[rng.below(count)] : state.direction();
+
+        // Now and then, walk down the distance field to the food.
+        if (count > 1 and state.foods() == 0 and rng.below(GREEDY) == 0) {
+            DistanceField::dist_t best = DistanceField::INF;
+            for (size_t i = 0; i < count; ++i) {
+                DistanceField::dist_t dist = m_field.at(to_position(state.neighbor(state.head(), moves[i]), state.cols()));
+                if (dist < best) {
+                    best = dist;
+                    move = moves[i];
+                }
+            }
+        }
+
+        auto outcome = state.step(move);
+        discount *= DISCOUNT;
+        value += outcome == GameState::outcome_e::ATE ? discount : 0;
+        value -= outcome == GameState::outcome_e::DIED ? discount : 0;
+        dead = outcome == GameState::outcome_e::DIED;
+    }
+
+    if (not dead and state.foods() == 0) {
+        DistanceField::dist_t dist = m_field.at(to_position(state.head(), state.cols()));
+        if (dist < m_horizon)
+            value += CLOSENESS * discount * (1 - static_cast<float>(dist) / m_horizon);
+    }
+
+    job.value = value;
+    state.restore(mark);
+}
+
+/**
+ * @brief Adds the return of a job to its path and expands its leaf.
+ *
+ * A leaf reached for the first time takes its hash from the job and, if
+ * the same state was backed up through another path, starts from its mean
+ * return over a few of its visits. Every node of the path is then stored
+ * in the table, so later leaves share what this path learned.
+ *
+ * @param job A job whose playout finished.
+ */
+void MonteCarloPlanner::backup(const Job &job)
+{
+    uint32_t leaf = job.path.back();
+    Node &first = m_nodes[leaf];
+    if (not first.reached and not job.dead) {
+        first.reached = true;
+        first.hash = job.hash;
+        if (job.shared) {
+            uint16_t visits = std::min(job.prior.depth, PRIOR_VISITS);
+            first.value += job.prior.value * visits;
+            first.visits += visits;
+        }
+    }
+
+    for (uint32_t id : job.path) {
+        m_nodes[id].value += job.value;
+        ++m_nodes[id].visits;
+        --m_nodes[id].pending;
+        share(m_nodes[id]);
+    }
+
+    if (m_nodes[leaf].expanded)
+        return;
+
+    // A leaf where the snake died stays a leaf.
+    if (job.dead)
+        m_nodes[leaf].expanded = true;
+    else
+        expand(leaf, job.open);
+}
+
+/**
+ * @brief Stores the statistics of a node in the transposition table.
+ *
+ * The table keeps the node visited the most among those sharing a slot.
+ *
+ * @param node A node that was backed up.
+ */
+void MonteCarloPlanner::share(const Node &node)
+{
+    if (not node.reached or node.visits == 0)
+        return;
+
+    TranspositionTable::Entry entry {};
+    entry.value = node.value / node.visits;
+    entry.depth = static_cast<uint16_t>(std::min<uint32_t>(node.visits, UINT16_MAX));
+    m_table->store(node.hash, entry);
+}
+
+/**
+ * @brief Creates the children of a node, one per allowed move.
+ *
+ * Nothing is created once the tree reaches its maximum size; the node is
+ * then played out again every time it is selected.
+ *
+ * @param node The node to expand.
+ * @param open The allowed moves, one bit per direction.
+ */
+void MonteCarloPlanner::expand(uint32_t node, uint8_t open)
+{
+    if (m_nodes.size() + 4 > MAX_NODES)
+        return;
+
+    m_nodes[node].first = m_nodes.size();
+    m_nodes[node].expanded = true;
+
+    for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+        if (open & (1 << dir)) {
+            Node child;
+            child.dir = dir;
+            m_nodes.push_back(child);
+            ++m_nodes[node].children;
+        }
+    }
+}
+
+/**
+ * @brief Returns the moves allowed from the head of a state.
+ *
+ * @param state The state to look at.
+ * @return One bit per direction, set if moving that way does not kill the snake.
+ */
+uint8_t MonteCarloPlanner::open_moves(const GameState &state)
+{
+    uint8_t open = 0;
+    for (const dir_e dir : { UP, LEFT, DOWN, RIGHT })
+        if (state.open(state.neighbor(state.head(), dir)))
+            open |= 1 << dir;
+
+    return open;
+}
+
+} // NAMESPACE SNAZE
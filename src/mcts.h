@@ -0,0 +1,136 @@
+/**
+ * @file mcts.h
+ *
+ * @description
+ * This class implements Monte Carlo Tree Search for the next move. The
+ * tree grows from the current head over copies of the game state, each
+ * leaf is scored by a random playout, and the move visited the most is
+ * played. It looks ahead past the food, since the next food is drawn from
+ * the same generator as the game's, so it avoids eating into a trap.
+ *
+ * The search runs in waves. Leaves are selected one after another, each
+ * selection adding a virtual loss to its path so the next ones spread
+ * over other branches; then the pool replays, expands and plays out all
+ * of the wave's leaves in parallel; then the results are backed up in the
+ * order of the leaves. No step depends on thread timing, so a search with
+ * a fixed number of playouts is deterministic for a seed and a number of
+ * threads. Without one, waves run until the deadline of the frame.
+ *
+ * The descent itself stays on the calling thread: threads descending the
+ * shared tree with virtual losses would see each other's losses in the
+ * order they happen to run, which breaks determinism. Selection is cheap
+ * next to the playouts, which take most of the time and are parallel.
+ *
+ * Different move orders often reach the same state, above all while the
+ * snake is short. Every node backed up is stored in a transposition table
+ * keyed by the state hash, and a leaf reached for the first time starts
+ * from the statistics of the same state found elsewhere in the tree. The
+ * playout threads probe the table while it is only written between waves,
+ * so sharing keeps the search deterministic. The table is emptied before
+ * each search, so a run resumed from a checkpoint plays the same moves.
+ */
+
+#ifndef MCTS_H
+#define MCTS_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "common.h"
+#include "distance_field.h"
+#include "game_state.h"
+#include "level.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include "transposition.h"
+#include "zobrist.h"
+
+namespace snaze {
+
+class MonteCarloPlanner {
+public:
+    //== Aliases
+    using clock = std::chrono::steady_clock;
+
+    /// Default constructor.
+    MonteCarloPlanner() = default;
+    /// Destructor.
+    ~MonteCarloPlanner() = default;
+
+    /// Sets the threads, the number of playouts per move (0 searches until the deadline), the deadline and the seed.
+    void configure(size_t threads, size_t rollouts, clock::duration budget, Rng::state_t seed);
+    /// Searches the best move from the snake head, or nothing if every move is fatal.
+    std::optional<dir_e> search(const Level &);
+
+    /// Returns the number of playouts run so far.
+    uint64_t rollouts() const { return m_rollouts; }
+    /// Returns the number of playouts per second spent searching so far.
+    double rate() const;
+    /// Returns the number of searches run so far, which seeds the next one.
+    uint64_t searches() const { return m_searches; }
+    /// Sets the number of searches run so far, to go on with a run that was stopped.
+    void searches(uint64_t count) { m_searches = count; }
+
+private:
+    /// A state reached from the root, stored in a flat pool.
+    struct Node {
+        float value = 0;        //!< Sum of the returns backed up through the node.
+        uint32_t visits = 0;    //!< Number of returns backed up through the node.
+        uint32_t pending = 0;   //!< Playouts in flight through the node, each counted as a loss.
+        uint32_t first = 0;     //!< Pool index of the first child.
+        uint8_t children = 0;   //!< Number of children, stored next to each other.
+        dir_e dir = UP;         //!< Move that leads from the parent to the node.
+        bool expanded = false;  //!< Whether the children were created.
+        bool reached = false;   //!< Whether a playout reached the node alive, setting its hash.
+        zobrist::hash_t hash = 0; //!< Hash of the state at the node.
+    };
+
+    /// A leaf selected in a wave and what its playout found.
+    struct Job {
+        std::vector<uint32_t> path; //!< Nodes from the root to the leaf.
+        float value = 0;            //!< Return of the moves to the leaf and of the playout.
+        uint8_t open = 0;           //!< Moves allowed from the leaf, one bit per direction.
+        bool dead = false;          //!< Whether the snake died before the leaf.
+        zobrist::hash_t hash = 0;   //!< Hash of the state at the leaf.
+        bool shared = false;        //!< Whether the table knew the state at the leaf.
+        TranspositionTable::Entry prior {}; //!< Statistics of the state found elsewhere in the tree.
+    };
+
+    /// Picks a leaf and adds a virtual loss along its path.
+    void select(Job &);
+    /// Replays a job from the root and plays it out on a state copy.
+    void simulate(Job &, GameState &, uint64_t index) const;
+    /// Adds the return of a job to its path, shares it through the table and expands its leaf.
+    void backup(const Job &);
+    /// Stores the statistics of a node in the transposition table.
+    void share(const Node &);
+    /// Creates the children of a node, one per allowed move.
+    void expand(uint32_t node, uint8_t open);
+    /// Returns the moves allowed from the head of a state, one bit per direction.
+    static uint8_t open_moves(const GameState &);
+
+    size_t m_threads = 1;                   //!< Threads running playouts.
+    size_t m_budget = 0;                    //!< Playouts per move; 0 searches until the deadline.
+    clock::duration m_deadline = std::chrono::milliseconds(1); //!< Time allowed per move.
+    Rng::state_t m_seed = 0;                //!< Seed of the playouts.
+    std::shared_ptr<ThreadPool> m_pool;     //!< Pool running the playouts.
+    std::shared_ptr<TranspositionTable> m_table; //!< Statistics of the states of the tree, by hash; never shared while searching.
+
+    std::vector<Node> m_nodes;              //!< The tree; the root is the first node.
+    std::vector<Job> m_jobs;                //!< Leaves of the current wave.
+    std::vector<GameState> m_states;        //!< One copy of the root state per thread.
+    uint64_t m_root_seed = 0;               //!< Seed of the current search, from the seed and the number of searches.
+    DistanceField m_field;                  //!< Distances to the nearest food, to score playouts that did not reach one.
+    size_t m_horizon = 0;                   //!< Maximum length of a playout.
+
+    uint64_t m_searches = 0;                //!< Searches run so far.
+    uint64_t m_rollouts = 0;                //!< Playouts run so far.
+    clock::duration m_elapsed {};           //!< Time spent searching so far.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,205 @@
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "metrics.h"
+
+namespace snaze {
+namespace metrics {
+
+#ifdef SNAZE_METRICS
+namespace detail {
+
+std::atomic<uint64_t> counters[COUNTERS];
+Stat stats[STATS];
+
+} // NAMESPACE DETAIL
+#endif
+
+namespace {
+
+/// Names and help of a counter.
+struct CounterInfo {
+    const char *name;   //!< Key in JSON, and name in Prometheus after "snaze_" unless it has a label.
+    const char *help;   //!< Help line of Prometheus.
+};
+
+/// Names, help and unit of a stat.
+struct StatInfo {
+    const char *name;   //!< Key in JSON.
+    const char *metric; //!< Name in Prometheus, after "snaze_".
+    const char *help;   //!< Help line of Prometheus.
+    double scale;       //!< Factor from the recorded unit to the unit of Prometheus.
+};
+
+constexpr CounterInfo COUNTER_INFO[COUNTERS] = {
+    { "searches", "Paths searched by the players." },
+    { "nodes_expanded", "Cells or jump points expanded by the path searches." },
+    { "replans", "Plans made again for the same food." },
+    { "moves", "Moves of the snake." },
+    { "foods", "Foods eaten." },
+    { "deaths_trapped", "Deaths by cause." },
+    { "deaths_no_path", "Deaths by cause." },
+};
+
+constexpr StatInfo STAT_INFO[STATS] = {
+    { "path_length", "path_length_moves", "Moves of the paths found.", 1 },
+    { "plan_ns", "plan_seconds", "Time of a path search.", 1e-9 },
+    { "update_ns", "level_update_seconds", "Time of a level update.", 1e-9 },
+    { "render_ns", "render_seconds", "Time to draw a frame.", 1e-9 },
+    { "frame_ns", "frame_interval_seconds", "Time between two frames.", 1e-9 },
+    { "jitter_ns", "frame_jitter_seconds", "Change of the time between frames from one frame to the next.", 1e-9 },
+};
+
+std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now(); //!< Start of the rates.
+
+/// A snapshot of every metric.
+struct Values {
+    uint64_t counters[COUNTERS] = {};   //!< Value of each counter.
+    uint64_t count[STATS] = {};         //!< Values recorded by each stat.
+    uint64_t sum[STATS] = {};           //!< Their sum.
+    uint64_t max[STATS] = {};           //!< Their maximum.
+    double uptime = 0;                  //!< Seconds since the start of the rates.
+
+    /// Returns a counter divided by a number, or 0.
+    double ratio(counter_e counter, double by) const { return by > 0 ? counters[counter] / by : 0; }
+};
+
+/**
+ * @brief Reads every metric.
+ *
+ * @return The values, all 0 in a build without metrics.
+ */
+Values read()
+{
+    Values values;
+#ifdef SNAZE_METRICS
+    for (unsigned c = 0; c < COUNTERS; ++c)
+        values.counters[c] = detail::counters[c].load(std::memory_order_relaxed);
+    for (unsigned s = 0; s < STATS; ++s) {
+        values.count[s] = detail::stats[s].count.load(std::memory_order_relaxed);
+        values.sum[s] = detail::stats[s].sum.load(std::memory_order_relaxed);
+        values.max[s] = detail::stats[s].max.load(std::memory_order_relaxed);
+    }
+#endif
+    values.uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    return values;
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Returns every metric as a JSON object.
+ *
+ * Besides the counters and stats, it holds the rates asked for most: the
+ * nodes per search, and the foods and moves per second since the start.
+ *
+ * @return The JSON text.
+ */
+std::string to_json()
+{
+    const Values values = read();
+    std::ostringstream out;
+
+    out << "{\n  \"enabled\": " << (ENABLED ? "true" : "false")
+        << ",\n  \"uptime_seconds\": " << values.uptime
+        << ",\n  \"counters\": {";
+    for (unsigned c = 0; c < COUNTERS; ++c)
+        out << (c == 0 ? "\n" : ",\n") << "    \"" << COUNTER_INFO[c].name << "\": " << values.counters[c];
+
+    out << "\n  },\n  \"rates\": {"
+        << "\n    \"nodes_per_search\": " << values.ratio(NODES_EXPANDED, values.counters[SEARCHES])
+        << ",\n    \"foods_per_second\": " << values.ratio(FOODS, values.uptime)
+        << ",\n    \"moves_per_second\": " << values.ratio(MOVES, values.uptime)
+        << "\n  },\n  \"stats\": {";
+    for (unsigned s = 0; s < STATS; ++s) {
+        double mean = values.count[s] > 0 ? double(values.sum[s]) / values.count[s] : 0;
+        out << (s == 0 ? "\n" : ",\n") << "    \"" << STAT_INFO[s].name << "\": { \"count\": " << values.count[s]
+            << ", \"sum\": " << values.sum[s] << ", \"mean\": " << mean << ", \"max\": " << values.max[s] << " }";
+    }
+    out << "\n  }\n}\n";
+
+    return out.str();
+}
+
+/**
+ * @brief Returns every metric in the Prometheus text format.
+ *
+ * Counters end in "_total", the deaths are one counter labeled by cause,
+ * stats are summaries without quantiles plus a gauge of their maximum, and
+ * times are in seconds.
+ *
+ * @return The text.
+ */
+std::string to_prometheus()
+{
+    const Values values = read();
+    std::ostringstream out;
+
+    for (unsigned c = 0; c < DEATHS_TRAPPED; ++c) {
+        const char *name = COUNTER_INFO[c].name;
+        out << "# HELP snaze_" << name << "_total " << COUNTER_INFO[c].help << "\n"
+            << "# TYPE snaze_" << name << "_total counter\n"
+            << "snaze_" << name << "_total " << values.counters[c] << "\n";
+    }
+    out << "# HELP snaze_deaths_total " << COUNTER_INFO[DEATHS_TRAPPED].help << "\n"
+        << "# TYPE snaze_deaths_total counter\n"
+        << "snaze_deaths_total{cause=\"trapped\"} " << values.counters[DEATHS_TRAPPED] << "\n"
+        << "snaze_deaths_total{cause=\"no_path\"} " << values.counters[DEATHS_NO_PATH] << "\n";
+
+    out << "# HELP snaze_nodes_per_search Cells or jump points expanded per path search.\n"
+        << "# TYPE snaze_nodes_per_search gauge\n"
+        << "snaze_nodes_per_search " << values.ratio(NODES_EXPANDED, values.counters[SEARCHES]) << "\n"
+        << "# HELP snaze_foods_per_second Foods eaten per second since the start.\n"
+        << "# TYPE snaze_foods_per_second gauge\n"
+        << "snaze_foods_per_second " << values.ratio(FOODS, values.uptime) << "\n";
+
+    for (unsigned s = 0; s < STATS; ++s) {
+        const StatInfo &info = STAT_INFO[s];
+        out << "# HELP snaze_" << info.metric << " " << info.help << "\n"
+            << "# TYPE snaze_" << info.metric << " summary\n"
+            << "snaze_" << info.metric << "_sum " << values.sum[s] * info.scale << "\n"
+            << "snaze_" << info.metric << "_count " << values.count[s] << "\n"
+            << "# HELP snaze_" << info.metric << "_max Largest value of snaze_" << info.metric << ".\n"
+            << "# TYPE snaze_" << info.metric << "_max gauge\n"
+            << "snaze_" << info.metric << "_max " << values.max[s] * info.scale << "\n";
+    }
+
+    return out.str();
+}
+
+/**
+ * @brief Returns the metrics in the format of a file.
+ *
+ * @param path The file, Prometheus text if it ends in ".prom" or ".txt", JSON otherwise.
+ * @return The text of the file.
+ */
+std::string format_for(const std::string &path)
+{
+    auto ends_with = [&path](const std::string &suffix) {
+        return path.size() >= suffix.size() and path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    return ends_with(".prom") or ends_with(".txt") ? to_prometheus() : to_json();
+}
+
+/**
+ * @brief Clears every metric and restarts the clock of the rates.
+ */
+void reset()
+{
+#ifdef SNAZE_METRICS
+    for (auto &counter : detail::counters)
+        counter.store(0, std::memory_order_relaxed);
+    for (auto &stat : detail::stats) {
+        stat.count.store(0, std::memory_order_relaxed);
+        stat.sum.store(0, std::memory_order_relaxed);
+        stat.max.store(0, std::memory_order_relaxed);
+    }
+#endif
+    started = std::chrono::steady_clock::now();
+}
+
+} // NAMESPACE METRICS
+} // NAMESPACE SNAZE
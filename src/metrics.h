@@ -0,0 +1,164 @@
+/**
+ * @file metrics.h
+ *
+ * @description
+ * Counters and timers of the hot paths, built only with the SNAZE_METRICS
+ * option of CMake. Without it every function below is empty and inline,
+ * and `Timer` holds nothing, so the calls left in the code compile to
+ * nothing at all.
+ *
+ * The values are process-wide and updated with relaxed atomics, since the
+ * speculative planner and the search threads report from their own
+ * threads. Searches add their node counts once, when they end. A stat
+ * keeps the count, sum and maximum of the values recorded, enough for
+ * means without storing the values.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace snaze {
+namespace metrics {
+
+#ifdef SNAZE_METRICS
+constexpr bool ENABLED = true;      //!< Whether the metrics are built.
+#else
+constexpr bool ENABLED = false;     //!< Whether the metrics are built.
+#endif
+
+//== Enums
+
+/// Events counted.
+enum counter_e : unsigned {
+    SEARCHES = 0,       //!< Paths searched by the players.
+    NODES_EXPANDED,     //!< Cells or jump points expanded by those searches.
+    REPLANS,            //!< Plans made again for the same food.
+    MOVES,              //!< Moves of the snake.
+    FOODS,              //!< Foods eaten.
+    DEATHS_TRAPPED,     //!< Deaths on the first move of a match, of a snake boxed in where it ate.
+    DEATHS_NO_PATH,     //!< Deaths later in a match, of a snake that walked on without a path.
+    COUNTERS,           //!< Number of counters.
+};
+
+/// Values whose count, sum and maximum are kept.
+enum stat_e : unsigned {
+    PATH_LENGTH = 0,    //!< Moves of the paths found.
+    PLAN_NS,            //!< Time of a path search.
+    UPDATE_NS,          //!< Time of `Level::update`.
+    RENDER_NS,          //!< Time to draw a frame.
+    FRAME_NS,           //!< Time between two frames.
+    JITTER_NS,          //!< Change of the time between frames from one frame to the next.
+    STATS,              //!< Number of stats.
+};
+
+//== Functions
+
+/// Returns the JSON object of every metric.
+std::string to_json();
+/// Returns every metric in the Prometheus text format.
+std::string to_prometheus();
+/// Returns `to_prometheus()` for a path ending in ".prom" or ".txt", `to_json()` otherwise.
+std::string format_for(const std::string &path);
+/// Clears every metric and restarts the clock of the rates.
+void reset();
+
+#ifdef SNAZE_METRICS
+
+namespace detail {
+
+/// Count, sum and maximum of the values of a stat.
+struct Stat {
+    std::atomic<uint64_t> count { 0 };  //!< Values recorded.
+    std::atomic<uint64_t> sum { 0 };    //!< Their sum.
+    std::atomic<uint64_t> max { 0 };    //!< The largest one.
+};
+
+extern std::atomic<uint64_t> counters[COUNTERS];    //!< Value of each counter.
+extern Stat stats[STATS];                           //!< Value of each stat.
+
+} // NAMESPACE DETAIL
+
+/// Adds to a counter.
+inline void add(counter_e counter, uint64_t amount = 1)
+{
+    detail::counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+/// Records a value of a stat.
+inline void record(stat_e stat, uint64_t value)
+{
+    detail::Stat &s = detail::stats[stat];
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.sum.fetch_add(value, std::memory_order_relaxed);
+    for (uint64_t max = s.max.load(std::memory_order_relaxed);
+         value > max and not s.max.compare_exchange_weak(max, value, std::memory_order_relaxed); ) {
+        /* empty */
+    }
+}
+
+/// Records the nanoseconds of its lifetime into a stat.
+class Timer {
+public:
+    /// Starts timing.
+    explicit Timer(stat_e stat) : m_stat(stat), m_start(std::chrono::steady_clock::now()) { /* empty */ }
+    /// Records the time elapsed.
+    ~Timer() { record(m_stat, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count()); }
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+private:
+    stat_e m_stat;                                      //!< Stat the time goes to.
+    std::chrono::steady_clock::time_point m_start;      //!< When timing started.
+};
+
+/// Records the time between frames, and how much it changes from one frame to the next.
+class FrameClock {
+public:
+    /// Marks the start of a frame.
+    void tick() {
+        auto now = std::chrono::steady_clock::now();
+        if (m_frames > 0) {
+            int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last).count();
+            record(FRAME_NS, interval);
+            if (m_frames > 1)
+                record(JITTER_NS, interval > m_interval ? interval - m_interval : m_interval - interval);
+            m_interval = interval;
+        }
+        m_last = now;
+        ++m_frames;
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_last;   //!< Start of the last frame.
+    int64_t m_interval = 0;                         //!< Nanoseconds between the last two frames.
+    uint64_t m_frames = 0;                          //!< Frames started.
+};
+
+#else
+
+inline void add(counter_e, uint64_t = 1) { /* empty */ }
+inline void record(stat_e, uint64_t) { /* empty */ }
+
+class Timer {
+public:
+    explicit Timer(stat_e) { /* empty */ }
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+};
+
+class FrameClock {
+public:
+    void tick() { /* empty */ }
+};
+
+#endif
+
+} // NAMESPACE METRICS
+} // NAMESPACE SNAZE
+
+#endif
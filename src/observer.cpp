@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cstddef>
+
+#include "observer.h"
+#include "vector_env.h"
+
+namespace snaze {
+
+namespace {
+
+/// Code written for each cell type in the CODES format.
+constexpr Cell::cell_e CODE_OF[] = {
+    Cell::cell_e::WALL, Cell::cell_e::INV_WALL, Cell::cell_e::FREE, Cell::cell_e::FOOD,
+    Cell::cell_e::FREE, Cell::cell_e::SNAKE_HEAD, Cell::cell_e::SNAKE_BODY,
+    Cell::cell_e::DEATH_SNAKE_HEAD, Cell::cell_e::DEATH_SNAKE_BODY,
+};
+
+/// Plane set for each cell type in the PLANES and WINDOW formats, or PLANES for none.
+constexpr uint8_t PLANE_OF[] = {
+    Observer::WALL_PLANE, Observer::WALL_PLANE, Observer::PLANES, Observer::FOOD_PLANE,
+    Observer::PLANES, Observer::HEAD_PLANE, Observer::BODY_PLANE,
+    Observer::HEAD_PLANE, Observer::BODY_PLANE,
+};
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Prepares the writing of boards of a maze in a format.
+ *
+ * @param layout The walls of the maze; every game written must be on it.
+ * @param format How the board is written.
+ * @param radius Cells on each side of the head in the WINDOW format.
+ */
+Observer::Observer(const Layout &layout, format_e format, size_t radius)
+    : m_format(format), m_radius(radius), m_rows(layout.rows()), m_cols(layout.cols()),
+      m_walls(m_rows * m_cols)
+{
+    for (cell_t id = 0; id < m_walls.size(); ++id) {
+        Cell::cell_e type = layout.cells()[id].type();
+        bool wall = type == Cell::cell_e::WALL or type == Cell::cell_e::INV_WALL;
+        m_walls[id] = wall ? type : Cell::cell_e::FREE;
+    }
+}
+
+/**
+ * @brief Writes the board of a lookahead state.
+ *
+ * @param state The state, on the maze of the observer.
+ * @param out The board, `size()` bytes.
+ */
+void Observer::fill(const GameState &state, uint8_t *out) const
+{
+    encode([&](cell_t id) { return state.cell(id); }, state.length() > 0 ? state.head() : NO_CELL, out);
+}
+
+/**
+ * @brief Writes the board of a level.
+ *
+ * @param level The level, on the maze of the observer.
+ * @param out The board, `size()` bytes.
+ */
+void Observer::fill(const Level &level, uint8_t *out) const
+{
+    GridView grid = level.view();
+    cell_t head = level.snake().size() > 0 ? to_cell(level.snake().head(), m_cols) : NO_CELL;
+
+    encode([&](cell_t id) { return grid.at(id); }, head, out);
+}
+
+/**
+ * @brief Writes the board of one game of a vector of games.
+ *
+ * The games do not keep their cells, so the board is rebuilt from the
+ * walls, the stamps of the snake, the head and the food.
+ *
+ * @param env The games, on the maze of the observer.
+ * @param game The game to write.
+ * @param out The board, `size()` bytes.
+ */
+void Observer::fill(const VectorEnv &env, size_t game, uint8_t *out) const
+{
+    const cell_t head = env.head(game), food = env.food(game);
+
+    encode([&](cell_t id) {
+        if (id == head)
+            return Cell::cell_e::SNAKE_HEAD;
+        if (env.taken(game, id))
+            return Cell::cell_e::SNAKE_BODY;
+        return id == food ? Cell::cell_e::FOOD : m_walls[id];
+    }, head, out);
+}
+
+/**
+ * @brief Writes a board from the type of each cell and the head.
+ *
+ * The planes are cleared first and only the cells of some kind are set,
+ * so a board costs one pass over its cells whatever the format.
+ *
+ * @param code_of Returns the type of a cell of the maze.
+ * @param head The cell of the head, the center of a window; NO_CELL leaves a window empty.
+ * @param out The board, `size()` bytes.
+ */
+template <typename CodeOf>
+void Observer::encode(CodeOf code_of, cell_t head, uint8_t *out) const
+{
+    const size_t cells = m_rows * m_cols;
+
+    if (m_format == format_e::CODES) {
+        for (cell_t id = 0; id < cells; ++id)
+            out[id] = static_cast<uint8_t>(CODE_OF[static_cast<size_t>(code_of(id))]);
+        return;
+    }
+
+    const size_t area = height() * width();
+    std::fill(out, out + PLANES * area, 0);
+
+    if (m_format == format_e::PLANES) {
+        for (cell_t id = 0; id < cells; ++id) {
+            uint8_t plane = PLANE_OF[static_cast<size_t>(code_of(id))];
+            if (plane < PLANES)
+                out[plane * area + id] = 1;
+        }
+        return;
+    }
+
+    if (head == NO_CELL)
+        return;
+
+    // Rows and cols of the window before the maze wrap around and read as outside.
+    const size_t side = width();
+    const size_t top = head / m_cols - m_radius, left = head % m_cols - m_radius;
+    for (size_t r = 0; r < side; ++r) {
+        const size_t row = top + r;
+        for (size_t c = 0; c < side; ++c) {
+            const size_t col = left + c;
+            bool outside = row >= m_rows or col >= m_cols;
+            uint8_t plane = outside ? uint8_t(WALL_PLANE) : PLANE_OF[static_cast<size_t>(code_of(row * m_cols + col))];
+            if (plane < PLANES)
+                out[plane * area + r * side + c] = 1;
+        }
+    }
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,102 @@
+/**
+ * @file observer.h
+ *
+ * @description
+ * This class writes the board of a game into a buffer owned by the caller,
+ * for agents that read it as a tensor. The buffer is written in place on
+ * every call and nothing is allocated after construction, so the same
+ * buffer can be wrapped once (a NumPy array, a torch tensor) and refilled
+ * after each step.
+ *
+ * Every format is a dense C-order array of bytes of shape
+ * `channels() x height() x width()`, and a batch of games is that array
+ * repeated game after game, of shape `games x channels x height x width`:
+ *
+ * - CODES: one channel with the `Cell::cell_e` value of each cell of the
+ *   maze; spawn points read as free cells.
+ * - PLANES: one channel per `plane_e` over the whole maze, 1 where the cell
+ *   is of that kind and 0 elsewhere; free cells are 0 on every plane.
+ * - WINDOW: the same planes over a square of `2 * radius + 1` cells centered
+ *   on the head, in maze orientation; cells outside the maze read as walls.
+ */
+
+#ifndef OBSERVER_H
+#define OBSERVER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "cell.h"
+#include "common.h"
+#include "game_state.h"
+#include "layout.h"
+#include "level.h"
+
+namespace snaze {
+
+class VectorEnv;
+
+class Observer {
+public:
+    //== Enums
+
+    /// How the board is written.
+    enum class format_e : uint8_t {
+        CODES = 0,  //!< One byte per cell with its type.
+        PLANES,     //!< One 0/1 plane per kind of cell.
+        WINDOW,     //!< The planes around the head only.
+    };
+
+    /// Channel of each kind of cell in the PLANES and WINDOW formats.
+    enum plane_e : uint8_t {
+        WALL_PLANE = 0, //!< Walls, visible or not.
+        FOOD_PLANE,     //!< Foods.
+        HEAD_PLANE,     //!< The snake head.
+        BODY_PLANE,     //!< The rest of the snake.
+        PLANES,         //!< The number of planes.
+    };
+
+    /// Default constructor.
+    Observer() = default;
+    /// Prepares the writing of boards of a maze in a format.
+    Observer(const Layout &, format_e, size_t radius = 5);
+    /// Destructor.
+    ~Observer() = default;
+
+    /// Returns the format of the boards.
+    format_e format() const { return m_format; }
+    /// Returns the number of channels of a board.
+    size_t channels() const { return m_format == format_e::CODES ? 1 : PLANES; }
+    /// Returns the number of rows of a board.
+    size_t height() const { return m_format == format_e::WINDOW ? 2 * m_radius + 1 : m_rows; }
+    /// Returns the number of cols of a board.
+    size_t width() const { return m_format == format_e::WINDOW ? 2 * m_radius + 1 : m_cols; }
+    /// Returns the number of bytes of a board.
+    size_t size() const { return channels() * height() * width(); }
+    /// Returns the number of rows in the maze.
+    size_t rows() const { return m_rows; }
+    /// Returns the number of cols in the maze.
+    size_t cols() const { return m_cols; }
+
+    /// Writes the board of a lookahead state.
+    void fill(const GameState &, uint8_t *out) const;
+    /// Writes the board of a level.
+    void fill(const Level &, uint8_t *out) const;
+    /// Writes the board of one game of a vector of games.
+    void fill(const VectorEnv &, size_t game, uint8_t *out) const;
+
+private:
+    /// Writes a board from the type of each cell and the head.
+    template <typename CodeOf>
+    void encode(CodeOf code_of, cell_t head, uint8_t *out) const;
+
+    format_e m_format = format_e::CODES;    //!< How the board is written.
+    size_t m_radius = 0;                    //!< Cells on each side of the head in a window.
+    size_t m_rows = 0;                      //!< The number of rows in the maze.
+    size_t m_cols = 0;                      //!< The number of cols in the maze.
+    std::vector<Cell::cell_e> m_walls;      //!< Type of each cell without the snake nor the food.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
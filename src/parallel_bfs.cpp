@@ -0,0 +1,184 @@
+#include <algorithm>
+
+#include "parallel_bfs.h"
+#include "cell.h"
+#include "metrics.h"
+
+namespace snaze {
+
+/**
+ * @brief Searches from a cell, one layer at a time.
+ *
+ * Follows the rules of the player's time-aware BFS: a free cell or the food
+ * can always be entered, and a snake cell once the tail has left it by the
+ * step the search arrives. The search stops at the layer where the target
+ * is reached; a food as target stands for every food, and the first one in
+ * search order is returned. The cells expanded are counted as the serial
+ * search pops them, up to and including the one returned.
+ *
+ * @param grid The cells of the maze.
+ * @param vacate The move after which the snake leaves each cell.
+ * @param origin The cell where the search starts.
+ * @param target The cell to reach, or any food if it holds one.
+ * @param parent Receives the direction used to enter each reached cell.
+ * @return The cell reached, otherwise the last cell reached.
+ */
+cell_t ParallelBfs::search(const GridView &grid, const std::vector<size_t> &vacate, cell_t origin, cell_t target, std::vector<short> &parent)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const size_t cells = grid.rows() * grid.cols();
+    m_grid = &grid;
+    m_vacate = &vacate;
+
+    if (m_pool == nullptr and m_threads != 1)
+        m_pool = std::make_unique<ThreadPool>(m_threads);
+    const size_t threads = m_pool ? m_pool->size() : 1;
+    m_queues.resize(threads);
+
+    if (m_size != cells) {
+        m_keys = std::make_unique<std::atomic<key_t>[]>(cells);
+        m_size = cells;
+    }
+
+    // Forget the last search, each thread clearing a slice of the keys.
+    auto clear = [&](size_t thread) {
+        for (size_t id = cells * thread / threads; id < cells * (thread + 1) / threads; ++id)
+            m_keys[id].store(NONE, std::memory_order_relaxed);
+    };
+    if (m_pool)
+        m_pool->run(clear);
+    else
+        clear(0);
+
+    const bool any_food = grid.at(target) == Cell::cell_e::FOOD;
+
+    m_order.clear();
+    m_order.push_back(origin);
+    m_keys[origin].store(0, std::memory_order_relaxed);
+
+    for (size_t begin = 0, step = 0; begin < m_order.size(); ++step) {
+        const size_t end = m_order.size();
+
+        // The layer just found is checked in search order, as the serial search pops it.
+        if (any_food) {
+            for (size_t at = begin; at < end; ++at) {
+                if (grid.at(m_order[at]) == Cell::cell_e::FOOD) {
+                    metrics::add(metrics::NODES_EXPANDED, at + 1);
+                    return m_order[at];
+                }
+            }
+        }
+        else if (m_keys[target].load(std::memory_order_relaxed) != NONE) {
+            const size_t at = std::find(m_order.begin() + begin, m_order.begin() + end, target) - m_order.begin();
+            metrics::add(metrics::NODES_EXPANDED, at + 1);
+            return target;
+        }
+
+        if (end - begin < SERIAL_FRONTIER or threads == 1) {
+            m_queues[0].clear();
+            expand(begin, end, step, m_queues[0]);
+            settle(m_queues[0], parent);
+            for (const Claim &claim : m_queues[0])
+                m_order.push_back(claim.cell);
+        }
+        else {
+            const size_t size = end - begin;
+
+            m_pool->run([&](size_t thread) {
+                m_queues[thread].clear();
+                expand(begin + size * thread / threads, begin + size * (thread + 1) / threads, step, m_queues[thread]);
+            });
+            m_pool->run([&](size_t thread) { settle(m_queues[thread], parent); });
+
+            // Join the queues in thread order, which is the serial search order.
+            std::vector<size_t> offset(threads + 1, end);
+            for (size_t thread = 0; thread < threads; ++thread)
+                offset[thread + 1] = offset[thread] + m_queues[thread].size();
+            m_order.resize(offset[threads]);
+
+            m_pool->run([&](size_t thread) {
+                size_t at = offset[thread];
+                for (const Claim &claim : m_queues[thread])
+                    m_order[at++] = claim.cell;
+            });
+        }
+
+        begin = end;
+    }
+
+    metrics::add(metrics::NODES_EXPANDED, m_order.size());
+    return m_order.back();
+}
+
+/**
+ * @brief Expands a slice of the current layer into a queue.
+ *
+ * A cell is claimed with the position of its parent in the search order
+ * and the direction, which is the order the serial search discovers cells
+ * in. A claim only succeeds if it lowers the key of the cell, so cells of
+ * earlier layers are never claimed again.
+ *
+ * @param begin The position in the search order of the first cell to expand.
+ * @param end One past the position of the last cell to expand.
+ * @param step The number of moves that reach the cells being expanded.
+ * @param queue Receives the cells claimed, in increasing key order.
+ */
+void ParallelBfs::expand(size_t begin, size_t end, size_t step, std::vector<Claim> &queue) const
+{
+    const GridView &grid = *m_grid;
+    const std::vector<size_t> &vacate = *m_vacate;
+    const size_t rows = grid.rows(), cols = grid.cols();
+
+    for (size_t i = begin; i < end; ++i) {
+        const cell_t curr = m_order[i];
+        const size_t r = curr / cols, c = curr % cols;
+
+        for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+            cell_t next = dir == UP    ? (r > 0 ? curr - cols : NO_CELL)
+                        : dir == LEFT  ? (c > 0 ? curr - 1 : NO_CELL)
+                        : dir == DOWN  ? (r + 1 < rows ? curr + cols : NO_CELL)
+                        :                (c + 1 < cols ? curr + 1 : NO_CELL);
+            if (next == NO_CELL)
+                continue;
+
+            Cell::cell_e type = grid.at(next);
+            bool is_snake = type == Cell::cell_e::SNAKE_BODY or type == Cell::cell_e::SNAKE_HEAD;
+
+            // A snake cell is open once the tail has left it by the time we arrive.
+            if (not grid.open(next) and not (is_snake and vacate[next] <= step + 1))
+                continue;
+
+            const key_t key = i * 4 + dir;
+            key_t seen = m_keys[next].load(std::memory_order_relaxed);
+            while (key < seen) {
+                if (m_keys[next].compare_exchange_weak(seen, key, std::memory_order_relaxed)) {
+                    queue.push_back({ next, key });
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Keeps the claims of a queue no other thread beat.
+ *
+ * A cell claimed by several threads keeps the smallest key, so exactly one
+ * queue holds it afterwards, and only that thread writes its parent.
+ *
+ * @param queue The claims of a thread, compacted in place.
+ * @param parent Receives the direction used to enter each kept cell.
+ */
+void ParallelBfs::settle(std::vector<Claim> &queue, std::vector<short> &parent) const
+{
+    auto kept = std::remove_if(queue.begin(), queue.end(), [&](const Claim &claim) {
+        return m_keys[claim.cell].load(std::memory_order_relaxed) != claim.key;
+    });
+    queue.erase(kept, queue.end());
+
+    for (const Claim &claim : queue)
+        parent[claim.cell] = claim.key % 4;
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,77 @@
+/**
+ * @file parallel_bfs.h
+ *
+ * @description
+ * This class runs the time-aware BFS of the player one layer at a time,
+ * spreading each large layer over a thread pool. Every thread expands a
+ * contiguous slice of the frontier into its own queue, marking cells with
+ * an atomic minimum of a key that orders discoveries exactly as the serial
+ * search would (the position of the parent in the search order, then the
+ * direction). The queues are then filtered and joined in thread order, so
+ * parents and the search order, and thus the paths, match the serial BFS
+ * for any number of threads. Small layers are expanded serially.
+ */
+
+#ifndef PARALLEL_BFS_H
+#define PARALLEL_BFS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+#include "grid_view.h"
+#include "thread_pool.h"
+
+namespace snaze {
+
+class ParallelBfs {
+public:
+    /// Layers with fewer cells than this are expanded by the calling thread alone.
+    static constexpr size_t SERIAL_FRONTIER = 4096;
+    /// Largest maze the keys can order.
+    static constexpr size_t MAX_CELLS = UINT32_MAX / 4;
+
+    /// Creates a search for the given number of threads; 0 uses every hardware thread.
+    explicit ParallelBfs(size_t threads = 0) : m_threads(threads) { /* empty */ }
+    /// Destructor.
+    ~ParallelBfs() = default;
+
+    /// Searches from a cell, writing the direction used to enter each reached cell.
+    cell_t search(const GridView &, const std::vector<size_t> &vacate, cell_t origin, cell_t target, std::vector<short> &parent);
+
+private:
+    //== Aliases
+    using key_t = uint32_t;
+
+    /// Key of a cell not reached yet.
+    static constexpr key_t NONE = UINT32_MAX;
+
+    /// A cell claimed by a thread in the current layer.
+    struct Claim {
+        cell_t cell;    //!< The cell reached.
+        key_t key;      //!< Key it was claimed with.
+    };
+
+    /// Expands the cells of the search order in [begin, end) into a queue.
+    void expand(size_t begin, size_t end, size_t step, std::vector<Claim> &) const;
+    /// Keeps the claims of a queue no other thread beat, recording their parents.
+    void settle(std::vector<Claim> &, std::vector<short> &parent) const;
+
+    size_t m_threads;                             //!< Threads requested for the pool.
+    std::unique_ptr<ThreadPool> m_pool;           //!< Pool, started by the first large search.
+    std::mutex m_mutex;                           //!< Serializes searches sharing the pool.
+    std::unique_ptr<std::atomic<key_t>[]> m_keys; //!< Smallest key each cell was claimed with.
+    size_t m_size = 0;                            //!< Number of cells in the key array.
+    std::vector<cell_t> m_order;                  //!< Cells in the order they were reached.
+    std::vector<std::vector<Claim>> m_queues;     //!< Claims of each thread in the current layer.
+
+    const GridView *m_grid = nullptr;             //!< Grid of the current search.
+    const std::vector<size_t> *m_vacate = nullptr; //!< Vacate times of the current search.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -1,19 +1,64 @@
-#include <cstring>
+#include <cstdint>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "player.h"
 #include "common.h"
+#include "hierarchical.h"
+#include "metrics.h"
 
 
 namespace snaze {
 
+namespace {
+
+/**
+ * @brief Returns the direction of a step between two cells in the same row or col.
+ * 
+ * @param from The cell where the step starts.
+ * @param to The cell where the step ends.
+ * @return The direction that leads from one cell towards the other.
+ */
+dir_e step_direction(const Position &from, const Position &to)
+{
+    return to.row < from.row ? UP
+         : to.row > from.row ? DOWN
+         : to.col < from.col ? LEFT
+         : RIGHT;
+}
+
+/// Mazes with fewer cells than this are searched by a single thread.
+constexpr size_t PARALLEL_CELLS = 1 << 16;
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Points the player at the live level, keeping the planner state.
+ * 
+ * Called before each new food, so planners that keep memory between
+ * searches do not lose it by creating a new player. The level is not
+ * copied: the player reads the game's level, which must outlive it.
+ * 
+ * @param level The current maze.
+ */
+void Player::reset(const Level &level)
+{
+    m_level = &level;
+    m_paths.clear();
+    m_directions.clear();
+    m_waypoints.clear();
+    m_descending = false;
+    m_incremental = false;
+    m_searching = false;
+}
+
 /**
  * @brief Finds a solution path from the start to the end position in the maze.
  * 
- * This function uses a breadth-first search algorithm to find a path from the
- * start position to the end position in the maze. It stores the found path and
- * directions taken in member variables.
+ * This function dispatches to the search strategy selected for the player,
+ * and counts the search and the length of the path found in the metrics.
+ * The found path and directions are stored in member variables.
  * 
  * @param start The starting position in the maze.
  * @param end The target position to reach in the maze.
@@ -21,89 +66,712 @@ namespace snaze {
  */
 bool Player::find_solution(const Position &start, const Position &end) 
 {
-    std::queue<Position> queue;
-    std::queue<std::deque<Position>> q_pos;
-    std::queue<std::deque<dir_e>> q_dir;
+    metrics::Timer timer(metrics::PLAN_NS);
+    metrics::add(metrics::SEARCHES);
 
-    std::deque<Position> path_to_death;
-    std::deque<dir_e> dirs_to_death;
+    bool found = plan_path(start, end);
+    if (found and not m_paths.empty())
+        metrics::record(metrics::PATH_LENGTH, m_paths.size() - 1);
 
-    // Initialize visited array to track visited positions.
-    bool visited[m_level.rows()][m_level.cols()];
-    memset(visited, false, sizeof(visited));
+    return found;
+}
 
-    visited[start.row][start.col] = true;
+/**
+ * @brief Runs the search strategy selected for the player.
+ * 
+ * The breadth-first searches stop at whichever food they reach first, and
+ * the gradient player descends a field rooted at every food. The planners
+ * that need a single goal head for the food nearest to the start along
+ * the maze, found on that same kind of field.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::plan_path(const Position &start, const Position &end)
+{
+    if (m_type == player_e::TIMED)
+        return find_timed_solution(start, end);
+    if (m_type == player_e::BACKTRACKING)
+        return find_static_solution(start, end);
 
-    queue.push(start);
-    q_pos.push({ start });
-    q_dir.push({});
+    if (m_type == player_e::GRADIENT)
+        return find_field_solution(start, end);
 
-    while (!queue.empty()) {
-        Position curr_pos = queue.front();
-        auto directions = q_dir.front();
-        auto positions = q_pos.front();
+    const Position goal = nearest_food(start, end);
+    if (m_type == player_e::HAMILTONIAN)
+        return find_cycle_solution(start, goal);
+    if (m_type == player_e::JUMP_POINT)
+        return find_jump_solution(start, goal);
+    if (m_type == player_e::HIERARCHICAL)
+        return find_hierarchical_solution(start, goal);
+    if (m_type == player_e::INCREMENTAL)
+        return find_incremental_solution(start, goal);
+    if (m_type == player_e::MCTS)
+        return find_search_solution(start, goal);
 
-        queue.pop();
-        q_dir.pop();
-        q_pos.pop();
+    return find_static_solution(start, end);
+}
+
+/**
+ * @brief Returns the food nearest to a position along the maze.
+ * 
+ * With several foods on the board, a distance field rooted at all of them
+ * is descended from the position; the food it ends on is the nearest one
+ * around the walls and the snake body. A lone food needs no search.
+ * 
+ * @param from The position to measure from, usually the snake head.
+ * @param end The target asked for; kept if it is not a food on the board.
+ * @return The nearest food, or the target if it is not a food or no food can be reached.
+ */
+Position Player::nearest_food(const Position &from, const Position &end) const
+{
+    if (m_level->cell(end) != Cell::cell_e::FOOD or m_level->foods().size() < 2)
+        return end;
 
-        if (curr_pos == end) {
-            // Found a path to the end position.
-            m_paths = positions;
-            m_directions = directions;
-            m_directions.push_back(m_directions.back()); // Ensure directions include the last move.
+    const DistanceField field(*m_level, m_level->foods());
 
+    // Each step lowers the distance by one, down to the food at distance zero.
+    Position curr = from;
+    do {
+        auto dir = field.descend(curr);
+        if (not dir)
+            return end;
+        curr = m_level->move_to(curr, *dir);
+    } while (field.at(curr) != 0);
+
+    return curr;
+}
+
+/**
+ * @brief Finds a path treating every snake segment as a permanent wall.
+ * 
+ * This function uses a breadth-first search algorithm to find a path from the
+ * start position to the end position in the maze. Each cell keeps only the
+ * direction used to enter it, and the path is rebuilt from those once the
+ * search ends. Heading for a food, it stops at whichever food it reaches first.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::find_static_solution(const Position &start, const Position &end) 
+{
+    constexpr short UNSEEN = -1;    // Cell not reached yet.
+    constexpr short ROOT = 4;       // Marks the start cell in the parent array.
+
+    const GridView grid = m_level->view();
+
+    // Direction used to enter each cell; doubles as the visited array.
+    std::vector<short> parent(grid.rows() * grid.cols(), UNSEEN);
+    std::queue<cell_t> queue;
+
+    const cell_t origin = cell_of(start), target = cell_of(end);
+    parent[origin] = ROOT;
+
+    const bool any_food = grid.at(target) == Cell::cell_e::FOOD;
+    auto reached = [&](cell_t id) { return id == target or (any_food and grid.at(id) == Cell::cell_e::FOOD); };
+
+    // Large mazes go to the layered search, with a snake that never leaves its cells.
+    if (m_parallel and parent.size() >= PARALLEL_CELLS and parent.size() <= ParallelBfs::MAX_CELLS) {
+        const std::vector<size_t> vacate(parent.size(), SIZE_MAX);
+        cell_t last = m_parallel->search(grid, vacate, origin, target, parent);
+        build_path(start, position_of(last), parent);
+        return reached(last);
+    }
+
+    queue.push(origin);
+
+    cell_t last = origin; // Last cell discovered, used as a path to death.
+    size_t expanded = 0;
+
+    while (!queue.empty()) {
+        cell_t curr = queue.front();
+        queue.pop();
+        ++expanded;
+
+        if (reached(curr)) {
+            build_path(start, position_of(curr), parent);
+            metrics::add(metrics::NODES_EXPANDED, expanded);
             return true;
         }
 
-        // Explore all four possible directions (UP, LEFT, DOWN, RIGHT).
         for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
-            if (!m_level.is_blocked(curr_pos, dir)) {
-                Position next = m_level.move_to(curr_pos, dir);
+            Position next = m_level->move_to(position_of(curr), dir);
 
-                if (!visited[next.row][next.col]) {
-                    visited[next.row][next.col] = true;
+            // Positions outside the maze wrap around to huge indices.
+            if (not grid.contains(next))
+                continue;
 
-                    // Create new path and directions including the current move.
-                    std::deque<Position> new_path = positions;
-                    new_path.push_back(next);
+            cell_t id = cell_of(next);
+            if (parent[id] == UNSEEN and grid.open(id)) {
+                parent[id] = dir;
+                queue.push(id);
+                last = id;
+            }
+        }
+    }
 
-                    std::deque<dir_e> new_directions = directions;
-                    new_directions.push_back(dir);
+    // If no path to the end is found, use the path to death as fallback.
+    build_path(start, position_of(last), parent);
+    metrics::add(metrics::NODES_EXPANDED, expanded);
 
-                    // Enqueue the next position, updated path, and directions.
-                    queue.push(next);
-                    q_pos.push(new_path);
-                    q_dir.push(new_directions);
+    return false;
+}
 
-                    // Store the path to death in case no valid path is found.
-                    path_to_death = new_path;
-                    dirs_to_death = new_directions;
-                }
+/**
+ * @brief Finds a path that accounts for the snake's tail moving away.
+ * 
+ * Every snake segment is stamped with the number of moves after which it
+ * leaves its cell. Since BFS reaches cells in non-decreasing step order, a
+ * body cell can be entered as soon as the step that reaches it is not smaller
+ * than its stamp, which keeps the search linear in the size of the maze.
+ * Heading for a food, it stops at whichever food it reaches first.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::find_timed_solution(const Position &start, const Position &end)
+{
+    constexpr short UNSEEN = -1;    // Cell not reached yet.
+    constexpr short ROOT = 4;       // Marks the start cell in the parent array.
+
+    const GridView grid = m_level->view();
+    const std::vector<size_t> vacate = vacate_times();
+
+    // Direction used to enter each cell; doubles as the visited array.
+    std::vector<short> parent(grid.rows() * grid.cols(), UNSEEN);
+    std::queue<std::pair<cell_t, cell_t>> queue; // Pairs of cell and step.
+
+    const cell_t origin = cell_of(start), target = cell_of(end);
+    parent[origin] = ROOT;
+
+    // Heading for a food, the search stops at whichever food it reaches first.
+    const bool any_food = grid.at(target) == Cell::cell_e::FOOD;
+    auto reached = [&](cell_t id) { return id == target or (any_food and grid.at(id) == Cell::cell_e::FOOD); };
+
+    // Large mazes are searched layer by layer over several threads, finding the same path.
+    if (m_parallel and parent.size() >= PARALLEL_CELLS and parent.size() <= ParallelBfs::MAX_CELLS) {
+        cell_t last = m_parallel->search(grid, vacate, origin, target, parent);
+        build_path(start, position_of(last), parent);
+        return reached(last);
+    }
+
+    queue.push({ origin, 0 });
+
+    cell_t last = origin; // Last cell discovered, used as a path to death.
+    size_t expanded = 0;
+
+    while (!queue.empty()) {
+        auto [curr, step] = queue.front();
+        queue.pop();
+        ++expanded;
+
+        if (reached(curr)) {
+            build_path(start, position_of(curr), parent);
+            metrics::add(metrics::NODES_EXPANDED, expanded);
+            return true;
+        }
+
+        for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
+            Position next = m_level->move_to(position_of(curr), dir);
+
+            // Positions outside the maze wrap around to huge indices.
+            if (not grid.contains(next))
+                continue;
+
+            cell_t id = cell_of(next);
+            if (parent[id] != UNSEEN)
+                continue;
+
+            Cell::cell_e type = grid.at(id);
+            bool is_snake = type == Cell::cell_e::SNAKE_BODY or type == Cell::cell_e::SNAKE_HEAD;
+
+            // A snake cell is open once the tail has left it by the time we arrive.
+            if (grid.open(id) or (is_snake and vacate[id] <= step + 1)) {
+                parent[id] = dir;
+                queue.push({ id, step + 1 });
+                last = id;
             }
         }
     }
 
     // If no path to the end is found, use the path to death as fallback.
-    m_paths = path_to_death;
-    m_directions = dirs_to_death;
-    m_directions.push_back(m_directions.back()); // Ensure directions include the last move.
+    build_path(start, position_of(last), parent);
+    metrics::add(metrics::NODES_EXPANDED, expanded);
 
     return false;
 }
 
+/**
+ * @brief Finds a path to the food by following the level's Hamiltonian cycle.
+ * 
+ * While the snake body lies in cycle order from tail to head, every cell ahead
+ * of the head and behind the tail is free, so following the cycle never
+ * collides. A shortcut to a neighbor further along the cycle is taken only if
+ * it does not pass the food and leaves a gap to the tail, which keeps the body
+ * in cycle order. Each move costs O(1). If the head or the food is not on the
+ * cycle, the time-aware BFS is used instead.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::find_cycle_solution(const Position &start, const Position &end)
+{
+    const HamiltonianCycle &cycle = m_level->cycle();
+
+    if (not cycle.contains(start) or not cycle.contains(end))
+        return find_timed_solution(start, end);
+
+    std::deque<cell_t> body = m_level->snake().body();
+
+    // Right after eating, the front of the body repeats the head and the tail waits one move.
+    bool growing = body.size() > 1 and body.front() == cell_of(start);
+    if (growing)
+        body.pop_front();
+
+    // Check whether the body lies in cycle order from tail to head.
+    bool ordered = true;
+    const Position tail = position_of(body.front());
+    for (size_t i = 0; i < body.size() and ordered; ++i) {
+        if (not cycle.contains(position_of(body[i])))
+            ordered = false;
+        else if (i > 0 and cycle.distance(tail, position_of(body[i])) <= cycle.distance(tail, position_of(body[i - 1])))
+            ordered = false;
+    }
+
+    // Shortcuts are only worth the risk while the snake fills less than half of the cycle.
+    bool shortcuts = ordered and body.size() * 2 < cycle.size();
+
+    // Without the cycle order, plain cycle moves must be checked against the body.
+    std::vector<size_t> vacate;
+    if (not ordered)
+        vacate = vacate_times();
+
+    m_paths = { cell_of(start) };
+    m_directions.clear();
+
+    Position curr = start;
+    for (size_t step = 0; not (curr == end); ++step) {
+        dir_e dir = cycle.next(curr);
+
+        if (shortcuts) {
+            size_t to_food = cycle.distance(curr, end);
+            size_t to_tail = body.front() == cell_of(curr) ? cycle.size() : cycle.distance(curr, position_of(body.front()));
+            size_t best = 1;
+
+            for (const dir_e d : { UP, LEFT, DOWN, RIGHT }) {
+                Position neighbor = m_level->move_to(curr, d);
+                if (not cycle.contains(neighbor))
+                    continue;
+
+                // Never jump past the food and keep room for the pending growth.
+                size_t gap = cycle.distance(curr, neighbor);
+                if (gap > best and gap <= to_food and gap + 2 < to_tail) {
+                    best = gap;
+                    dir = d;
+                }
+            }
+        }
+        else if (not ordered) {
+            Position next = m_level->move_to(curr, dir);
+            Cell::cell_e type = m_level->cell(next);
+            bool is_snake = type == Cell::cell_e::SNAKE_BODY or type == Cell::cell_e::SNAKE_HEAD;
+
+            if (is_snake and vacate[cell_of(next)] > step + 1)
+                return find_timed_solution(start, end);
+        }
+
+        Position next = m_level->move_to(curr, dir);
+
+        // Simulate the snake so the tail is known for the next shortcut.
+        body.push_back(cell_of(next));
+        if (growing)
+            growing = false;
+        else
+            body.pop_front();
+
+        m_paths.push_back(cell_of(next));
+        m_directions.push_back(dir);
+        curr = next;
+    }
+
+    // Ensure directions include the last move.
+    m_directions.push_back(m_directions.empty() ? m_level->snake().direction() : m_directions.back());
+
+    return true;
+}
+
+/**
+ * @brief Prepares the player to reach the food by descending a distance field.
+ * 
+ * A single reverse BFS from every food gives the distance of each cell to
+ * the nearest one, so no path is stored: each move reads the four neighbors of the head. If no
+ * neighbor of the head reaches the food, the time-aware BFS is used instead.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::find_field_solution(const Position &start, const Position &end)
+{
+    if (m_level->cell(end) == Cell::cell_e::FOOD)
+        m_field = DistanceField(*m_level, m_level->foods());
+    else
+        m_field = DistanceField(*m_level, end);
+    m_paths.clear();
+    m_directions.clear();
+
+    auto dir = m_field.descend(start);
+    if (not dir or m_field.at(m_level->move_to(start, *dir)) == DistanceField::INF) {
+        m_descending = false;
+        return find_timed_solution(start, end);
+    }
+
+    m_descending = true;
+    m_moved = false;
+    m_head = start;
+    m_last_dir = *dir;
+    m_head_dist = DistanceField::INF;
+
+    return true;
+}
+
+/**
+ * @brief Returns the next step along the distance field gradient.
+ * 
+ * The game applies each move to the level before asking for the next one,
+ * so the cell the tail left on the last move is read from the live level
+ * and released in the field. If the gradient stops getting closer to the
+ * food, the rest of the way is planned with the time-aware BFS.
+ * 
+ * @return A pair containing the current head position and the direction to move.
+ */
+Player::direction Player::descend_field()
+{
+    // Keep the field in sync with the cell the last move freed.
+    if (m_moved and m_level->cell(m_tail) == Cell::cell_e::FREE)
+        m_field.release(m_tail);
+
+    auto dir = m_field.descend(m_head);
+    Position next = dir ? m_level->move_to(m_head, *dir) : m_head;
+
+    if (not dir or m_field.at(next) >= m_head_dist) {
+        m_descending = false;
+        metrics::add(metrics::REPLANS);
+        find_timed_solution(m_head, m_field.target());
+        return next_move();
+    }
+
+    m_tail = m_level->snake().tail();
+    m_moved = true;
+    m_head_dist = m_field.at(next);
+    m_field.occupy(next);
+
+    auto step = std::make_pair(m_head, *dir);
+    m_head = next;
+    m_last_dir = *dir;
+
+    return step;
+}
+
+/**
+ * @brief Finds a shortest path with Jump Point Search.
+ * 
+ * The search only returns the jump points of the path, which are expanded
+ * here into single steps. If the food is unreachable, the time-aware BFS
+ * provides the fallback path.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::find_jump_solution(const Position &start, const Position &end)
+{
+    std::vector<Position> points = m_jps.search(*m_level, start, end);
+    metrics::add(metrics::NODES_EXPANDED, m_jps.expanded());
+
+    if (points.empty())
+        return find_timed_solution(start, end);
+
+    m_paths = { cell_of(start) };
+    m_directions.clear();
+
+    // Jump points are on straight lines, so each segment is walked in one direction.
+    for (size_t i = 1; i < points.size(); ++i) {
+        const Position &from = points[i - 1], &to = points[i];
+        dir_e dir = step_direction(from, to);
+
+        for (Position curr = from; not (curr == to); ) {
+            curr = m_level->move_to(curr, dir);
+            m_paths.push_back(cell_of(curr));
+            m_directions.push_back(dir);
+        }
+    }
+
+    // Ensure directions include the last move.
+    m_directions.push_back(m_directions.empty() ? m_level->snake().direction() : m_directions.back());
+
+    return true;
+}
+
+/**
+ * @brief Finds the waypoints of a path over the level's cluster graph.
+ * 
+ * Only the segment up to the first waypoint is refined into steps; the
+ * following ones are refined as the snake reaches each waypoint. If the
+ * level has no cluster graph or the food is unreachable, the time-aware
+ * BFS is used instead.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::find_hierarchical_solution(const Position &start, const Position &end)
+{
+    const HierarchicalMap *map = m_level->hierarchy();
+    m_waypoints = map ? map->abstract_path(*m_level, start, end, m_repairs) : std::vector<Position>{};
+    m_next_waypoint = 1;
+
+    m_paths = { cell_of(start) };
+    m_directions = { m_level->snake().direction() };
+
+    if (m_waypoints.size() < 2 or not refine_next_segment()) {
+        m_waypoints.clear();
+        return find_timed_solution(start, end);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Appends the steps up to the next waypoint to the path.
+ * 
+ * The segment is refined on the live level when the snake reaches the
+ * previous waypoint, so it avoids the snake as it is at that moment.
+ * 
+ * @return true if the segment is reachable, false otherwise.
+ */
+bool Player::refine_next_segment()
+{
+    Position from = position_of(m_paths.back());
+    std::vector<Position> steps = m_level->hierarchy()->refine(*m_level, from, m_waypoints[m_next_waypoint]);
+
+    if (steps.empty())
+        return false;
+
+    // Replace the repeated last move with the moves of the new segment.
+    m_directions.pop_back();
+    for (const Position &step : steps) {
+        m_directions.push_back(step_direction(from, step));
+        m_paths.push_back(cell_of(step));
+        from = step;
+    }
+    m_directions.push_back(m_directions.back());
+
+    ++m_next_waypoint;
+
+    return true;
+}
+
+/**
+ * @brief Starts an incremental search towards the food.
+ * 
+ * The search is rooted at the food and kept while the snake walks, so no
+ * path is stored: moves are read from the planner one at a time. If the
+ * food is unreachable, the time-aware BFS is used instead.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::find_incremental_solution(const Position &start, const Position &end)
+{
+    m_paths.clear();
+    m_directions.clear();
+
+    bool found = m_planner.plan(*m_level, start, end);
+    metrics::add(metrics::NODES_EXPANDED, m_planner.expanded());
+
+    if (not found) {
+        m_incremental = false;
+        return find_timed_solution(start, end);
+    }
+
+    m_incremental = true;
+    m_moved = false;
+    m_head = start;
+
+    return true;
+}
+
+/**
+ * @brief Returns the next step chosen by the incremental planner.
+ * 
+ * The game applies each move to the level before asking for the next one,
+ * so only the cell the head entered and the cell the tail left on the
+ * last move are repaired before choosing the next direction. If the snake
+ * cut itself off from the food, the rest of the way is planned with the
+ * time-aware BFS.
+ * 
+ * @return A pair containing the current head position and the direction to move.
+ */
+Player::direction Player::follow_incremental()
+{
+    if (m_moved) {
+        size_t expanded = m_planner.expanded();
+        m_planner.move(*m_level, m_head, { m_head, m_tail });
+        metrics::add(metrics::NODES_EXPANDED, m_planner.expanded() - expanded);
+    }
+
+    auto dir = m_planner.next();
+    if (not dir) {
+        m_incremental = false;
+        metrics::add(metrics::REPLANS);
+        find_timed_solution(m_head, m_planner.goal());
+        return next_move();
+    }
+
+    m_tail = m_level->snake().tail();
+    m_moved = true;
+
+    auto step = std::make_pair(m_head, *dir);
+    m_head = m_level->move_to(m_head, *dir);
+
+    return step;
+}
+
+/**
+ * @brief Checks that the food is reachable before searching move by move.
+ * 
+ * The tree search picks one move at a time, so here the time-aware BFS only
+ * decides whether the food can be reached; if it cannot, its path to death
+ * is followed like the other players do.
+ * 
+ * @param start The starting position in the maze.
+ * @param end The target position to reach in the maze.
+ * @return true if a path is found from start to end, false otherwise.
+ */
+bool Player::find_search_solution(const Position &start, const Position &end)
+{
+    m_searching = find_timed_solution(start, end);
+    if (m_searching) {
+        m_paths.clear();
+        m_directions.clear();
+    }
+
+    return m_searching;
+}
+
+/**
+ * @brief Returns the next step chosen by the tree search.
+ * 
+ * The search starts from the live level on every move. If every move is
+ * fatal, the rest of the way is planned with the time-aware BFS.
+ * 
+ * @return A pair containing the current head position and the direction to move.
+ */
+Player::direction Player::follow_search()
+{
+    Position head = m_level->snake().head();
+    auto dir = m_search.search(*m_level);
+    if (not dir) {
+        m_searching = false;
+        metrics::add(metrics::REPLANS);
+        find_timed_solution(head, m_level->food());
+        return next_move();
+    }
+
+    return std::make_pair(head, *dir);
+}
+
+/**
+ * @brief Computes how many moves it takes the snake to leave each cell.
+ * 
+ * The snake body is stored from tail to head, so the i-th segment is released
+ * after i + 1 moves. Cells that appear twice (right after eating) keep the
+ * largest stamp. Cells not occupied by the snake are stamped with zero.
+ * 
+ * @return A vector indexed by row * cols + col with the vacate step of each cell.
+ */
+std::vector<size_t> Player::vacate_times() const
+{
+    std::vector<size_t> vacate(m_level->rows() * m_level->cols(), 0);
+
+    size_t moves = 1;
+    for (cell_t cell : m_level->snake().body())
+        vacate[cell] = moves++;
+
+    return vacate;
+}
+
+/**
+ * @brief Rebuilds the path and directions from a BFS parent array.
+ * 
+ * Walks the parent directions back from the end position to the start and
+ * stores the resulting path and directions in the member variables.
+ * 
+ * @param start The position where the search started.
+ * @param end The position where the path must finish.
+ * @param parent The direction used to enter each cell during the search.
+ */
+void Player::build_path(const Position &start, const Position &end, const std::vector<short> &parent)
+{
+    m_paths.clear();
+    m_directions.clear();
+
+    Position curr = end;
+    while (!(curr == start)) {
+        dir_e dir = static_cast<dir_e>(parent[cell_of(curr)]);
+
+        m_paths.push_front(cell_of(curr));
+        m_directions.push_front(dir);
+
+        // Step back against the direction used to enter the cell.
+        curr = m_level->move_to(curr, static_cast<dir_e>((dir + 2) % 4));
+    }
+    m_paths.push_front(cell_of(start));
+
+    // Ensure directions include the last move.
+    m_directions.push_back(m_directions.empty() ? m_level->snake().direction() : m_directions.back());
+}
+
 /**
  * @brief Retrieves the next move to be made by the player.
  * 
  * This function retrieves the next position and direction from the front
- * of the dequeues storing the player's movement path and directions.
+ * of the dequeues storing the player's movement path and directions, or
+ * from the distance field when the player is descending it. Past the end
+ * of its path, the snake keeps going the way it faces until it eats or
+ * hits something.
  * 
  * @return A pair containing the next position and direction to move.
  */
 std::pair<Position, dir_e> Player::next_move()
 {
+    if (m_descending)
+        return descend_field();
+    if (m_incremental)
+        return follow_incremental();
+    if (m_searching)
+        return follow_search();
+
+    // Refine the hierarchical path once the snake stands on a waypoint.
+    if (m_paths.size() == 1 and m_next_waypoint < m_waypoints.size()) {
+        // If the snake now blocks the segment, plan again from the waypoint.
+        if (not refine_next_segment()) {
+            metrics::add(metrics::REPLANS);
+            find_hierarchical_solution(position_of(m_paths.front()), m_waypoints.back());
+        }
+    }
+
+    if (m_paths.empty())
+        return std::make_pair(m_level->snake().head(), m_level->snake().direction());
+
     // Get the next position and direction from the front of the deques.
-    Position pos = m_paths.front();
+    Position pos = position_of(m_paths.front());
     dir_e dir = m_directions.front();
 
     // Remove the front elements from the deques.
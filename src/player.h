@@ -11,8 +11,16 @@
 #define PLAYER_H
 
 #include <deque>
+#include <memory>
+#include <vector>
 #include "common.h"
+#include "distance_field.h"
+#include "hierarchical.h"
+#include "incremental.h"
+#include "jump_point.h"
 #include "level.h"
+#include "mcts.h"
+#include "parallel_bfs.h"
 
 namespace snaze {
 
@@ -24,23 +32,99 @@ public:
     /// Default constructor.
     Player() = default;
     /// Default constructor.
-    Player(const Level& level) : m_level(level) { /* empty */ }
+    Player(const Level& level, player_e type = player_e::BACKTRACKING)
+        : m_level(&level), m_type(type) { /* empty */ }
     /// Destructor.
     ~Player() = default;
 
+    /// Points the player at the live level, keeping the planner state.
+    void reset(const Level &);
+    /// Points the player at another copy of the level, keeping the current plan.
+    void rebind(const Level &level) { m_level = &level; }
+    /// Checks whether every remaining step of the plan is already known.
+    bool planned() const {
+        return not m_descending and not m_incremental and not m_searching and m_next_waypoint >= m_waypoints.size();
+    }
     /// Returns the shortest path from the snake's origin to the food.
     bool find_solution(const Position &, const Position &);
     /// Return the next step to the food.
     direction next_move();
-    /// Returns the target position of the snake.
-    Position last_move() const { return m_paths.back(); }
     /// Returns the number of steps to the destination.
     size_t amount_of_steps() const { return m_paths.size(); }
+    /// Returns the distance field being descended, or nullptr when following a path.
+    const DistanceField *field() const { return m_descending ? &m_field : nullptr; }
+    /// Returns the tree search of the MCTS player, or nullptr for the other players.
+    const MonteCarloPlanner *search() const { return m_type == player_e::MCTS ? &m_search : nullptr; }
+    /// Returns the tree search of the MCTS player, or nullptr for the other players.
+    MonteCarloPlanner *search() { return m_type == player_e::MCTS ? &m_search : nullptr; }
+    /// Spreads the breadth-first searches of large mazes over the given number of threads.
+    void parallelize(size_t threads) { m_parallel = std::make_shared<ParallelBfs>(threads); }
+    /// Sets the threads, playouts per move, time per move and seed of the tree search.
+    void configure_search(size_t threads, size_t rollouts, MonteCarloPlanner::clock::duration budget, Rng::state_t seed) {
+        m_search.configure(threads, rollouts, budget, seed);
+    }
 
 private:
-    Level m_level;                  //!< The maze grid.
-    std::deque<Position> m_paths;   //!< Stores the found positions.
+    /// Runs the search strategy selected for the player.
+    bool plan_path(const Position &, const Position &);
+    /// Returns the food nearest to a position along the maze, or the target if it is not a food.
+    Position nearest_food(const Position &, const Position &) const;
+    /// Breadth-first search that treats every snake segment as a wall.
+    bool find_static_solution(const Position &, const Position &);
+    /// Breadth-first search that lets the snake enter cells its tail has already vacated.
+    bool find_timed_solution(const Position &, const Position &);
+    /// Follows the level's Hamiltonian cycle, taking shortcuts that keep the cycle order.
+    bool find_cycle_solution(const Position &, const Position &);
+    /// Computes a distance field rooted at the foods to be descended move by move.
+    bool find_field_solution(const Position &, const Position &);
+    /// Returns the next step along the distance field gradient.
+    direction descend_field();
+    /// Finds a shortest path with Jump Point Search.
+    bool find_jump_solution(const Position &, const Position &);
+    /// Finds the waypoints of a path over the level's cluster graph.
+    bool find_hierarchical_solution(const Position &, const Position &);
+    /// Appends the steps up to the next waypoint to the path.
+    bool refine_next_segment();
+    /// Starts an incremental search towards the food.
+    bool find_incremental_solution(const Position &, const Position &);
+    /// Returns the next step chosen by the incremental planner.
+    direction follow_incremental();
+    /// Checks that the food is reachable before searching move by move.
+    bool find_search_solution(const Position &, const Position &);
+    /// Returns the next step chosen by the tree search.
+    direction follow_search();
+    /// Returns, for each cell, the number of moves until the snake leaves it.
+    std::vector<size_t> vacate_times() const;
+    /// Rebuilds the path from the BFS parent directions.
+    void build_path(const Position &, const Position &, const std::vector<short> &);
+    /// Returns the linear index of a position in the level.
+    cell_t cell_of(const Position &pos) const { return to_cell(pos, m_level->cols()); }
+    /// Returns the position of a linear index in the level.
+    Position position_of(cell_t cell) const { return to_position(cell, m_level->cols()); }
+
+    const Level *m_level = nullptr; //!< The live maze grid, owned by the game.
+    player_e m_type = player_e::BACKTRACKING; //!< The search strategy used by the player.
+    std::deque<cell_t> m_paths;     //!< Stores the found cells.
     std::deque<dir_e> m_directions; //!< Stores the found directions.
+
+    std::vector<Position> m_waypoints; //!< Waypoints of the hierarchical path.
+    size_t m_next_waypoint = 0;        //!< Next waypoint to be refined into steps.
+    HierarchicalMap::Repairs m_repairs; //!< Cluster distances around the snake at its last search.
+
+    DistanceField m_field;          //!< Distances to the nearest food, when descending the gradient.
+    bool m_descending = false;      //!< Whether moves come from the field instead of the path.
+    IncrementalPlanner m_planner;   //!< Search state kept across moves and foods.
+    bool m_incremental = false;     //!< Whether moves come from the incremental planner.
+    JumpPointSearch m_jps;          //!< Jump Point Search, with its arrays kept across searches.
+    MonteCarloPlanner m_search;     //!< Tree search, with its threads kept across moves.
+    std::shared_ptr<ParallelBfs> m_parallel; //!< Layer-parallel BFS for large mazes, or nullptr.
+    bool m_searching = false;       //!< Whether moves come from the tree search.
+
+    Position m_head;                //!< Current head position while moving without a path.
+    Position m_tail;                //!< Tail position before the last move without a path.
+    bool m_moved = false;           //!< Whether the level changed since the planner last saw it.
+    dir_e m_last_dir = UP;          //!< Last direction taken while moving without a path.
+    DistanceField::dist_t m_head_dist = DistanceField::INF; //!< Field distance of the head.
 };
 
 } // NAMESPACE SNAZE
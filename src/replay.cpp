@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "replay.h"
+#include "binary_io.h"
+
+namespace snaze {
+
+namespace {
+
+constexpr char MAGIC[4] = { 'S', 'N', 'Z', 'R' };        //!< First bytes of a replay file.
+constexpr char INDEX_MAGIC[4] = { 'S', 'N', 'Z', 'I' };  //!< Last bytes of a replay file with an index.
+constexpr uint64_t VERSION = 2;                          //!< Version of the format.
+
+/// Kind of a token, in its two low bits.
+enum token_e : unsigned { MOVES = 0, FOOD, MARK, KEYFRAME };
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Appends the fields of a header to a buffer.
+ *
+ * @param header The header.
+ * @param out The buffer to append to.
+ */
+void Replay::save(const Header &header, std::string &out)
+{
+    for (uint64_t value : { header.seed, header.mazes, uint64_t(header.levels), uint64_t(header.foods),
+                            uint64_t(header.lives), uint64_t(header.board), uint64_t(header.player) })
+        binary::put_varint(out, value);
+}
+
+/**
+ * @brief Reads the fields of a header from a buffer.
+ *
+ * @param in The buffer.
+ * @param offset Where the header starts; moved past it.
+ * @param header Receives the fields.
+ * @return true if every field was read, false if the buffer is cut short.
+ */
+bool Replay::load(const std::string &in, size_t &offset, Header &header)
+{
+    uint64_t fields[7];
+    for (uint64_t &field : fields)
+        if (not binary::get_varint(in, offset, field))
+            return false;
+
+    header = { fields[0], fields[1], uint32_t(fields[2]), uint32_t(fields[3]),
+               uint32_t(fields[4]), uint32_t(fields[5]), uint32_t(fields[6]) };
+    return true;
+}
+
+/**
+ * @brief Creates a replay file and writes its header.
+ *
+ * @param path The path of the file, replaced if it exists.
+ * @param header The options of the run.
+ * @return true if the file was created, false otherwise.
+ */
+bool ReplayWriter::open(const std::string &path, const Replay::Header &header)
+{
+    m_out.open(path, std::ios::binary | std::ios::trunc);
+    if (not m_out.is_open())
+        return false;
+
+    std::string bytes(MAGIC, sizeof(MAGIC));
+    binary::put_varint(bytes, VERSION);
+    Replay::save(header, bytes);
+    m_out.write(bytes.data(), bytes.size());
+
+    return m_out.good();
+}
+
+/**
+ * @brief Records a move, extending the pending run if it goes the same way.
+ *
+ * @param dir The direction of the move.
+ */
+void ReplayWriter::move(dir_e dir)
+{
+    if (m_run > 0 and dir == m_run_dir) {
+        ++m_run;
+        return;
+    }
+
+    flush_run();
+    m_run_dir = dir;
+    m_run = 1;
+}
+
+/**
+ * @brief Records a food placed on the board.
+ *
+ * @param cell The cell of the food.
+ */
+void ReplayWriter::food(cell_t cell)
+{
+    flush_run();
+    token(cell, FOOD);
+}
+
+/**
+ * @brief Records an event the rules do not decide.
+ *
+ * @param mark The event.
+ */
+void ReplayWriter::mark(Replay::mark_e mark)
+{
+    flush_run();
+    token(mark, MARK);
+}
+
+/**
+ * @brief Records a snapshot of the game and adds it to the index.
+ *
+ * The file is flushed, so a run that crashes can still be replayed up to
+ * its last keyframe at least.
+ *
+ * @param moves The moves played before the snapshot.
+ * @param snapshot The state of the game, as the frontend saves it.
+ */
+void ReplayWriter::keyframe(uint64_t moves, const std::string &snapshot)
+{
+    flush_run();
+    m_index.push_back({ moves, static_cast<uint64_t>(m_out.tellp()) });
+    token(moves, KEYFRAME);
+    binary::write_varint(m_out, snapshot.size());
+    m_out.write(snapshot.data(), snapshot.size());
+    m_out.flush();
+}
+
+/**
+ * @brief Writes the index and closes the file.
+ *
+ * The index stores the gaps between the move counts and the offsets of
+ * consecutive keyframes, then the offset of the index itself.
+ */
+void ReplayWriter::close()
+{
+    if (not m_out.is_open())
+        return;
+
+    flush_run();
+    uint64_t index = m_out.tellp();
+    binary::write_varint(m_out, m_index.size());
+    Replay::Keyframe last { 0, 0 };
+    for (const auto &key : m_index) {
+        binary::write_varint(m_out, key.moves - last.moves);
+        binary::write_varint(m_out, key.offset - last.offset);
+        last = key;
+    }
+    binary::write_u64(m_out, index);
+    m_out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+    m_out.close();
+    m_index.clear();
+}
+
+/**
+ * @brief Writes the pending run of moves as one token.
+ */
+void ReplayWriter::flush_run()
+{
+    if (m_run == 0)
+        return;
+
+    token((m_run - 1) << 2 | m_run_dir, MOVES);
+    m_run = 0;
+}
+
+/**
+ * @brief Writes a token.
+ *
+ * @param value The payload of the token.
+ * @param kind The kind of the token.
+ */
+void ReplayWriter::token(uint64_t value, unsigned kind)
+{
+    binary::write_varint(m_out, value << 2 | kind);
+}
+
+/**
+ * @brief Reads a replay file and its index.
+ *
+ * Without an index, the stream is scanned once to rebuild it, and ends
+ * at the last token that is complete.
+ *
+ * @param path The path of the file.
+ * @return true if the file is a replay, false otherwise.
+ */
+bool ReplayReader::open(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (not in.is_open())
+        return false;
+    m_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    if (m_data.size() < sizeof(MAGIC) or std::memcmp(m_data.data(), MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+
+    size_t offset = sizeof(MAGIC);
+    uint64_t version;
+    if (not binary::get_varint(m_data, offset, version) or version != VERSION
+            or not Replay::load(m_data, offset, m_header))
+        return false;
+    const size_t start = offset;
+
+    m_index.clear();
+    const size_t footer = sizeof(INDEX_MAGIC) + 8;
+    bool indexed = m_data.size() >= start + footer
+                   and std::memcmp(m_data.data() + m_data.size() - sizeof(INDEX_MAGIC), INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+
+    if (indexed) {
+        m_end = binary::get_u64(m_data, m_data.size() - footer);
+        size_t at = m_end;
+        uint64_t count = 0, moves = 0, gap = 0;
+        Replay::Keyframe key { 0, 0 };
+        indexed = m_end >= start and binary::get_varint(m_data, at, count);
+        for (uint64_t i = 0; indexed and i < count; ++i) {
+            indexed = binary::get_varint(m_data, at, moves) and binary::get_varint(m_data, at, gap);
+            key = { key.moves + moves, key.offset + gap };
+            indexed = indexed and key.offset < m_end;
+            m_index.push_back(key);
+        }
+    }
+
+    if (not indexed) {
+        m_index.clear();
+        m_end = m_data.size();
+        m_offset = start;
+        m_run = 0;
+        for (size_t at = m_offset; decode(); at = m_offset) {
+            if (m_event.kind == Replay::Event::KEYFRAME)
+                m_index.push_back({ m_event.value, at });
+        }
+        m_end = m_offset;
+    }
+
+    m_offset = start;
+    m_run = 0;
+
+    return true;
+}
+
+/**
+ * @brief Decodes the next event.
+ *
+ * A run of moves is returned one move at a time.
+ *
+ * @return The event, of kind END once the stream is over.
+ */
+Replay::Event ReplayReader::next()
+{
+    if (m_run == 0 and not decode())
+        return Replay::Event();
+
+    --m_run;
+    return m_event;
+}
+
+/**
+ * @brief Returns the kind of the next event without consuming it.
+ *
+ * @return The kind of the event, END once the stream is over.
+ */
+Replay::Event::kind_e ReplayReader::peek()
+{
+    if (m_run == 0 and not decode())
+        return Replay::Event::END;
+
+    return m_event.kind;
+}
+
+/**
+ * @brief Moves to the last keyframe at or before a move.
+ *
+ * @param moves The move to reach.
+ * @return true if there is such a keyframe, false otherwise.
+ */
+bool ReplayReader::seek(uint64_t moves)
+{
+    const Replay::Keyframe *found = nullptr;
+    for (const auto &key : m_index)
+        if (key.moves <= moves)
+            found = &key;
+
+    if (found == nullptr)
+        return false;
+
+    m_offset = found->offset;
+    m_run = 0;
+    return true;
+}
+
+/**
+ * @brief Decodes the token at the read offset into the pending event.
+ *
+ * @return true if a whole token was decoded, false at the end of the stream.
+ */
+bool ReplayReader::decode()
+{
+    size_t at = m_offset;
+    uint64_t token;
+    if (at >= m_end or not binary::get_varint(m_data, at, token) or at > m_end)
+        return false;
+
+    Replay::Event event;
+    uint64_t value = token >> 2;
+    m_run = 1;
+
+    switch (token & 3) {
+    case MOVES:
+        event.kind = Replay::Event::MOVE;
+        event.dir = static_cast<dir_e>(value & 3);
+        m_run = (value >> 2) + 1;
+        break;
+    case FOOD:
+        event.kind = Replay::Event::FOOD;
+        event.value = value;
+        break;
+    case MARK:
+        event.kind = Replay::Event::MARK;
+        event.value = value;
+        break;
+    default: {
+        uint64_t length;
+        event.kind = Replay::Event::KEYFRAME;
+        event.value = value;
+        if (not binary::get_varint(m_data, at, length) or length > m_end - std::min<size_t>(at, m_end)) {
+            m_run = 0;
+            return false;
+        }
+        event.snapshot = m_data.substr(at, length);
+        at += length;
+    }
+    }
+
+    m_offset = at;
+    m_event = std::move(event);
+
+    return true;
+}
+
+} // NAMESPACE SNAZE
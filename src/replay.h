@@ -0,0 +1,148 @@
+/**
+ * @file replay.h
+ *
+ * @description
+ * Recording and playback of runs. A replay file holds what cannot be
+ * derived from the rules: the options and seed of the run, and the moves
+ * chosen by the player. The foods are recorded too, to detect a replay
+ * that drifted from the run.
+ *
+ * The file is a header, a stream of tokens and an index. Each token is a
+ * varint whose two low bits are its kind:
+ *
+ * - MOVES: a run of moves in the same direction, `(run - 1) << 2 | dir`.
+ * - FOOD: the cell of a food placed on the board.
+ * - MARK: a `mark_e`, the events the rules do not decide.
+ * - KEYFRAME: the move count, then the length and bytes of a snapshot of
+ *   the game, enough to start playing from there.
+ *
+ * The index at the end lists every keyframe with its move count and file
+ * offset, followed by the offset of the index and a magic number, so a
+ * player can seek to any move by starting from the keyframe before it.
+ * A file cut short, by a crash for instance, has no index; the reader then
+ * rebuilds it by scanning the stream, and plays up to the last full token.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+namespace snaze {
+
+class Replay {
+public:
+    //== Enums
+
+    /// Events of a run that the rules do not decide.
+    enum mark_e : uint8_t {
+        SOLVED = 0,     //!< The player found a path to the food.
+        UNSOLVED,       //!< The player found no path, and the snake walks on until it dies.
+    };
+
+    /// The options that decide a run.
+    struct Header {
+        uint64_t seed = 0;      //!< Seed of the first level.
+        uint64_t mazes = 0;     //!< Hash of the walls of every level, in order.
+        uint32_t levels = 0;    //!< The number of levels.
+        uint32_t foods = 0;     //!< Foods per level.
+        uint32_t lives = 0;     //!< Lives of the snake.
+        uint32_t board = 0;     //!< Foods on the board at once.
+        uint32_t player = 0;    //!< The player that chose the moves, for information.
+    };
+
+    /// One decoded token.
+    struct Event {
+        enum kind_e : uint8_t { MOVE = 0, FOOD, MARK, KEYFRAME, END } kind = END;
+        dir_e dir = UP;         //!< Direction of a move.
+        uint64_t value = 0;     //!< Cell of a food, mark, or move count of a keyframe.
+        std::string snapshot;   //!< Snapshot of a keyframe.
+    };
+
+    /// A keyframe of the index.
+    struct Keyframe {
+        uint64_t moves;         //!< Moves played before the keyframe.
+        uint64_t offset;        //!< File offset of its token.
+    };
+
+    /// Appends the fields of a header to a buffer, as varints.
+    static void save(const Header &, std::string &out);
+    /// Reads the fields of a header from a buffer at an offset; false if it is cut short.
+    static bool load(const std::string &in, size_t &offset, Header &);
+};
+
+class ReplayWriter {
+public:
+    /// Default constructor.
+    ReplayWriter() = default;
+    /// Writes the index and closes the file.
+    ~ReplayWriter() { close(); }
+
+    /// Creates a replay file and writes its header; false if it cannot be created.
+    bool open(const std::string &path, const Replay::Header &);
+    /// Returns whether a file is being written.
+    bool is_open() const { return m_out.is_open(); }
+
+    /// Records a move.
+    void move(dir_e);
+    /// Records a food placed on the board.
+    void food(cell_t);
+    /// Records an event the rules do not decide.
+    void mark(Replay::mark_e);
+    /// Records a snapshot of the game after a number of moves, and flushes the file.
+    void keyframe(uint64_t moves, const std::string &snapshot);
+    /// Writes the index and closes the file.
+    void close();
+
+private:
+    /// Writes the pending run of moves.
+    void flush_run();
+    /// Writes a token.
+    void token(uint64_t value, unsigned kind);
+
+    std::ofstream m_out;                    //!< The replay file.
+    std::vector<Replay::Keyframe> m_index;  //!< Keyframes written so far.
+    dir_e m_run_dir = UP;                   //!< Direction of the pending run.
+    uint64_t m_run = 0;                     //!< Moves in the pending run.
+};
+
+class ReplayReader {
+public:
+    /// Default constructor.
+    ReplayReader() = default;
+
+    /// Reads a replay file and its index; false if it is not a replay.
+    bool open(const std::string &path);
+    /// Returns the options of the run.
+    const Replay::Header &header() const { return m_header; }
+    /// Returns the keyframes, in order.
+    const std::vector<Replay::Keyframe> &index() const { return m_index; }
+
+    /// Decodes the next event; END once the stream is over.
+    Replay::Event next();
+    /// Returns the kind of the next event without consuming it.
+    Replay::Event::kind_e peek();
+    /// Moves to the last keyframe at or before a move; the next event is that keyframe.
+    bool seek(uint64_t moves);
+
+private:
+    /// Decodes the token at the read offset into the pending event.
+    bool decode();
+
+    std::string m_data;                     //!< The whole file.
+    size_t m_end = 0;                       //!< End of the token stream.
+    size_t m_offset = 0;                    //!< Offset of the next token.
+    Replay::Header m_header;                //!< Options of the run.
+    std::vector<Replay::Keyframe> m_index;  //!< Keyframes of the file.
+    Replay::Event m_event;                  //!< The decoded event not consumed yet.
+    uint64_t m_run = 0;                     //!< Moves left in the run of the pending event.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * @file rng.h
+ *
+ * @description
+ * This class is the random number generator of the simulation. It is a
+ * SplitMix64 generator: its whole state is a single 64-bit word, so game
+ * states can save and restore it as cheaply as any other counter, and a
+ * fixed seed always reproduces the same run.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace snaze {
+
+class Rng {
+public:
+    //== Aliases
+    using state_t = uint64_t;
+
+    /// Default constructor.
+    explicit Rng(state_t seed = 0) : m_state(seed) { /* empty */ }
+
+    /// Returns the next 64 random bits.
+    uint64_t next() {
+        uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    /// Returns a random number in [0, bound).
+    size_t below(size_t bound) { return next() % bound; }
+
+    /// Returns the current state, enough to replay every following number.
+    state_t state() const { return m_state; }
+    /// Restores a state returned by `state()`.
+    void state(state_t state) { m_state = state; }
+
+private:
+    state_t m_state; //!< Counter mixed into each output.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
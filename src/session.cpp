@@ -0,0 +1,177 @@
+#include <utility>
+
+#include "session.h"
+#include "common.h"
+
+namespace snaze {
+
+/**
+ * @brief Creates a session on a maze.
+ *
+ * @param layout The walls of the maze.
+ * @param lives The lives at the start of an episode.
+ * @param foods The foods that win an episode.
+ * @param board The foods on the board at once.
+ */
+Session::Session(std::shared_ptr<const Layout> layout, count_t lives, count_t foods, size_t board)
+    : m_layout(std::move(layout)), m_lives(lives), m_foods(foods), m_board(board)
+{
+    /* empty */
+}
+
+/**
+ * @brief Starts a new episode on a fresh level of the maze.
+ *
+ * @param seed The seed of the food positions.
+ */
+void Session::reset(Rng::state_t seed)
+{
+    Level level(m_layout);
+    level.seed(seed);
+    level.board(m_board);
+
+    reset(level, m_lives, 0);
+}
+
+/**
+ * @brief Starts a new episode on a copy of a level.
+ *
+ * The level keeps its maze, its generator, its spawn point and the foods
+ * it holds on the board; a game of several levels carries its lives and
+ * score from one to the next.
+ *
+ * @param level The level to play, with no snake placed yet.
+ * @param lives The lives at the start of the episode.
+ * @param score The score at the start of the episode.
+ */
+void Session::reset(const Level &level, count_t lives, count_t score)
+{
+    m_layout = level.layout();
+    m_level = level;
+    m_done = false;
+    m_won = false;
+
+    start(lives, score, 0);
+}
+
+/**
+ * @brief Plays on from a copy of a level, as saved in the middle of an episode.
+ *
+ * @param level The level, with the snake and the foods placed.
+ * @param lives The remaining lives.
+ * @param score The current score.
+ * @param foods The number of foods eaten so far.
+ */
+void Session::resume(const Level &level, count_t lives, count_t score, count_t foods)
+{
+    m_layout = level.layout();
+    m_level = level;
+    m_state = GameState(m_level, lives, score, foods);
+    m_done = false;
+    m_won = false;
+}
+
+/**
+ * @brief Moves the snake one cell in a direction.
+ *
+ * The state decides what the move does, and the level follows it: it
+ * moves the snake onto the cell first and eats what lies there next, then
+ * tops the board up with the same food the state drew. After a death with
+ * lives left, the level is reset and the snake starts over where it last
+ * ate. Once the episode ended, steps do nothing until `reset()`.
+ *
+ * @param dir The direction of the move.
+ * @return What the step did, its reward and whether the episode ended.
+ */
+Session::Transition Session::step(dir_e dir)
+{
+    Transition transition;
+    if (m_done) {
+        transition.done = true;
+        return transition;
+    }
+
+    const Position from = to_position(m_state.head(), m_state.cols());
+    transition.outcome = m_state.step(dir);
+    m_state.commit();
+
+    if (transition.outcome == GameState::outcome_e::DIED) {
+        transition.reward = -1;
+        m_done = m_state.lives() == 0;
+        m_death = m_level;
+
+        if (not m_done) {
+            m_level.reset();
+            transition.placed = start(m_state.lives(), m_state.score(), m_state.foods());
+        }
+    }
+    else {
+        const Position next = to_position(m_state.head(), m_state.cols());
+        m_level.update(from, dir, false);
+
+        if (transition.outcome == GameState::outcome_e::ATE) {
+            transition.reward = 1;
+            m_level.update(next, dir, true);
+            m_level.spawn(next);
+
+            size_t before = m_level.foods().size();
+            m_level.add_food();
+            transition.placed = m_level.foods().size() - before;
+
+            // Eating the last food, or leaving no cell for the next one, wins.
+            m_won = m_state.foods() == m_foods or m_state.food() == NO_CELL;
+            m_done = m_won;
+        }
+    }
+
+    transition.done = m_done;
+
+    return transition;
+}
+
+/**
+ * @brief Returns a view of the game.
+ *
+ * Nothing is copied: the cells are those of the running state, valid until
+ * the next call to `step()` or `reset()`.
+ *
+ * @return The board, the snake and the counters.
+ */
+Session::Observation Session::observe() const
+{
+    Observation observation;
+    observation.cells = m_state.cells();
+    observation.rows = m_state.rows();
+    observation.cols = m_state.cols();
+    observation.head = m_state.length() > 0 ? m_state.head() : NO_CELL;
+    observation.food = m_state.food();
+    observation.direction = m_state.direction();
+    observation.length = m_state.length();
+    observation.score = m_state.score();
+    observation.lives = m_state.lives();
+    observation.foods = m_state.foods();
+    observation.done = m_done;
+    observation.won = m_won;
+
+    return observation;
+}
+
+/**
+ * @brief Places the snake and the foods, and copies the level into the state.
+ *
+ * @param lives The remaining lives.
+ * @param score The current score.
+ * @param foods The number of foods eaten so far.
+ * @return The number of foods placed, the last ones of the level's foods.
+ */
+size_t Session::start(count_t lives, count_t score, count_t foods)
+{
+    size_t before = m_level.foods().size();
+    m_level.add_food();
+    m_level.place_snake(m_level.spawn());
+    m_state = GameState(m_level, lives, score, foods);
+
+    return m_level.foods().size() - before;
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,123 @@
+/**
+ * @file session.h
+ *
+ * @description
+ * This class holds the rules of the game, for the terminal frontend and
+ * for embedding the simulation in another program alike. The caller picks
+ * every move: `reset()` starts an episode, `step()` moves the snake once
+ * and `observe()` reads the board. Nothing is printed, read or waited for,
+ * so each call returns at once.
+ *
+ * The rules are those of `GameState`: the snake dies moving into anything
+ * but a free cell, a food or the tail cell it is leaving on the same move,
+ * and eating grows it by keeping its tail in place for one move. Each food
+ * eaten is worth 20 points and is replaced at once; a death costs a life
+ * and 20 points and puts the snake back, with a single cell, where it last
+ * ate; eating every food wins the episode. Foods are placed by the level's
+ * generator, so a seed always replays the same episode for the same moves.
+ *
+ * The state steps the game and every move is mirrored on a level, which
+ * the players plan on and the frontend draws; both place the same foods
+ * from the same generator.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <cstdint>
+#include <memory>
+
+#include "cell.h"
+#include "common.h"
+#include "game_state.h"
+#include "layout.h"
+#include "level.h"
+#include "observer.h"
+#include "rng.h"
+
+namespace snaze {
+
+class Session {
+public:
+    //== Aliases
+    using count_t = unsigned;
+
+    /// What a step did.
+    struct Transition {
+        GameState::outcome_e outcome = GameState::outcome_e::MOVED; //!< Whether the snake moved, ate or died.
+        float reward = 0;   //!< 1 for a food, -1 for a death, 0 otherwise.
+        bool done = false;  //!< Whether the episode ended; `reset()` starts the next one.
+        size_t placed = 0;  //!< Foods placed by the step, the last ones of `level().foods()`.
+    };
+
+    /// A read-only view of the game, valid until the next call that changes it.
+    struct Observation {
+        const Cell::cell_e *cells = nullptr;    //!< Type of each cell, row by row.
+        size_t rows = 0;                        //!< The number of rows in the maze.
+        size_t cols = 0;                        //!< The number of cols in the maze.
+        cell_t head = NO_CELL;                  //!< Cell of the snake head.
+        cell_t food = NO_CELL;                  //!< Cell of the newest food, or NO_CELL if the maze is full.
+        dir_e direction = UP;                   //!< Direction of the last move.
+        size_t length = 0;                      //!< Number of cells taken by the snake.
+        count_t score = 0;                      //!< Score in the episode.
+        count_t lives = 0;                      //!< Remaining lives.
+        count_t foods = 0;                      //!< Foods eaten in the episode.
+        bool done = false;                      //!< Whether the episode ended.
+        bool won = false;                       //!< Whether the episode ended by eating every food.
+    };
+
+    /// Default constructor.
+    Session() = default;
+    /// Creates a session on a maze; `reset()` starts the first episode.
+    Session(std::shared_ptr<const Layout>, count_t lives = 5, count_t foods = 10, size_t board = 1);
+    /// Destructor.
+    ~Session() = default;
+
+    /// Starts a new episode, placing the foods from a seed.
+    void reset(Rng::state_t seed);
+    /// Starts a new episode on a copy of a level, carrying the lives and the score over.
+    void reset(const Level &, count_t lives, count_t score = 0);
+    /// Plays on from a copy of a level with the snake and the foods placed, and the counters of its episode.
+    void resume(const Level &, count_t lives, count_t score, count_t foods);
+    /// Moves the snake one cell in a direction.
+    Transition step(dir_e);
+    /// Returns a view of the game.
+    Observation observe() const;
+    /// Writes the board into a buffer of `observer.size()` bytes.
+    void observe(const Observer &observer, uint8_t *out) const { observer.fill(m_state, out); }
+
+    /// Returns the walls of the maze.
+    const std::shared_ptr<const Layout> &layout() const { return m_layout; }
+    /// Returns the level every move is mirrored on; its address never changes.
+    const Level &level() const { return m_level; }
+    /// Returns the level as it was when the snake last died.
+    const Level &death() const { return m_death; }
+    /// Returns the remaining lives.
+    count_t lives() const { return m_state.lives(); }
+    /// Returns the score in the episode.
+    count_t score() const { return m_state.score(); }
+    /// Returns the foods eaten in the episode.
+    count_t foods() const { return m_state.foods(); }
+    /// Returns whether the episode ended.
+    bool done() const { return m_done; }
+    /// Returns whether the episode ended by eating every food.
+    bool won() const { return m_won; }
+
+private:
+    /// Places the snake at its spawn point and the foods, and copies the level into the state.
+    size_t start(count_t lives, count_t score, count_t foods);
+
+    std::shared_ptr<const Layout> m_layout; //!< Walls of the maze.
+    count_t m_lives = 5;                    //!< Lives at the start of an episode.
+    count_t m_foods = 10;                   //!< Foods that win an episode.
+    size_t m_board = 1;                     //!< Foods on the board at once.
+    Level m_level;                          //!< The running game, mirrored move by move.
+    Level m_death;                          //!< The level as it was when the snake last died.
+    GameState m_state;                      //!< The running game, as the rules step it.
+    bool m_done = true;                     //!< Whether the episode ended.
+    bool m_won = false;                     //!< Whether the episode ended by eating every food.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
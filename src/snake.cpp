@@ -9,10 +9,13 @@ namespace snaze {
  * Initializes the snake with a single position at the given starting position.
  * 
  * @param pos The initial position of the snake.
+ * @param cols The number of cols in the maze.
  */
-Snake::Snake(const Position& pos) 
+Snake::Snake(const Position& pos, size_t cols) 
+    : m_cols(cols)
 {
-    m_snake.push_back(pos);
+    m_snake.push_back(to_cell(pos, m_cols));
+    m_hash = zobrist::segment_key(m_snake.back(), zobrist::HEAD);
 }
 
 /**
@@ -25,7 +28,27 @@ Snake::Snake(const Position& pos)
  */
 void Snake::grow(const Position &pos) 
 {
-    m_snake.push_front(pos);
+    cell_t cell = to_cell(pos, m_cols);
+    m_hash ^= zobrist::segment_key(cell, zobrist::link(cell, m_snake.front(), m_cols));
+    m_snake.push_front(cell);
+}
+
+/**
+ * @brief Moves the head to a new position and keeps the tail in place.
+ * 
+ * The snake grows by one cell at once, which suits rules where eating
+ * takes effect on the same move. Only the link of the old head changes.
+ * 
+ * @param new_pos The new position of the head.
+ */
+void Snake::stretch(const Position &new_pos)
+{
+    cell_t old_head = m_snake.back();
+    cell_t new_head = to_cell(new_pos, m_cols);
+    m_hash ^= zobrist::segment_key(old_head, zobrist::HEAD)
+            ^ zobrist::segment_key(old_head, zobrist::link(old_head, new_head, m_cols))
+            ^ zobrist::segment_key(new_head, zobrist::HEAD);
+    m_snake.push_back(new_head);
 }
 
 /**
@@ -33,7 +56,8 @@ void Snake::grow(const Position &pos)
  * 
  * Moves the snake to a new position specified by `new_pos`, pushing this position
  * to the back of the snake's body and removing the front position, which represents
- * the snake's movement.
+ * the snake's movement. Only the links of the old head and the old tail
+ * change, so the hash is updated in O(1).
  * 
  * @param new_pos The new position to move the snake to.
  * @return The last tail position of the snake before moving.
@@ -41,16 +65,22 @@ void Snake::grow(const Position &pos)
 Position Snake::move(const Position &new_pos)
 {
     // Get the current position of the last tail (front of the deque).
-    Position last_tail = m_snake.front();
+    cell_t last_tail = m_snake.front();
 
     // Add the new snake's head position to the back of the snake's body.
-    m_snake.push_back(new_pos);
+    cell_t old_head = m_snake.back();
+    cell_t new_head = to_cell(new_pos, m_cols);
+    m_hash ^= zobrist::segment_key(old_head, zobrist::HEAD)
+            ^ zobrist::segment_key(old_head, zobrist::link(old_head, new_head, m_cols))
+            ^ zobrist::segment_key(new_head, zobrist::HEAD);
+    m_snake.push_back(new_head);
 
     // Remove the front position of the snake's body (last tail position).
+    m_hash ^= zobrist::segment_key(last_tail, zobrist::link(last_tail, m_snake[1], m_cols));
     m_snake.pop_front();
 
     // Return the last tail position before moving.
-    return last_tail;
+    return to_position(last_tail, m_cols);
 }
 
 }
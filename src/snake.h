@@ -12,6 +12,7 @@
 #include <queue>
 #include <vector>
 #include "common.h"
+#include "zobrist.h"
 
 namespace snaze {
 
@@ -20,7 +21,7 @@ public:
     /// Default constructor.
     Snake() = default;
     /// Default constructor.
-    Snake(const Position &pos);
+    Snake(const Position &pos, size_t cols);
     /// Destructor.
     ~Snake() = default;
 
@@ -28,18 +29,28 @@ public:
     void grow(const Position &pos);
     /// Move the snake position.
     Position move(const Position &pos);
+    /// Moves the head to a new position without releasing the tail.
+    void stretch(const Position &pos);
     /// Returns the length of the snake.
     size_t size() const { return m_snake.size(); }
     /// Returns the current direction of the snake.
     dir_e direction() const { return m_snake_direction; }
     /// sets the direction of the snake.
     void direction(dir_e dir) { m_snake_direction = dir; }
-    /// Returns the positions where the snake is inserted in the maze.
-    std::deque<Position> body() const { return m_snake; }
+    /// Returns the position of the snake's tail.
+    Position tail() const { return to_position(m_snake.front(), m_cols); }
+    /// Returns the position of the snake's head.
+    Position head() const { return to_position(m_snake.back(), m_cols); }
+    /// Returns the cells where the snake is inserted in the maze, from tail to head.
+    const std::deque<cell_t> &body() const { return m_snake; }
+    /// Returns the Zobrist hash of the body, which depends on the order of the segments.
+    zobrist::hash_t hash() const { return m_hash; }
 
 private:
-    std::deque<Position> m_snake; //!< Stores the positions where the snake parts are in the maze.
-    dir_e m_snake_direction;      //!< The snake direction.
+    std::deque<cell_t> m_snake;   //!< Stores the cells where the snake parts are in the maze.
+    size_t m_cols = 0;            //!< The number of cols in the maze, to convert cells.
+    dir_e m_snake_direction = UP; //!< The snake direction.
+    zobrist::hash_t m_hash = 0;   //!< Hash of each segment with its link to the next one.
 };
 
 }
@@ -1,14 +1,44 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <random>
 
 #include "snake_game.h"
+#include "binary_io.h"
 #include "cell.h"
 #include "common.h"
 #include "level.h"
+#include "metrics.h"
 #include "player.h"
+#include "trace.h"
 
 namespace snaze {
 
+namespace {
+
+constexpr uint64_t KEYFRAME_INTERVAL = 1024; //!< Moves between two keyframes of a recorded run.
+constexpr std::chrono::seconds CHECKPOINT_PERIOD { 5 }; //!< Time between two checkpoints of a run.
+
+/**
+ * @brief Reports on stderr, once, that a writer failed to write its file.
+ *
+ * @param writer The writer.
+ * @param what What the file holds.
+ * @param path The file.
+ * @param reported Whether the failure was already reported; set once it is.
+ */
+void report_failure(const CheckpointWriter &writer, const char *what, const string &path, bool &reported)
+{
+    if (reported or writer.good())
+        return;
+
+    std::cerr << "snaze: unable to write " << what << ": " << path << ".\n";
+    reported = true;
+}
+
+} // ANONYMOUS NAMESPACE
+
 /**
  * @brief Constructs a Snake game instance with given options.
  * 
@@ -21,9 +51,22 @@ namespace snaze {
 SnakeGame::SnakeGame(const RunningOpt& opt)
 {
     m_total_foods = opt.foods;       // Initialize total foods for the game.
+    m_board = opt.board;             // Initialize the foods on the board at once.
     m_fps = opt.fps;                 // Initialize frames per second.
     m_lives = opt.lives;             // Initialize number of lives.
     m_player_type = opt.player_type; // Initialize type of player intelligence.
+    m_heatmap = opt.heatmap;         // Initialize the distance field display flag.
+    m_seed = opt.seed;               // Initialize the seed of the food placement.
+    m_threads = opt.threads;         // Initialize the threads of the parallel players.
+    m_rollouts = opt.rollouts;       // Initialize the playouts per move of the MCTS player.
+    m_record_path = opt.record_path; // Initialize the file to record the run into.
+    m_replay_path = opt.replay_path; // Initialize the file of the run to replay.
+    m_seek = opt.seek;               // Initialize the move from which frames are drawn.
+    m_headless = opt.headless;       // Initialize the headless flag.
+    m_checkpoint_path = opt.checkpoint_path; // Initialize the file to save the run into.
+    m_resume = opt.resume;           // Initialize the resume flag.
+    m_metrics_path = opt.metrics_path; // Initialize the file to export the metrics into.
+    m_trace_path = opt.trace_path;   // Initialize the file to trace the game loop into.
 }
 
 /**
@@ -33,28 +76,163 @@ SnakeGame::SnakeGame(const RunningOpt& opt)
  * It creates instances of the Level and Player classes, initializes game state variables,
  * and sets up initial messages for the player.
  * 
+ * A replay runs with the seed and options it was recorded with, and only
+ * on the levels it was recorded on; seeking jumps to the keyframe before
+ * the move to seek, and plays on from there without drawing.
+ *
+ * A resumed run takes the options of its checkpoint the same way, and
+ * starts at the match the checkpoint was taken at.
+ *
  * @param maze The maze configuration represented as a vector of vectors of characters.
+ * @return false if the replay or the checkpoint cannot be read, or the record file created, true otherwise.
  */
-void SnakeGame::initialize(const list<vector<vector<char>>> &maze)
+bool SnakeGame::initialize(const list<vector<vector<char>>> &maze)
 {
-    // Store all levels.
+    if (not m_replay_path.empty() and not m_checkpoint_path.empty()) {
+        std::cerr << "snaze: a replay cannot be checkpointed nor resumed.\n";
+        return false;
+    }
+
+    Checkpoint resumed;
+    if (m_resume) {
+        if (not resumed.read(m_checkpoint_path)) {
+            std::cerr << "snaze: unable to read checkpoint: " << m_checkpoint_path << ".\n";
+            return false;
+        }
+
+        const Replay::Header &header = resumed.header;
+        m_seed = header.seed;
+        m_total_foods = header.foods;
+        m_lives = header.lives;
+        m_board = header.board;
+        m_player_type = header.player <= player_e::MCTS ? static_cast<player_e>(header.player) : player_e::BACKTRACKING;
+    }
+
+    if (not m_replay_path.empty()) {
+        if (not m_replay.open(m_replay_path)) {
+            std::cerr << "snaze: unable to read replay: " << m_replay_path << ".\n";
+            return false;
+        }
+
+        const Replay::Header &header = m_replay.header();
+        m_seed = header.seed;
+        m_total_foods = header.foods;
+        m_lives = header.lives;
+        m_board = header.board;
+        m_player_type = header.player <= player_e::MCTS ? static_cast<player_e>(header.player) : player_e::BACKTRACKING;
+        m_heatmap = false;
+        m_replaying = true;
+    }
+
+    // Without a seed from the user, every run is different.
+    if (m_seed == 0)
+        m_seed = std::random_device()();
+
+    // Store all levels, and hash their walls to tie a replay to them.
+    m_mazes = 0;
     for (const auto &m : maze) {
         Level level(m);
+        m_mazes = (m_mazes ^ level.layout()->hash()) * 0x100000001b3ULL;
+        level.seed(m_seed + m_levels.size());
+        level.board(m_board);
+
+        // The hierarchical planner needs its cluster graph precomputed from the walls.
+        if (m_player_type == player_e::HIERARCHICAL)
+            level.build_hierarchy();
+
         m_levels.push_back(level);
     }
 
-    m_level = Level(m_levels.front()); // Initialize the current level.
+    // Start the first level; the player reads the level the session steps.
+    m_session = Session(m_levels.front().layout(), m_lives, m_total_foods, m_board);
+    m_session.reset(m_levels.front(), m_lives);
+    m_player = Player(m_session.level(), m_player_type); // Initialize the AI engine.
+
+    // Large mazes are searched over several threads.
+    if (m_threads != 1)
+        m_player.parallelize(m_threads);
+
+    // The tree search may use the whole frame interval to choose each move.
+    if (m_player_type == player_e::MCTS)
+        m_player.configure_search(m_threads, m_rollouts, std::chrono::microseconds(1000000 / std::max(m_fps, 1u)), m_seed);
     m_game_state = state_e::STARTING;
 
-    m_curr_foods = 0;                // Initialize current number of foods eaten.
-    m_curr_lives = m_lives;          // Initialize current number of lives remaining.
-    m_score = 0;                     // Initialize game score.
     m_n_levels = m_levels.size();    // Initialize the number of levels.
-    m_curr_foods = 0;                // Initialize the current number of foods.
     m_end_game = false;              // Initialize the end game flag.
 
+    if (m_replaying and (m_replay.header().levels != m_n_levels or m_replay.header().mazes != m_mazes)) {
+        std::cerr << "snaze: the replay was recorded on other levels.\n";
+        return false;
+    }
+
+    if (m_resume and (resumed.header.levels != m_n_levels or resumed.header.mazes != m_mazes)) {
+        std::cerr << "snaze: the checkpoint was taken on other levels.\n";
+        return false;
+    }
+
+    if (not m_record_path.empty()) {
+        if (not m_recorder.open(m_record_path, run_header())) {
+            std::cerr << "snaze: unable to create replay: " << m_record_path << ".\n";
+            return false;
+        }
+    }
+
     m_levels.pop_front();
     m_system_msg = "Press <ENTER> to start the game!";
+
+    // A run recorded after a resume starts at its first keyframe.
+    uint64_t start = m_seek;
+    if (m_replaying and not m_replay.index().empty())
+        start = std::max(start, m_replay.index().front().moves);
+
+    bool jumped = false;
+    if (m_replaying and start > 0 and m_replay.seek(start)) {
+        Replay::Event key = m_replay.next();
+        if (not restore(key.snapshot)) {
+            std::cerr << "snaze: the replay has a broken keyframe.\n";
+            return false;
+        }
+
+        m_moves = key.value;
+        m_game_state = state_e::RUNNING;
+        m_match_state = match_e::STARTING;
+        jumped = true;
+    }
+
+    if (m_resume) {
+        if (not restore(resumed.game)) {
+            std::cerr << "snaze: the checkpoint is broken.\n";
+            return false;
+        }
+
+        m_moves = resumed.moves;
+        if (m_player.search() != nullptr)
+            m_player.search()->searches(resumed.searches);
+        m_game_state = state_e::RUNNING;
+        m_match_state = match_e::STARTING;
+        jumped = true;
+    }
+
+    // The foods of the first level come first in a replay, unless it starts at a keyframe.
+    if (not jumped)
+        placed_foods(0);
+
+    if (not m_checkpoint_path.empty())
+        m_checkpoints.open(m_checkpoint_path);
+
+    if (not m_metrics_path.empty()) {
+        if (metrics::ENABLED)
+            m_metrics.open(m_metrics_path);
+        else
+            std::cerr << "snaze: built without SNAZE_METRICS, no metrics are written.\n";
+    }
+
+    if (not m_trace_path.empty() and not trace::start(m_trace_path)) {
+        std::cerr << "snaze: unable to create trace: " << m_trace_path << ".\n";
+        return false;
+    }
+
+    return true;
 }
 
 /**
@@ -65,6 +243,12 @@ void SnakeGame::initialize(const list<vector<vector<char>>> &maze)
  */
 void SnakeGame::process_events()
 {
+    trace::Span span("process_events", trace_tags());
+
+    // Nobody watches a headless run, nor the moves a seek skips.
+    if (not drawing())
+        return;
+
     if (m_game_state == state_e::WELLCOME) {
         read_enter();
     }
@@ -83,6 +267,9 @@ void SnakeGame::process_events()
  */
 void SnakeGame::update() 
 {
+    m_frames.tick();
+    trace::Span span("update", trace_tags());
+
     if (m_game_state == state_e::STARTING) {
         m_game_state = state_e::WELLCOME;
     }
@@ -92,118 +279,58 @@ void SnakeGame::update()
     }
     else if (m_game_state == state_e::RUNNING) {
         if (m_match_state == match_e::STARTING) {
-            // Add food to the maze.
-            m_level.add_food();
-
-            // Place the snake at its spawn position.
-            m_level.place_snake(m_level.spawn());
+            // Snapshot the game every so often, so a replay or a resumed run can start from here.
+            keyframe();
+            checkpoint();
+            export_metrics();
+            m_match_start = m_moves;
+
+            // The snake stands where it spawned or last ate; the player picks the food to head for.
+            const Level &level = m_session.level();
+            bool has_solution;
+            if (m_replaying) {
+                // The replay tells whether the player found a path.
+                Replay::Event mark = m_replay.next();
+                if (mark.kind != Replay::Event::MARK or mark.value > Replay::UNSOLVED)
+                    desync("the start of a match");
+                has_solution = mark.value == Replay::SOLVED;
+            }
+            else {
+                // Take the plan made while the snake walked, if it predicted this board.
+                if (not m_speculative.take(level, m_player, has_solution)) {
+                    // Point the player at the current level configuration.
+                    m_player.reset(level);
+
+                    // Determine if there's a solution path from the snake's spawn to the food.
+                    trace::Span search("search", trace_tags());
+                    has_solution = m_player.find_solution(level.spawn(), level.food());
+                }
 
-            // Initialize the player with the current level configuration.
-            m_player = Player(m_level);
+                // Plan the next match in the background while the snake walks this one.
+                if (has_solution and m_session.foods() + 1 < m_total_foods)
+                    m_speculative.start(m_session, m_player, { m_level_index, m_session.foods() + 1, 0 });
 
-            // Determine if there's a solution path from the snake's spawn to the food.
-            bool has_solution = m_player.find_solution(m_level.spawn(), m_level.food());
+                if (m_recorder.is_open())
+                    m_recorder.mark(has_solution ? Replay::SOLVED : Replay::UNSOLVED);
+            }
 
             // Update the match state based on whether a solution was found.
             m_match_state = has_solution ? match_e::LOOKING_FOR_FOOD
                                          : match_e::WALK_TO_DEATH;
         }
-        else if (m_match_state == match_e::LOOKING_FOR_FOOD) {
-            // Get the next move from the player.
-            auto [step, direction] = m_player.next_move();
-
-            // Check if the step taken by the snake is the position of the food.
-            bool found_food = step == m_level.food();
-
-            // Update the level based on the snake's movement and whether food was found.
-            m_level.update(step, direction, found_food);
-
-            if (found_food) {
-                bool death = true; //!< Flag that indicates whether the snake was surrounded after eating the food.
-                for (const dir_e dir : { UP, LEFT, DOWN, RIGHT }) {
-                    // If there is a clear path, the snake is not surrounded.
-                    if (not m_level.is_blocked(step, dir)) {
-                        death = false;
-                        break;
-                    }
-                }
-
-                // Spawn new food, update game state and scores.
-                m_level.spawn(step);
-                m_curr_foods++;
-                m_score += 20;
-
-                // Check if the snake dies. (surrounded by walls or itself)
-                if (death) {
-                    m_curr_lives -= 1;
-                    if (m_curr_lives == 0)
-                        m_match_state = match_e::LOST;
-                    else 
-                        // Reset the game state if lives remain.
-                        m_match_state = match_e::RESET;
-                }
-                else {
-                    // Restart the game to continue playing.
-                    m_match_state = match_e::STARTING;
-                }
-
-                // Check if all food has been eaten to win the game.
-                if (m_curr_foods == m_total_foods) {
-                    if (m_levels.empty()) {
-                        m_match_state = match_e::WIN;
-                        m_system_msg = "Press <ENTER> to continue...";
-                    }
-                    else {
-                        m_match_state = match_e::NEXT_LEVEL;
-                        m_system_msg = "Press <ENTER> to start next level!";
-
-                    }
-                }
-            }
-        }
-        else if (m_match_state == match_e::WALK_TO_DEATH) {
-            // Get the next move from the player.
-            auto [step, direction] = m_player.next_move();
-
-            // Update the level if the snake's next move is not blocked.
-            if (not m_level.is_blocked(step, direction)) {
-                m_level.update(step, direction, false);
-            }
-
-            // Spawn a new food at the snake's last position.
-            m_level.spawn(m_player.last_move());
-
-            // Check if the snake has no more steps left.
-            if (m_player.amount_of_steps() == 0) {
-                // Decrease the score by 20 points, ensure it does not go below zero.
-                m_score = (m_score - 20 < 0) ? 0 : m_score - 20;
-
-                // Decrease the current number of lives by 1.
-                m_curr_lives -= 1;
-
-                // Check if there are no lives left.
-                if (m_curr_lives == 0) {
-                    m_match_state = match_e::LOST;
-                    m_system_msg = "Press <ENTER> to continue...";
-                    return;
-                }
-                else {
-                    // Display system message to prompt player to try again.
-                    m_system_msg = "Press <ENTER> to try again.";
-                }
-
-                // Reset the game state.
-                m_match_state = match_e::RESET;
-            }
+        else if (m_match_state == match_e::LOOKING_FOR_FOOD or m_match_state == match_e::WALK_TO_DEATH) {
+            // The session decides what the move does; the snake walking to its death moves on until it dies.
+            play_move();
         }
         else if (m_match_state == match_e::NEXT_LEVEL) {
-            m_level = m_levels.front();
+            m_session.reset(m_levels.front(), m_session.lives(), m_session.score());
             m_levels.pop_front();
-            m_curr_foods = 0;
+            m_level_index++;
+            placed_foods(0);
             m_match_state = match_e::STARTING;
         }
         else if (m_match_state == match_e::RESET) {
-            m_level.reset();
+            // The session already put the snake back.
             m_match_state = match_e::STARTING;
         }
         else if (m_match_state == match_e::LOST or m_match_state == match_e::WIN) {
@@ -211,6 +338,22 @@ void SnakeGame::update()
         }
     }
     else if (m_game_state == state_e::ENDING) {
+        m_recorder.close();
+
+        // A finished run has nothing left to resume.
+        if (m_checkpoints.is_open()) {
+            m_checkpoints.close();
+            report_failure(m_checkpoints, "checkpoint", m_checkpoint_path, m_checkpoint_failed);
+            std::remove(m_checkpoint_path.c_str());
+        }
+
+        // The last export holds the whole run.
+        if (m_metrics.is_open()) {
+            m_metrics.write(metrics::format_for(m_metrics_path));
+            m_metrics.close();
+            report_failure(m_metrics, "metrics", m_metrics_path, m_metrics_failed);
+        }
+        trace::stop();
         m_end_game = true;
     }
 }
@@ -222,28 +365,37 @@ void SnakeGame::update()
  */
 void SnakeGame::render()
 {
+    // Headless runs and seeks only show how the game ended.
+    if (not drawing() and m_game_state != state_e::ENDING)
+        return;
+
+    metrics::Timer timer(metrics::RENDER_NS);
+    trace::Span span("render", trace_tags());
+
     if (m_game_state == state_e::WELLCOME) {
         display_welcome();
         display_game_info();
         display_system_messages();
         display_match_info();
-        cout << m_level.to_string();
+        cout << m_session.level().to_string();
     }
     else if (m_game_state == state_e::RUNNING) {
         draw_horizontal_line();
         display_match_info();
         if (m_match_state == match_e::STARTING) {
-            cout << m_level.to_string();
+            cout << m_session.level().to_string();
         }
         else if (m_match_state == match_e::LOOKING_FOR_FOOD) {
-            cout << m_level.to_string();
+            cout << m_session.level().to_string();
+            if (m_heatmap)
+                display_heatmap();
         }
         else if (m_match_state == match_e::WALK_TO_DEATH) {
-            cout << m_level.to_string();
+            cout << m_session.level().to_string();
         }
         else if (m_match_state == match_e::NEXT_LEVEL) {
             display_system_messages();
-            cout << m_level.to_string();
+            cout << m_session.level().to_string();
         }
         else if (m_match_state == match_e::RESET) {
             display_death_snake();
@@ -332,12 +484,17 @@ void SnakeGame::display_system_messages() const
  */
 void SnakeGame::display_match_info()
 {
-    display_life(m_curr_lives);
+    display_life(m_session.lives());
 
     std::cout << " | "
-              << "Score: " << m_score << " | "
-              << "Food eaten: " << m_curr_foods << " of " << m_total_foods 
-              << std::endl;
+              << "Score: " << m_session.score() << " | "
+              << "Food eaten: " << m_session.foods() << " of " << m_total_foods;
+
+    // Report the search speed, to size the hardware for the MCTS player.
+    if (m_player.search() != nullptr)
+        std::cout << " | Rollouts/s: " << static_cast<uint64_t>(m_player.search()->rate());
+
+    std::cout << std::endl;
 
     draw_horizontal_line();
 }
@@ -368,22 +525,23 @@ void SnakeGame::display_life(count_t curr_lives) {
 /**
  * @brief Displays a message indicating the game has been won.
  * 
- * This function displays a visual representation of the game board from the `m_level`
- * object with the snake head replaced by its directional character ('v', '^', '<', '>') from
+ * This function displays a visual representation of the game board from the level
+ * of the session with the snake head replaced by its directional character ('v', '^', '<', '>') from
  * the ASCII representation of the maze. It then prints a congratulatory message indicating
  * that the game has been won.
  */
 void SnakeGame::display_won_message() const
 {
-    auto maze = m_level.maze();
-    std::string maze_ascii = m_level.to_string();
+    const Level &level = m_session.level();
+    auto maze = level.maze();
+    std::string maze_ascii = level.to_string();
 
     const char* head = "v^><";
     size_t idx = maze_ascii.find_first_of(head);
 
     // Display top portion of the board with snake head directional characters.
-    for (size_t i = 0; i < (m_level.rows() / 2) - 2; i++) {
-        for (size_t j = 0; j < m_level.cols(); j++) {
+    for (size_t i = 0; i < (level.rows() / 2) - 2; i++) {
+        for (size_t j = 0; j < level.cols(); j++) {
             Cell cell = maze[i][j];
             if (cell.type() == Cell::cell_e::SNAKE_HEAD)
                 std::cout << maze_ascii[idx];
@@ -401,8 +559,8 @@ void SnakeGame::display_won_message() const
     std::cout << "+--------------------------------------------+\n";
 
     // Display bottom portion of the board with snake head directional characters.
-    for (size_t i = (m_level.rows() / 2) + 2; i < m_level.rows(); i++) {
-        for (size_t j = 0; j < m_level.cols(); j++) {
+    for (size_t i = (level.rows() / 2) + 2; i < level.rows(); i++) {
+        for (size_t j = 0; j < level.cols(); j++) {
             Cell cell = maze[i][j];
             if (cell.type() == Cell::cell_e::SNAKE_HEAD)
                 std::cout << maze_ascii[idx];
@@ -417,17 +575,18 @@ void SnakeGame::display_won_message() const
 /**
  * @brief Displays a message indicating the game has been lost.
  * 
- * This function displays a visual representation of the game board from the `m_level`
- * object with death snake visuals, and then prints a message indicating that the game
+ * This function displays a visual representation of the game board as it was when
+ * the snake last died, with death snake visuals, and then prints a message indicating that the game
  * has been lost, encouraging the player to try again next time.
  */
 void SnakeGame::display_lost_message() const
 {
-    auto maze = m_level.maze();
+    const Level &level = m_session.death();
+    auto maze = level.maze();
 
     // Display top portion of the board with death snake visuals.
-    for (size_t i = 0; i < (m_level.rows() / 2) - 2; i++) {
-        for (size_t j = 0; j < m_level.cols(); j++) {
+    for (size_t i = 0; i < (level.rows() / 2) - 2; i++) {
+        for (size_t j = 0; j < level.cols(); j++) {
             Cell cell = maze[i][j];
 
             if (cell.type() == Cell::cell_e::SNAKE_HEAD) {
@@ -451,8 +610,8 @@ void SnakeGame::display_lost_message() const
     std::cout << "+--------------------------------------------+\n";
 
     // Display bottom portion of the board with death snake visuals.
-    for (size_t i = (m_level.rows() / 2) + 2; i < m_level.rows(); i++) {
-        for (size_t j = 0; j < m_level.cols(); j++) {
+    for (size_t i = (level.rows() / 2) + 2; i < level.rows(); i++) {
+        for (size_t j = 0; j < level.cols(); j++) {
             Cell cell = maze[i][j];
 
             if (cell.type() == Cell::cell_e::SNAKE_HEAD) {
@@ -473,16 +632,17 @@ void SnakeGame::display_lost_message() const
 /**
  * @brief Displays the current state of the game board with death snake visuals.
  * 
- * This function retrieves the maze state from the `m_level` object and displays it,
+ * This function retrieves the maze state at the last death of the snake and displays it,
  * replacing snake head and body cells with their respective death visuals if present.
  */
 void SnakeGame::display_death_snake() const 
 {
-    auto maze = m_level.maze();
+    const Level &level = m_session.death();
+    auto maze = level.maze();
     
     // Iterate through each cell in the maze.
-    for (size_t i = 0; i < m_level.rows(); i++) {
-        for (size_t j = 0; j < m_level.cols(); j++) {
+    for (size_t i = 0; i < level.rows(); i++) {
+        for (size_t j = 0; j < level.cols(); j++) {
             Cell cell = maze[i][j];
 
             // Replace snake head with death snake head visual.
@@ -504,6 +664,43 @@ void SnakeGame::display_death_snake() const
     }
 }
 
+/**
+ * @brief Displays the distance field the player is descending.
+ * 
+ * Every free cell that reaches the food shows the last digit of its distance
+ * to it, so the gradient followed by the snake can be inspected. Nothing is
+ * shown while the player follows a stored path.
+ */
+void SnakeGame::display_heatmap() const
+{
+    const DistanceField *field = m_player.field();
+    if (field == nullptr)
+        return;
+
+    draw_horizontal_line();
+
+    const Level &level = m_session.level();
+
+    for (size_t i = 0; i < level.rows(); i++) {
+        for (size_t j = 0; j < level.cols(); j++) {
+            Position pos(i, j);
+            Cell::cell_e type = level.cell(pos);
+
+            if (type == Cell::cell_e::SNAKE_HEAD) {
+                std::cout << "@";
+            }
+            else if (type == Cell::cell_e::FREE and field->at(pos) != DistanceField::INF) {
+                std::cout << field->at(pos) % 10;
+            }
+            else {
+                std::cout << Level::render[type];
+            }
+        }
+
+        std::cout << std::endl;
+    }
+}
+
 /**
  * @brief Reads and discards input characters until a newline character is encountered.
  * 
@@ -519,6 +716,252 @@ void SnakeGame::read_enter() const
         enter = getchar();
 }
 
+/**
+ * @brief Takes the next move from the player, or from the replay.
+ *
+ * Only the direction is kept; the session knows where the head is.
+ *
+ * @return The direction of the move.
+ */
+dir_e SnakeGame::next_move()
+{
+    m_moves++;
+    metrics::add(metrics::MOVES);
+
+    if (m_replaying) {
+        Replay::Event move = m_replay.next();
+        if (move.kind != Replay::Event::MOVE)
+            desync("a move");
+
+        return move.dir;
+    }
+
+    dir_e dir = m_player.next_move().second;
+    if (m_recorder.is_open())
+        m_recorder.move(dir);
+
+    return dir;
+}
+
+/**
+ * @brief Plays the next move through the session and follows what it did.
+ *
+ * Eating starts the next match, or the next level once every food of this
+ * one is eaten. A death on the first move of a match is the snake boxed in
+ * where it ate; any other one ends a walk that found no food. Either way
+ * the session already put the snake back if it has lives left.
+ */
+void SnakeGame::play_move()
+{
+    auto transition = m_session.step(next_move());
+    placed_foods(m_session.level().foods().size() - transition.placed);
+
+    if (transition.outcome == GameState::outcome_e::ATE) {
+        metrics::add(metrics::FOODS);
+
+        if (not m_session.won()) {
+            m_match_state = match_e::STARTING;
+        }
+        else if (m_levels.empty()) {
+            m_match_state = match_e::WIN;
+            m_system_msg = "Press <ENTER> to continue...";
+        }
+        else {
+            m_match_state = match_e::NEXT_LEVEL;
+            m_system_msg = "Press <ENTER> to start next level!";
+        }
+    }
+    else if (transition.outcome == GameState::outcome_e::DIED) {
+        metrics::add(m_moves - m_match_start == 1 ? metrics::DEATHS_TRAPPED : metrics::DEATHS_NO_PATH);
+
+        if (m_session.done()) {
+            m_match_state = match_e::LOST;
+            m_system_msg = "Press <ENTER> to continue...";
+        }
+        else {
+            m_match_state = match_e::RESET;
+            m_system_msg = "Press <ENTER> to try again.";
+        }
+    }
+}
+
+/**
+ * @brief Records the foods placed on the board, or checks them against the replay.
+ *
+ * The foods follow from the seed, so a replay places them by itself;
+ * comparing them with the recorded ones catches a replay that drifted.
+ *
+ * @param before The number of foods on the board before it was topped up.
+ */
+void SnakeGame::placed_foods(size_t before)
+{
+    const auto &foods = m_session.level().foods();
+
+    for (size_t i = before; i < foods.size(); ++i) {
+        cell_t cell = to_cell(foods[i], m_session.level().cols());
+
+        if (m_replaying) {
+            Replay::Event food = m_replay.next();
+            if (food.kind != Replay::Event::FOOD or food.value != cell)
+                desync("a food at " + foods[i].to_str());
+        }
+        else if (m_recorder.is_open()) {
+            m_recorder.food(cell);
+        }
+    }
+}
+
+/**
+ * @brief Records a keyframe at the start of a match, or checks the replay's one.
+ *
+ * A keyframe is recorded at the first match and then at the first match
+ * that starts `KEYFRAME_INTERVAL` moves after the previous one.
+ */
+void SnakeGame::keyframe()
+{
+    if (m_replaying) {
+        if (m_replay.peek() == Replay::Event::KEYFRAME and m_replay.next().snapshot != snapshot())
+            desync("the state of a keyframe");
+    }
+    else if (m_recorder.is_open() and m_moves >= m_next_keyframe) {
+        m_recorder.keyframe(m_moves, snapshot());
+        m_next_keyframe = m_moves + KEYFRAME_INTERVAL;
+    }
+}
+
+/**
+ * @brief Saves the state of the run, if the last checkpoint is old enough.
+ *
+ * The first match of a run is always saved. Only the snapshot is taken
+ * here; the file is written by the checkpoint writer's own thread, whose
+ * failures are reported at the next checkpoint.
+ */
+void SnakeGame::checkpoint()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (not m_checkpoints.is_open() or now - m_last_checkpoint < CHECKPOINT_PERIOD)
+        return;
+
+    report_failure(m_checkpoints, "checkpoint", m_checkpoint_path, m_checkpoint_failed);
+
+    Checkpoint state;
+    state.header = run_header();
+    state.moves = m_moves;
+    state.searches = m_player.search() != nullptr ? m_player.search()->searches() : 0;
+    state.game = snapshot();
+    m_checkpoints.write(state.encode());
+    m_last_checkpoint = now;
+}
+
+/**
+ * @brief Exports the metrics, if the last export is old enough.
+ *
+ * Exports follow the period of the checkpoints, the first match of a run
+ * always exporting. The text is written by the writer's own thread,
+ * whose failures are reported at the next export.
+ */
+void SnakeGame::export_metrics()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (not m_metrics.is_open() or now - m_last_metrics < CHECKPOINT_PERIOD)
+        return;
+
+    report_failure(m_metrics, "metrics", m_metrics_path, m_metrics_failed);
+
+    m_metrics.write(metrics::format_for(m_metrics_path));
+    m_last_metrics = now;
+}
+
+/**
+ * @brief Returns what the spans of the game loop are tagged with.
+ *
+ * @return The level index, the index of the food being looked for and the snake's length.
+ */
+trace::Tags SnakeGame::trace_tags() const
+{
+    return { m_level_index, m_session.foods(), static_cast<uint32_t>(m_session.level().snake().size()) };
+}
+
+/**
+ * @brief Returns the options that decide the run.
+ *
+ * @return The header of the replays and checkpoints of the run.
+ */
+Replay::Header SnakeGame::run_header() const
+{
+    return { m_seed, m_mazes, m_n_levels, m_total_foods, m_lives, m_board, static_cast<uint32_t>(m_player_type) };
+}
+
+/**
+ * @brief Returns the state needed to play on from the start of a match.
+ *
+ * Holds the index of the level, the score, the foods eaten and the lives
+ * left as varints, followed by the state of the level.
+ *
+ * @return The state, as bytes.
+ */
+string SnakeGame::snapshot() const
+{
+    string out;
+    for (uint64_t value : { m_level_index, m_session.score(), m_session.foods(), m_session.lives() })
+        binary::put_varint(out, value);
+    m_session.level().save(out);
+
+    return out;
+}
+
+/**
+ * @brief Restores a state returned by `snapshot()`.
+ *
+ * Only works forward from the start, as the levels before the one of the
+ * state are dropped.
+ *
+ * @param in The state.
+ * @return true if it was restored, false if it does not fit the levels left.
+ */
+bool SnakeGame::restore(const string &in)
+{
+    size_t offset = 0;
+    uint64_t index, score, foods, lives;
+    if (not binary::get_varint(in, offset, index) or not binary::get_varint(in, offset, score)
+            or not binary::get_varint(in, offset, foods) or not binary::get_varint(in, offset, lives))
+        return false;
+    if (index < m_level_index or index - m_level_index > m_levels.size())
+        return false;
+
+    Level level = m_session.level();
+    for (; m_level_index < index; m_level_index++) {
+        level = m_levels.front();
+        m_levels.pop_front();
+    }
+
+    if (not level.load(in, offset))
+        return false;
+
+    m_session.resume(level, lives, score, foods);
+
+    return true;
+}
+
+/**
+ * @brief Stops a replay that no longer matches the run it recorded.
+ *
+ * @param what What the replay expected.
+ */
+void SnakeGame::desync(const string &what)
+{
+    // Only the first mismatch is reported; the rest of the frame follows from it.
+    if (m_end_game)
+        return;
+
+    if (m_replay.peek() == Replay::Event::END)
+        std::cerr << "snaze: the replay stops at move " << m_moves << ", before the end of the run.\n";
+    else
+        std::cerr << "snaze: the replay does not match this run: expected " << what
+                  << " at move " << m_moves << ".\n";
+    m_end_game = true;
+}
+
 /**
  * @brief Draws a horizontal line of '-' characters on the console.
  * 
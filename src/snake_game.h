@@ -2,25 +2,32 @@
  * @file snake_game.h
  *
  * @description
- * This class defines game execution rules during the simulation. 
- * It's responsible for receiving requests and providing responses 
- * according to data input.
- * This class is also responsible for displaying the game states 
- * during the simulation.
+ * This class is the terminal frontend of the simulation. It takes the
+ * moves from the player, or from a replay, and feeds them to a session,
+ * which holds the rules of the game; only the levels to play, the input,
+ * the drawing and the files of the run are handled here.
  */
 
 #ifndef SNAKE_GAME_H
 #define SNAKE_GAME_H
 
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <list>
 #include <queue>
 
+#include "checkpoint.h"
 #include "common.h"
 #include "level.h"
+#include "metrics.h"
 #include "player.h"
+#include "replay.h"
+#include "session.h"
+#include "speculative.h"
+#include "trace.h"
+#include "rng.h"
 
 using std::string;
 using std::vector;
@@ -63,10 +70,15 @@ public:
     SnakeGame(const RunningOpt &);
     /// Destructor.
     ~SnakeGame() = default;
+    // The player points at the level of `m_session`, so a copy would plan on the level of the original.
+    SnakeGame(const SnakeGame &) = delete;
+    SnakeGame &operator=(const SnakeGame &) = delete;
+    SnakeGame(SnakeGame &&) = delete;
+    SnakeGame &operator=(SnakeGame &&) = delete;
 
     //=== Common methods for the Game Loop design pattern.
-    /// Defines simulation settings.
-    void initialize(const list<vector<vector<char>>>&);
+    /// Defines simulation settings; false if the replay or record file cannot be used.
+    bool initialize(const list<vector<vector<char>>>&);
     /// Process user input events, depending on the current game state.
     void process_events();
     /// Update the game based on the current game state.
@@ -78,6 +90,10 @@ public:
 
     /// Returns the fps game.
     count_t fps() const { return m_fps; }
+    /// Returns whether frames are drawn and paced, which headless runs and seeks skip.
+    bool drawing() const { return not m_headless and m_moves >= m_seek; }
+    /// Returns what the spans of the game loop are tagged with.
+    trace::Tags trace_tags() const;
 
 private:
     /// Show the welcome mesage.
@@ -94,6 +110,8 @@ private:
     void display_lost_message() const;
     /// Show the maze with the death snake.
     void display_death_snake() const;
+    /// Show the distance field the player is descending.
+    void display_heatmap() const;
     /// Shows the snake's number of lives.
     void display_life(count_t);
 
@@ -103,24 +121,75 @@ private:
     /// Reads a simple enter from the user.
     void read_enter() const;
 
+    /// Takes the next move from the player or the replay, recording it.
+    dir_e next_move();
+    /// Plays the next move through the session and follows what it did.
+    void play_move();
+    /// Records or checks the foods placed on the board since it held a number of them.
+    void placed_foods(size_t before);
+    /// Records or checks a keyframe at the start of a match.
+    void keyframe();
+    /// Saves the state of the run every so often, at the start of a match.
+    void checkpoint();
+    /// Exports the metrics every so often, at the start of a match.
+    void export_metrics();
+    /// Returns the options that decide the run, as replays and checkpoints store them.
+    Replay::Header run_header() const;
+    /// Returns the state needed to play on from the start of a match.
+    string snapshot() const;
+    /// Restores a state returned by `snapshot()`; false if it does not fit the levels.
+    bool restore(const string &);
+    /// Stops a replay that no longer matches the run it recorded.
+    void desync(const string &what);
+
     state_e m_game_state;   //!< The current game state.
     match_e m_match_state;  //!< The current match state.
     list<Level> m_levels;   //!< A list of mazes.
-    Level m_level;          //!< The  current maze.
+    Session m_session;      //!< The rules of the game, stepping the current maze.
     Player m_player;        //!< The AI engine.
+    SpeculativePlanner m_speculative; //!< Plans the next match while the snake walks.
 
     string m_system_msg;    //!< Current system message displayed to user.
 
     bool m_end_game;        //!< Flag that indicates wether the game is over. 
 
-    count_t m_score;        //!< The score in a match.
     count_t m_n_levels;     //!< The number of mazes.
     count_t m_fps;          //!< The fps game.
     count_t m_total_foods;  //!< The amount of food in a maze.
-    count_t m_curr_foods;   //!< The current amount of food found by the snake.
+    count_t m_board;        //!< The amount of food on the board at once.
     count_t m_lives;        //!< The number of lives of the snake.
-    count_t m_curr_lives;   //!< The snake's current life count.
     player_e m_player_type; //!< The player type.
+    bool m_heatmap;         //!< Whether the distance field is displayed.
+    Rng::state_t m_seed;    //!< Seed of the first level; the next ones follow it.
+    count_t m_threads;      //!< Threads of the parallel players.
+    count_t m_rollouts;     //!< Playouts per move of the MCTS player.
+    count_t m_level_index = 0;  //!< Index of the current level in the level file.
+
+    string m_record_path;       //!< File the run is recorded into, if any.
+    string m_replay_path;       //!< File of the run being replayed, if any.
+    ReplayWriter m_recorder;    //!< Writes the moves of the player.
+    ReplayReader m_replay;      //!< Reads the moves played instead of the player's.
+    bool m_replaying = false;   //!< Whether the moves come from the replay.
+    uint64_t m_moves = 0;       //!< Moves played so far.
+    uint64_t m_match_start = 0; //!< Moves played before the current match.
+    uint64_t m_next_keyframe = 0;   //!< Moves after which the next keyframe is recorded.
+    uint64_t m_seek = 0;        //!< Move from which frames are drawn.
+    bool m_headless = false;    //!< Whether only the final result is drawn.
+    uint64_t m_mazes = 0;       //!< Hash of the walls of every level, in order.
+
+    string m_checkpoint_path;   //!< File the state of the run is saved into, if any.
+    bool m_resume = false;      //!< Whether the run goes on from the checkpoint file.
+    CheckpointWriter m_checkpoints; //!< Writes the checkpoints in the background.
+    std::chrono::steady_clock::time_point m_last_checkpoint; //!< When the last checkpoint was taken.
+    bool m_checkpoint_failed = false;   //!< Whether a failed checkpoint was reported.
+
+    string m_metrics_path;      //!< File the metrics are exported into, if any.
+    CheckpointWriter m_metrics; //!< Writes the metrics in the background.
+    std::chrono::steady_clock::time_point m_last_metrics; //!< When the metrics were last exported.
+    bool m_metrics_failed = false;      //!< Whether a failed export was reported.
+    metrics::FrameClock m_frames;   //!< Times the frames.
+
+    string m_trace_path;        //!< File the game loop is traced into, if any.
 };
 
 } // NAMESPACE SNAZE
@@ -0,0 +1,109 @@
+#include "speculative.h"
+#include "common.h"
+#include "metrics.h"
+
+namespace snaze {
+
+/**
+ * @brief Starts planning the match after the current one.
+ *
+ * The level and the player are copied here, on the calling thread, so the
+ * worker never reads anything the game changes. Players choosing one move
+ * at a time have no known path to replay, and start nothing.
+ *
+ * @param session The live game, right after the current match was planned.
+ * @param player The player holding the plan of the current match.
+ * @param next The level and food of the match to plan, traced with its search.
+ */
+void SpeculativePlanner::start(const Session &session, const Player &player, const trace::Tags &next)
+{
+    cancel();
+
+    if (not player.planned())
+        return;
+
+    m_session = session;
+    m_player = player;
+    m_player.rebind(m_session.level());
+    m_tags = next;
+    m_worker = std::thread(&SpeculativePlanner::run, this);
+}
+
+/**
+ * @brief Moves the plan into a player if it was made for the level.
+ *
+ * Waits for the worker if it is still planning, which is never longer than
+ * planning here. The plan is only used if the live level is exactly the
+ * predicted one:
+ * same maze, same cells and snake (by their hash), same food and the same
+ * generator state. Otherwise the caller plans as usual.
+ *
+ * @param level The live level, with the next food placed.
+ * @param player Receives the plan, pointed at the live level.
+ * @param found Receives what the search returned for the plan.
+ * @return Whether the plan was taken.
+ */
+bool SpeculativePlanner::take(const Level &level, Player &player, bool &found)
+{
+    if (not pending())
+        return false;
+
+    m_worker.join();
+
+    const Level &predicted = m_session.level();
+    bool match = m_valid
+             and predicted.layout() == level.layout()
+             and predicted.hash() == level.hash()
+             and predicted.food() == level.food()
+             and predicted.rng().state() == level.rng().state();
+
+    if (match) {
+        player = std::move(m_player);
+        player.rebind(level);
+        found = m_found;
+    }
+    else {
+        metrics::add(metrics::REPLANS);
+    }
+
+    return match;
+}
+
+/**
+ * @brief Waits for the worker and drops its plan.
+ */
+void SpeculativePlanner::cancel()
+{
+    if (m_worker.joinable())
+        m_worker.join();
+}
+
+/**
+ * @brief Replays the path until the snake eats, and plans towards the next food.
+ *
+ * The moves go through the rules of the copied session, which place the
+ * next food as the live one will, so the copy ends in the state the live
+ * level will be in. A path that dies or ends the episode plans nothing.
+ */
+void SpeculativePlanner::run()
+{
+    m_valid = false;
+
+    for (size_t steps = m_player.amount_of_steps(); steps > 0; --steps) {
+        auto transition = m_session.step(m_player.next_move().second);
+        if (transition.outcome != GameState::outcome_e::MOVED) {
+            m_valid = transition.outcome == GameState::outcome_e::ATE and not transition.done;
+            break;
+        }
+    }
+
+    if (m_valid) {
+        const Level &level = m_session.level();
+        m_player.reset(level);
+        m_tags.length = level.snake().size();
+        trace::Span span("speculative_search", m_tags);
+        m_found = m_player.find_solution(level.spawn(), level.food());
+    }
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,59 @@
+/**
+ * @file speculative.h
+ *
+ * @description
+ * This class plans the next food in the background while the snake walks
+ * to the current one. Once a player has its whole path, the board right
+ * after eating is fully determined: a worker thread replays the path on
+ * copies of the session and the player, which place the next food with a
+ * copy of the seeded generator, exactly as the game will, and plans
+ * towards it.
+ * When the game starts the next match, it takes the plan if the live
+ * level ended up in the predicted state, instead of planning on the spot.
+ */
+
+#ifndef SPECULATIVE_H
+#define SPECULATIVE_H
+
+#include <thread>
+
+#include "level.h"
+#include "player.h"
+#include "session.h"
+#include "trace.h"
+
+namespace snaze {
+
+class SpeculativePlanner {
+public:
+    /// Default constructor.
+    SpeculativePlanner() = default;
+    /// Waits for the worker, if any.
+    ~SpeculativePlanner() { cancel(); }
+    SpeculativePlanner(const SpeculativePlanner &) = delete;
+    SpeculativePlanner &operator=(const SpeculativePlanner &) = delete;
+
+    /// Starts planning the match after the current one, if the player follows a known path; the tags are traced with the search.
+    void start(const Session &, const Player &, const trace::Tags &next = {});
+    /// Moves the plan into a player if it was made for the state of the level, returning whether it was found.
+    bool take(const Level &, Player &, bool &found);
+    /// Waits for the worker and drops its plan.
+    void cancel();
+    /// Returns whether a plan is being made or waits to be taken.
+    bool pending() const { return m_worker.joinable(); }
+
+private:
+    /// Replays the path until the snake eats and plans towards the next food.
+    void run();
+
+    std::thread m_worker;               //!< Thread making the plan; joining it publishes the plan.
+    Session m_session;                  //!< Copy of the session, moved to the predicted state.
+    Player m_player;                    //!< Copy of the player, holding the plan.
+    bool m_found = false;               //!< What the search returned for the plan.
+    bool m_valid = false;               //!< Whether the snake ate on the copy and the episode goes on.
+    trace::Tags m_tags;                 //!< Level and food of the match planned, for the trace.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
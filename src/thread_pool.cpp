@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <system_error>
+
+#include "thread_pool.h"
+
+namespace snaze {
+
+/**
+ * @brief Starts the threads of the pool.
+ *
+ * A thread the system cannot start ends the pool there: the tasks are split
+ * by `size()`, so a smaller pool still runs all of their work.
+ *
+ * @param threads The number of threads, counting the one calling `run()`.
+ */
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    try {
+        for (size_t i = 1; i < threads; ++i)
+            m_workers.emplace_back(&ThreadPool::work, this, i);
+    }
+    catch (const std::system_error &) {
+        /* keep the threads started so far */
+    }
+}
+
+/**
+ * @brief Stops and joins the threads.
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto &worker : m_workers)
+        worker.join();
+}
+
+/**
+ * @brief Runs a task on every thread and waits for all of them.
+ *
+ * @param task Called once per thread with the index of the thread.
+ */
+void ThreadPool::run(const task_t &task)
+{
+    if (m_workers.empty()) {
+        task(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_pending = m_workers.size();
+        ++m_generation;
+    }
+    m_start.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    m_task = nullptr;
+}
+
+/**
+ * @brief Loop of a pool thread.
+ *
+ * @param index The index passed to every task run by this thread.
+ */
+void ThreadPool::work(size_t index)
+{
+    size_t seen = 0;
+
+    while (true) {
+        const task_t *task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_stop or m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+            task = m_task;
+        }
+
+        (*task)(index);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0)
+            m_done.notify_one();
+    }
+}
+
+} // NAMESPACE SNAZE
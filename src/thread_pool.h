@@ -0,0 +1,61 @@
+/**
+ * @file thread_pool.h
+ *
+ * @description
+ * This class is a small fork-join pool for the parallel planners. The
+ * threads are started once and sleep between calls; each call runs the
+ * same task on every thread, the caller included, and returns when all
+ * of them finished. Work is split by the task itself from the index of
+ * the thread, so a split that only depends on the index is reproducible.
+ * If the system refuses a thread, the pool keeps the ones it started.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace snaze {
+
+class ThreadPool {
+public:
+    //== Aliases
+    using task_t = std::function<void(size_t)>;
+
+    /// Most threads a pool is asked for by the command line.
+    static constexpr size_t MAX_THREADS = 256;
+
+    /// Starts a pool of the given number of threads, the caller included; 0 uses every hardware thread.
+    explicit ThreadPool(size_t threads = 0);
+    /// Stops and joins the threads.
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /// Runs a task on every thread with its index, the caller being 0, and waits for all.
+    void run(const task_t &);
+    /// Returns the number of threads, the caller included.
+    size_t size() const { return m_workers.size() + 1; }
+
+private:
+    /// Loop of a pool thread, waiting for each task.
+    void work(size_t index);
+
+    std::vector<std::thread> m_workers;   //!< The threads besides the caller.
+    std::mutex m_mutex;                   //!< Guards every member below.
+    std::condition_variable m_start;      //!< Signals a new task or the stop.
+    std::condition_variable m_done;       //!< Signals that the last thread finished.
+    const task_t *m_task = nullptr;       //!< Task of the current call.
+    size_t m_generation = 0;              //!< Number of calls so far.
+    size_t m_pending = 0;                 //!< Threads still running the current task.
+    bool m_stop = false;                  //!< Whether the threads must exit.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,338 @@
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "trace.h"
+
+namespace snaze {
+namespace trace {
+
+namespace detail {
+
+std::atomic<bool> active { false };
+std::chrono::steady_clock::time_point epoch;
+
+} // NAMESPACE DETAIL
+
+namespace {
+
+constexpr size_t RING_EVENTS = 1 << 15;                 //!< Events a ring holds; a power of two.
+constexpr std::chrono::milliseconds DRAIN_PERIOD { 20 }; //!< Time between two drains of the rings.
+
+/// A span, as a ring holds it.
+struct Event {
+    const char *name;   //!< Name of the span.
+    uint64_t begin;     //!< Nanoseconds from the start of the trace to the start of the span.
+    uint64_t end;       //!< Nanoseconds from the start of the trace to the end of the span.
+    Tags tags;          //!< Tags of the span.
+};
+
+/// Events of one thread, pushed by it and drained by the writer.
+class Ring {
+public:
+    /// Creates an empty ring, with the id of its thread in the trace.
+    explicit Ring(uint32_t id) : m_id(id), m_events(RING_EVENTS) { /* empty */ }
+
+    /// Returns the id of the thread in the trace.
+    uint32_t id() const { return m_id; }
+    /// Returns the number of events dropped because the ring was full.
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    /// Copies an event into the ring, or drops it if the ring is full. Only the owner calls it.
+    void push(const Event &event) {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == RING_EVENTS) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_events[head & (RING_EVENTS - 1)] = event;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /// Hands every event pushed so far to a function, freeing their slots. Only the writer calls it.
+    template <typename Function>
+    void drain(Function &&function) {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+
+        for (; tail != head; ++tail)
+            function(m_events[tail & (RING_EVENTS - 1)]);
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+private:
+    uint32_t m_id;                                  //!< Id of the thread in the trace.
+    std::vector<Event> m_events;                    //!< The slots.
+    alignas(64) std::atomic<uint64_t> m_head { 0 }; //!< Events pushed.
+    alignas(64) std::atomic<uint64_t> m_tail { 0 }; //!< Events drained.
+    std::atomic<uint64_t> m_dropped { 0 };          //!< Events dropped.
+};
+
+/**
+ * @brief Writes a number of nanoseconds in microseconds, the unit of the trace.
+ *
+ * @param out The text to append to.
+ * @param ns The nanoseconds.
+ */
+void append_micros(std::string &out, uint64_t ns)
+{
+    out += std::to_string(ns / 1000);
+    out += '.';
+    const unsigned rest = ns % 1000;
+    out += char('0' + rest / 100);
+    out += char('0' + rest / 10 % 10);
+    out += char('0' + rest % 10);
+}
+
+/// The rings of every thread and the thread writing them into the file.
+class Tracer {
+public:
+    /// Stops the trace left running.
+    ~Tracer() { stop(); }
+
+    /// Creates the file and starts the writer; false if the file cannot be created or a trace runs.
+    bool start(const std::string &path);
+    /// Stops the writer, which writes the events left, and closes the file.
+    void stop();
+
+    /// Returns a ring for the calling thread, reusing one of an exited thread if any.
+    Ring *acquire();
+    /// Gives back the ring of an exiting thread.
+    void release(Ring *ring);
+
+private:
+    /// Drains the rings into the file until stopped, then one last time.
+    void run();
+    /// Drains every ring into the file.
+    void drain();
+
+    std::mutex m_mutex;                         //!< Guards the rings, the free ones and the stop flag.
+    std::vector<std::unique_ptr<Ring>> m_rings; //!< Every ring, in id order; never destroyed before the tracer.
+    std::vector<Ring *> m_free;                 //!< Rings of exited threads.
+    std::condition_variable m_wake;             //!< Wakes the writer to stop.
+    bool m_stop = false;                        //!< Whether the writer must stop.
+    std::thread m_writer;                       //!< Drains the rings into the file.
+    std::ofstream m_file;                       //!< The trace file.
+    std::string m_text;                         //!< Text of the events of a drain.
+    size_t m_named = 0;                         //!< Threads whose name was written.
+    bool m_first = true;                        //!< Whether no event was written yet.
+};
+
+Tracer tracer; //!< The tracer of the process.
+
+/// The ring of a thread, given back when the thread exits.
+struct Lease {
+    Ring *ring = nullptr; //!< The ring, once the thread traced a span.
+
+    /// Gives the ring back.
+    ~Lease() {
+        if (ring != nullptr)
+            tracer.release(ring);
+    }
+};
+
+thread_local Lease lease; //!< The ring of the calling thread.
+
+/**
+ * @brief Creates the trace file and starts the writer.
+ *
+ * @param path The trace file, overwritten.
+ * @return false if the file cannot be created or a trace runs, true otherwise.
+ */
+bool Tracer::start(const std::string &path)
+{
+    if (m_writer.joinable())
+        return false;
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (not m_file.is_open())
+        return false;
+
+    m_file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    m_first = true;
+    m_named = 0;
+    m_stop = false;
+    m_writer = std::thread(&Tracer::run, this);
+
+    return true;
+}
+
+/**
+ * @brief Stops the writer, which writes the events left, and closes the file.
+ *
+ * Reports the events dropped by full rings, if any.
+ */
+void Tracer::stop()
+{
+    if (not m_writer.joinable())
+        return;
+
+    detail::active.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_writer.join();
+
+    uint64_t dropped = 0;
+    for (const auto &ring : m_rings)
+        dropped += ring->dropped();
+
+    m_file << "\n]}\n";
+    m_file.close();
+
+    if (dropped > 0)
+        std::cerr << "snaze: the trace dropped " << dropped << " events its buffers had no room for.\n";
+    if (m_file.fail())
+        std::cerr << "snaze: unable to write the trace.\n";
+}
+
+/**
+ * @brief Returns a ring for the calling thread.
+ *
+ * @return A ring of an exited thread, or a new one.
+ */
+Ring *Tracer::acquire()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (not m_free.empty()) {
+        Ring *ring = m_free.back();
+        m_free.pop_back();
+        return ring;
+    }
+
+    m_rings.push_back(std::make_unique<Ring>(m_rings.size()));
+    return m_rings.back().get();
+}
+
+/**
+ * @brief Gives back the ring of an exiting thread; its events are still drained.
+ *
+ * @param ring The ring.
+ */
+void Tracer::release(Ring *ring)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(ring);
+}
+
+/**
+ * @brief Drains the rings into the file every `DRAIN_PERIOD`, until stopped, then one last time.
+ */
+void Tracer::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (not m_stop) {
+        m_wake.wait_for(lock, DRAIN_PERIOD, [this] { return m_stop; });
+
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Drains every ring into the file.
+ *
+ * The rings are listed under the lock, then drained without it, so a thread
+ * taking its first ring never waits for the file.
+ */
+void Tracer::drain()
+{
+    std::vector<Ring *> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto &ring : m_rings)
+            rings.push_back(ring.get());
+    }
+
+    m_text.clear();
+    auto separate = [this] {
+        m_text += m_first ? "\n" : ",\n";
+        m_first = false;
+    };
+
+    // Name the threads seen since the last drain.
+    for (; m_named < rings.size(); ++m_named) {
+        separate();
+        m_text += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(m_named)
+                + ",\"args\":{\"name\":\"" + (m_named == 0 ? std::string("main") : "worker " + std::to_string(m_named)) + "\"}}";
+    }
+
+    for (Ring *ring : rings) {
+        const std::string tid = std::to_string(ring->id());
+        ring->drain([&](const Event &event) {
+            separate();
+            m_text += "{\"name\":\"";
+            m_text += event.name;
+            m_text += "\",\"cat\":\"snaze\",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid + ",\"ts\":";
+            append_micros(m_text, event.begin);
+            m_text += ",\"dur\":";
+            append_micros(m_text, event.end - event.begin);
+            m_text += ",\"args\":{\"level\":" + std::to_string(event.tags.level)
+                    + ",\"food\":" + std::to_string(event.tags.food)
+                    + ",\"length\":" + std::to_string(event.tags.length) + "}}";
+        });
+    }
+
+    m_file.write(m_text.data(), m_text.size());
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Starts tracing into a file.
+ *
+ * The calling thread takes the first ring, so it is named the main thread.
+ *
+ * @param path The trace file, overwritten.
+ * @return false if the file cannot be created or a trace runs, true otherwise.
+ */
+bool start(const std::string &path)
+{
+    if (not tracer.start(path))
+        return false;
+
+    if (lease.ring == nullptr)
+        lease.ring = tracer.acquire();
+
+    detail::epoch = std::chrono::steady_clock::now();
+    detail::active.store(true, std::memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief Writes the events left and closes the trace file, if a trace runs.
+ *
+ * Spans still open on other threads are not written.
+ */
+void stop()
+{
+    tracer.stop();
+}
+
+/**
+ * @brief Copies a span into the ring of the calling thread.
+ *
+ * @param name The name of the span.
+ * @param begin The nanoseconds from the start of the trace to the start of the span.
+ * @param end The nanoseconds from the start of the trace to the end of the span.
+ * @param tags The tags of the span.
+ */
+void detail::record(const char *name, uint64_t begin, uint64_t end, const Tags &tags)
+{
+    if (lease.ring == nullptr)
+        lease.ring = tracer.acquire();
+
+    lease.ring->push({ name, begin, end, tags });
+}
+
+} // NAMESPACE TRACE
+} // NAMESPACE SNAZE
@@ -0,0 +1,92 @@
+/**
+ * @file trace.h
+ *
+ * @description
+ * Spans of the game loop written as Chrome trace events, a JSON file that
+ * chrome://tracing and Perfetto open. Each span is a complete event ("X")
+ * tagged with the level index, the food being looked for and the length
+ * of the snake.
+ *
+ * Tracing must not change the timing it measures, so a thread ending a
+ * span only reads the clock and copies the event into a ring buffer of
+ * its own, without locks or allocations; one producer and one consumer per
+ * ring need no more than two atomic indices. A writer thread drains every
+ * ring a few dozen times per second and formats the events into the file.
+ * A ring that is full drops its new events, which are counted and
+ * reported when the trace stops.
+ *
+ * Rings are taken by a thread when it ends its first span and returned
+ * when it exits, so the threads the game starts per match reuse a few
+ * rings; each ring is one thread of the trace. Without a trace running,
+ * a span costs one atomic load.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace snaze {
+namespace trace {
+
+/// What a span is tagged with.
+struct Tags {
+    uint32_t level = 0;     //!< Index of the level.
+    uint32_t food = 0;      //!< Index of the food being looked for on the level.
+    uint32_t length = 0;    //!< Length of the snake.
+};
+
+/// Starts tracing into a file; false if it cannot be created. The calling thread is the main one.
+bool start(const std::string &path);
+/// Writes the events left and closes the file, if a trace runs.
+void stop();
+
+namespace detail {
+
+extern std::atomic<bool> active;                        //!< Whether a trace runs.
+extern std::chrono::steady_clock::time_point epoch;     //!< When the trace started.
+
+/// Returns the nanoseconds since the trace started.
+inline uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/// Copies a span into the ring of the calling thread.
+void record(const char *name, uint64_t begin, uint64_t end, const Tags &tags);
+
+} // NAMESPACE DETAIL
+
+/// Returns whether a trace runs.
+inline bool enabled() { return detail::active.load(std::memory_order_acquire); }
+
+/// Traces the span of its lifetime; the name must outlive the trace, as a string literal does.
+class Span {
+public:
+    /// Starts the span, if a trace runs.
+    Span(const char *name, const Tags &tags) : m_name(name), m_tags(tags), m_traced(enabled()) {
+        if (m_traced)
+            m_begin = detail::now();
+    }
+    /// Ends the span.
+    ~Span() {
+        if (m_traced)
+            detail::record(m_name, m_begin, detail::now(), m_tags);
+    }
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+private:
+    const char *m_name;     //!< Name of the span.
+    Tags m_tags;            //!< Its tags.
+    bool m_traced;          //!< Whether a trace ran when it started.
+    uint64_t m_begin = 0;   //!< When it started.
+};
+
+} // NAMESPACE TRACE
+} // NAMESPACE SNAZE
+
+#endif
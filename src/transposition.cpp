@@ -0,0 +1,103 @@
+#include <cstring>
+
+#include "transposition.h"
+
+namespace snaze {
+
+namespace {
+
+/// Packs an entry in a single word.
+uint64_t pack(const TranspositionTable::Entry &entry)
+{
+    static_assert(sizeof(TranspositionTable::Entry) == sizeof(uint64_t), "entries must fit a word");
+    uint64_t word;
+    std::memcpy(&word, &entry, sizeof(word));
+    return word;
+}
+
+/// Unpacks an entry from a single word.
+TranspositionTable::Entry unpack(uint64_t word)
+{
+    TranspositionTable::Entry entry {};
+    std::memcpy(&entry, &word, sizeof(word));
+    return entry;
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Creates an empty table.
+ *
+ * @param capacity The minimum number of slots; it is rounded up to a power
+ * of two so a slot is found by masking the key.
+ */
+TranspositionTable::TranspositionTable(size_t capacity)
+{
+    size_t slots = 1;
+    while (slots < capacity)
+        slots <<= 1;
+
+    m_slots = std::make_unique<Slot[]>(slots);
+    m_mask = slots - 1;
+}
+
+/**
+ * @brief Looks up a state.
+ *
+ * A slot never written holds zero in both words, which would match the
+ * key 0, so a slot whose data is zero always reads as a miss.
+ *
+ * @param key The hash of the state.
+ * @param entry Receives the stored entry if the state is found.
+ * @return Whether the slot held the state.
+ */
+bool TranspositionTable::probe(zobrist::hash_t key, Entry &entry) const
+{
+    const Slot &slot = m_slots[key & m_mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+    if (data == 0 or (check ^ data) != key)
+        return false;
+
+    entry = unpack(data);
+    return true;
+}
+
+/**
+ * @brief Stores a state.
+ *
+ * A slot holding the same state is always overwritten; one holding another
+ * state is only replaced if it was not searched deeper, so cheap results do
+ * not evict expensive ones. An entry of all zeros reads as empty, so it
+ * is never found again.
+ *
+ * @param key The hash of the state.
+ * @param entry What the search found about it.
+ */
+void TranspositionTable::store(zobrist::hash_t key, const Entry &entry)
+{
+    Slot &slot = m_slots[key & m_mask];
+    uint64_t old_data = slot.data.load(std::memory_order_relaxed);
+    uint64_t old_key = slot.check.load(std::memory_order_relaxed) ^ old_data;
+
+    if (old_key != key and old_data != 0 and unpack(old_data).depth > entry.depth)
+        return;
+
+    uint64_t data = pack(entry);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Empties the table.
+ */
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i <= m_mask; ++i) {
+        m_slots[i].check.store(0, std::memory_order_relaxed);
+        m_slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+} // NAMESPACE SNAZE
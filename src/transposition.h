@@ -0,0 +1,62 @@
+/**
+ * @file transposition.h
+ *
+ * @description
+ * This class is a fixed-size table of search results keyed by Zobrist
+ * hashes, meant to be shared by every search thread without locks. Each
+ * slot holds the data and the data XOR the key in two atomic words; a
+ * reader only trusts a slot whose words agree with the key it probes, so
+ * a write torn by another thread reads as a miss instead of bad data.
+ * A slot whose data is zero is empty, so an entry must not pack to zero.
+ */
+
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "zobrist.h"
+
+namespace snaze {
+
+class TranspositionTable {
+public:
+    /// What a search stores about a state, packed in 64 bits.
+    struct Entry {
+        float value;     //!< Value of the state for the searcher.
+        uint16_t depth;  //!< How deep, or how many times, the state was searched.
+        uint8_t move;    //!< Best direction found from the state.
+        uint8_t flags;   //!< Free for the searcher, e.g. the kind of bound.
+    };
+
+    /// Creates a table with at least the given number of slots, rounded up to a power of two.
+    explicit TranspositionTable(size_t capacity);
+    /// Destructor.
+    ~TranspositionTable() = default;
+
+    /// Looks up a state, returning whether it was found.
+    bool probe(zobrist::hash_t, Entry &) const;
+    /// Stores a state, unless its slot holds a different state searched deeper.
+    void store(zobrist::hash_t, const Entry &);
+    /// Empties the table; not safe while other threads use it.
+    void clear();
+    /// Returns the number of slots.
+    size_t size() const { return m_mask + 1; }
+
+private:
+    /// A slot of the table, written and read without locks.
+    struct alignas(16) Slot {
+        std::atomic<uint64_t> check { 0 }; //!< Key XOR data.
+        std::atomic<uint64_t> data { 0 };  //!< Packed entry.
+    };
+
+    std::unique_ptr<Slot[]> m_slots; //!< The slots, indexed by the low bits of the key.
+    size_t m_mask = 0;               //!< Number of slots minus one.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "vector_env.h"
+#include "cell.h"
+#include "common.h"
+#include "draw_cell.h"
+#include "observer.h"
+
+namespace snaze {
+
+namespace {
+
+constexpr uint32_t ROW_STEP[4] = { uint32_t(-1), 0, 1, 0 };  //!< Row change of each direction, wrapping below zero.
+constexpr uint32_t COL_STEP[4] = { 0, uint32_t(-1), 0, 1 };  //!< Col change of each direction, wrapping below zero.
+
+/**
+ * @brief Returns the number of stamps the games need, one per cell of each.
+ *
+ * @param games The number of games.
+ * @param cells The number of cells in the maze.
+ * @return The number of stamps.
+ * @throws std::invalid_argument if there are more than `VectorEnv::MAX_STAMPS` of them.
+ */
+size_t stamps(size_t games, size_t cells)
+{
+    if (cells > 0 and games > VectorEnv::MAX_STAMPS / cells)
+        throw std::invalid_argument("The games of an environment hold at most 2^28 cells together.");
+
+    return games * cells;
+}
+
+} // ANONYMOUS NAMESPACE
+
+/**
+ * @brief Starts a number of games on a maze.
+ *
+ * Every game starts at the spawn point of the maze with its own generator,
+ * drawn from the seed, so games differ from each other but a seed always
+ * replays the same runs.
+ *
+ * @param layout The walls of the maze, shared by every game.
+ * @param games The number of games.
+ * @param seed The seed of the food positions.
+ * @param lives The lives at the start of each episode.
+ * @param foods The foods that win an episode.
+ * @throws std::invalid_argument if the games have more than `MAX_STAMPS` cells together.
+ */
+VectorEnv::VectorEnv(std::shared_ptr<const Layout> layout, size_t games, Rng::state_t seed, count_t lives, count_t foods)
+    : m_games(games), m_layout(std::move(layout)), m_rows(m_layout->rows()), m_cols(m_layout->cols()),
+      m_cells(m_rows * m_cols), m_wall(m_cells), m_max_lives(lives), m_max_foods(foods),
+      m_row(games), m_col(games), m_dir(games), m_food(games), m_length(games), m_clock(games),
+      m_score(games), m_lives(games), m_eaten(games), m_rng(games), m_enter(stamps(games, m_cells), 0),
+      m_next(games), m_event(games), m_reward(games), m_done(games)
+{
+    for (size_t cell = 0; cell < m_cells; ++cell) {
+        Cell::cell_e type = m_layout->cells()[cell].type();
+        m_wall[cell] = type == Cell::cell_e::WALL or type == Cell::cell_e::INV_WALL;
+    }
+
+    Rng rng(seed);
+    for (size_t game = 0; game < m_games; ++game) {
+        m_rng[game] = rng.next();
+        reset(game);
+    }
+}
+
+/**
+ * @brief Steps the games on several threads.
+ *
+ * Each thread steps a contiguous slice of the games.
+ *
+ * @param threads The number of threads, the caller included; 0 uses every hardware thread.
+ */
+void VectorEnv::parallelize(size_t threads)
+{
+    m_pool = std::make_shared<ThreadPool>(threads);
+}
+
+/**
+ * @brief Moves the snake of every game in its direction.
+ *
+ * @param actions The direction of each game, as many as there are games.
+ */
+void VectorEnv::step(const dir_e *actions)
+{
+    if (m_pool == nullptr or m_pool->size() == 1) {
+        step(actions, 0, m_games);
+    }
+    else {
+        // Passed by reference so the pool does not allocate a copy on every step.
+        const size_t threads = m_pool->size();
+        auto slice = [&](size_t thread) {
+            step(actions, m_games * thread / threads, m_games * (thread + 1) / threads);
+        };
+        m_pool->run(std::ref(slice));
+    }
+
+    m_steps += m_games;
+}
+
+/**
+ * @brief Starts an episode over in a game.
+ *
+ * @param game The game to start over.
+ */
+void VectorEnv::reset(size_t game)
+{
+    m_score[game] = 0;
+    m_lives[game] = m_max_lives;
+    m_eaten[game] = 0;
+    respawn(game);
+    draw_food(game);
+}
+
+/**
+ * @brief Writes the board of every game into a buffer.
+ *
+ * The games are split over the threads like `step()` splits them, each
+ * thread writing its own slice of the buffer.
+ *
+ * @param observer How to write each board.
+ * @param out The boards, game after game, `size() * observer.size()` bytes.
+ */
+void VectorEnv::observe(const Observer &observer, uint8_t *out) const
+{
+    auto fill = [&](size_t begin, size_t end) {
+        for (size_t game = begin; game < end; ++game)
+            observer.fill(*this, game, out + game * observer.size());
+    };
+
+    if (m_pool == nullptr or m_pool->size() == 1) {
+        fill(0, m_games);
+    }
+    else {
+        const size_t threads = m_pool->size();
+        auto slice = [&](size_t thread) {
+            fill(m_games * thread / threads, m_games * (thread + 1) / threads);
+        };
+        m_pool->run(std::ref(slice));
+    }
+}
+
+/**
+ * @brief Runs the three passes of a step over a range of games.
+ *
+ * The first pass only reads the arrays and writes the next head and the
+ * event of each game, so it has no branches the compiler must keep. The
+ * second one moves every snake that survived. The third one only does
+ * work for the games where something happened.
+ *
+ * @param actions The direction of each game.
+ * @param begin The first game of the range.
+ * @param end The game after the last one of the range.
+ */
+void VectorEnv::step(const dir_e *actions, size_t begin, size_t end)
+{
+    const uint32_t rows = m_rows, cols = m_cols;
+
+    for (size_t game = begin; game < end; ++game) {
+        uint32_t dir = actions[game] & 3;
+        uint32_t row = m_row[game] + ROW_STEP[dir];
+        uint32_t col = m_col[game] + COL_STEP[dir];
+        bool outside = (row >= rows) | (col >= cols);
+        cell_t next = outside ? 0 : row * cols + col;
+
+        bool hit = outside | m_wall[next] | (m_clock[game] - m_enter[game * m_cells + next] < m_length[game]);
+        m_next[game] = next;
+        m_event[game] = hit ? DIED : (next == m_food[game] ? ATE : NONE);
+    }
+
+    for (size_t game = begin; game < end; ++game) {
+        m_reward[game] = 0;
+        m_done[game] = 0;
+        if (m_event[game] & DIED)
+            continue;
+
+        cell_t next = m_next[game];
+        m_row[game] = next / cols;
+        m_col[game] = next % cols;
+        m_dir[game] = actions[game] & 3;
+        m_enter[game * m_cells + next] = ++m_clock[game];
+    }
+
+    for (size_t game = begin; game < end; ++game) {
+        if (m_event[game] == NONE)
+            continue;
+
+        if (m_event[game] & ATE) {
+            ++m_length[game];
+            ++m_eaten[game];
+            m_score[game] += 20;
+            m_reward[game] = 1;
+            draw_food(game);
+
+            // Eating the last food, or having no cell left for one, wins the episode.
+            if (m_eaten[game] == m_max_foods or m_food[game] == NO_CELL) {
+                m_done[game] = 1;
+                reset(game);
+            }
+        }
+        else {
+            m_score[game] = m_score[game] < 20 ? 0 : m_score[game] - 20;
+            m_reward[game] = -1;
+
+            if (--m_lives[game] == 0) {
+                m_done[game] = 1;
+                reset(game);
+            }
+            else {
+                respawn(game);
+                draw_food(game);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Puts the snake of a game back at the spawn point with one cell.
+ *
+ * Moving the clock one move forward ages every stamp of the old body out,
+ * since a snake of one cell only takes the cell entered on the last move;
+ * stamps never come back, because the clock always moves at least as fast
+ * as the snake grows.
+ *
+ * @param game The game whose snake starts over.
+ */
+void VectorEnv::respawn(size_t game)
+{
+    Position spawn = m_layout->spawn();
+    m_row[game] = spawn.row;
+    m_col[game] = spawn.col;
+    m_dir[game] = UP;
+    m_length[game] = 1;
+    m_enter[game * m_cells + to_cell(spawn, m_cols)] = ++m_clock[game];
+}
+
+/**
+ * @brief Draws a new food for a game with `draw_cell()`, on a cell that is
+ * not a wall nor taken by the snake.
+ *
+ * @param game The game that needs a food; its food is NO_CELL if the maze is full.
+ */
+void VectorEnv::draw_food(size_t game)
+{
+    Rng rng(m_rng[game]);
+    m_food[game] = draw_cell(rng, m_rows, m_cols, [this, game](cell_t cell) {
+        return not m_wall[cell] and not taken(game, cell);
+    });
+    m_rng[game] = rng.state();
+}
+
+} // NAMESPACE SNAZE
@@ -0,0 +1,151 @@
+/**
+ * @file vector_env.h
+ *
+ * @description
+ * This class steps many independent games on the same maze in lockstep,
+ * for training and evaluating agents. Every field of a game is stored in
+ * its own array (struct-of-arrays), so a step is a few tight loops over
+ * plain integers instead of one call per game.
+ *
+ * A game does not keep its body. Instead, each game stamps every cell
+ * with the move at which its head entered it, and a cell is taken while
+ * fewer moves than the length of the snake went by since. Moving never
+ * frees a tail, growing is a single increment, and checking a collision
+ * is a single load; dying or starting over only ages every stamp out by
+ * moving the clock forward. The stamps take four bytes per cell of every
+ * game, so at most `MAX_STAMPS` of them are allowed, 1 GiB; more games or
+ * a larger maze are rejected when the environment is built.
+ *
+ * A step has three passes. The first one computes the next head and
+ * whether it hits something, without branches; the second one moves the
+ * snakes that survived; the third one handles the rare events (eating,
+ * dying, finishing an episode), each game with its own generator. A game
+ * that runs out of lives or eats every food starts over at once. Games
+ * never share anything but the walls, so splitting them over threads
+ * does not change any result.
+ *
+ * The rules follow `GameState`, except that eating grows the snake on the
+ * same move: the snake dies moving into a wall, its own body or its tail,
+ * and each food eaten is worth 20 points and a reward of 1, each death a
+ * reward of -1.
+ */
+
+#ifndef VECTOR_ENV_H
+#define VECTOR_ENV_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common.h"
+#include "layout.h"
+#include "rng.h"
+#include "thread_pool.h"
+
+namespace snaze {
+
+class Observer;
+
+class VectorEnv {
+public:
+    //== Aliases
+    using count_t = uint32_t;
+
+    /// Cells of every game together that may be stamped, four bytes each.
+    static constexpr size_t MAX_STAMPS = size_t(1) << 28;
+
+    /// Default constructor.
+    VectorEnv() = default;
+    /// Starts a number of games on a maze, each seeded from the seed.
+    VectorEnv(std::shared_ptr<const Layout>, size_t games, Rng::state_t seed, count_t lives = 5, count_t foods = 10);
+    /// Destructor.
+    ~VectorEnv() = default;
+
+    /// Steps the games on the given number of threads; 0 uses every hardware thread.
+    void parallelize(size_t threads);
+    /// Moves the snake of every game in its direction, one per game.
+    void step(const dir_e *actions);
+    /// Starts an episode over in a game.
+    void reset(size_t game);
+    /// Writes the board of every game, one after the other, into a buffer of `size() * observer.size()` bytes.
+    void observe(const Observer &, uint8_t *out) const;
+
+    /// Returns the number of games.
+    size_t size() const { return m_games; }
+    /// Returns the number of rows in the maze.
+    size_t rows() const { return m_rows; }
+    /// Returns the number of cols in the maze.
+    size_t cols() const { return m_cols; }
+    /// Returns the cell of the head of a game.
+    cell_t head(size_t game) const { return m_row[game] * m_cols + m_col[game]; }
+    /// Returns the direction of the last move of a game.
+    dir_e direction(size_t game) const { return static_cast<dir_e>(m_dir[game]); }
+    /// Returns the cell of the food of a game, or NO_CELL if the maze is full.
+    cell_t food(size_t game) const { return m_food[game]; }
+    /// Returns the length of the snake of a game.
+    count_t length(size_t game) const { return m_length[game]; }
+    /// Returns the score of the current episode of a game.
+    count_t score(size_t game) const { return m_score[game]; }
+    /// Returns the lives left in the current episode of a game.
+    count_t lives(size_t game) const { return m_lives[game]; }
+    /// Returns whether a cell is taken by the snake of a game.
+    bool taken(size_t game, cell_t cell) const {
+        return m_clock[game] - m_enter[game * m_cells + cell] < m_length[game];
+    }
+    /// Returns the rewards of the last step, one per game.
+    const float *rewards() const { return m_reward.data(); }
+    /// Returns whether each game finished an episode on the last step, and started over.
+    const uint8_t *dones() const { return m_done.data(); }
+    /// Returns the number of game steps run so far.
+    uint64_t steps() const { return m_steps; }
+
+private:
+    //== Enums
+
+    /// What happened to a game on a step, one bit each.
+    enum event_e : uint8_t {
+        NONE = 0,
+        ATE = 1,    //!< The snake moved into its food.
+        DIED = 2,   //!< The snake hit a wall or itself.
+    };
+
+    /// Runs the three passes of a step over a range of games.
+    void step(const dir_e *actions, size_t begin, size_t end);
+    /// Puts the snake of a game back at the spawn point with one cell.
+    void respawn(size_t game);
+    /// Draws a new food for a game on a cell its snake does not take.
+    void draw_food(size_t game);
+
+    size_t m_games = 0;                     //!< The number of games.
+    std::shared_ptr<const Layout> m_layout; //!< Walls shared by every game.
+    size_t m_rows = 0;                      //!< The number of rows in the maze.
+    size_t m_cols = 0;                      //!< The number of cols in the maze.
+    size_t m_cells = 0;                     //!< The number of cells in the maze.
+    std::vector<uint8_t> m_wall;            //!< Whether each cell is a wall.
+    count_t m_max_lives = 5;                //!< Lives at the start of an episode.
+    count_t m_max_foods = 10;               //!< Foods that win an episode.
+
+    std::vector<count_t> m_row;             //!< Row of the head of each game.
+    std::vector<count_t> m_col;             //!< Col of the head of each game.
+    std::vector<uint8_t> m_dir;             //!< Direction of the last move of each game.
+    std::vector<cell_t> m_food;             //!< Cell of the food of each game.
+    std::vector<count_t> m_length;          //!< Length of the snake of each game.
+    std::vector<count_t> m_clock;           //!< Move at which the head of each game entered its cell.
+    std::vector<count_t> m_score;           //!< Score of the episode of each game.
+    std::vector<count_t> m_lives;           //!< Lives left in the episode of each game.
+    std::vector<count_t> m_eaten;           //!< Foods eaten in the episode of each game.
+    std::vector<Rng::state_t> m_rng;        //!< Generator state of each game.
+    std::vector<count_t> m_enter;           //!< Move at which each game last entered each cell, game by game; games * cells stamps.
+
+    std::vector<cell_t> m_next;             //!< Cell each head moves into on the current step.
+    std::vector<uint8_t> m_event;           //!< What happened to each game on the current step.
+    std::vector<float> m_reward;            //!< Reward of each game on the last step.
+    std::vector<uint8_t> m_done;            //!< Whether each game finished an episode on the last step.
+    uint64_t m_steps = 0;                   //!< Game steps run so far.
+
+    std::shared_ptr<ThreadPool> m_pool;     //!< Pool stepping the games, if parallel.
+};
+
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file zobrist.h
+ *
+ * @description
+ * Zobrist keys for hashing board states. A state hash is the XOR of one
+ * key per feature (the type of each cell that is not free, and the link
+ * from each snake segment to the next one), so changing a feature updates
+ * the hash in O(1). Keys are derived from the cell index with a mixing
+ * function instead of being stored, which keeps huge mazes cheap.
+ */
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+#include "cell.h"
+#include "common.h"
+
+namespace snaze {
+namespace zobrist {
+
+//== Aliases
+using hash_t = uint64_t;
+
+/// Link of the snake head, which has no next segment.
+constexpr unsigned HEAD = 4;
+/// Link between two segments that are not neighbors (right after eating).
+constexpr unsigned DETACHED = 5;
+/// Feature of a pending growth.
+constexpr hash_t GROW = 0x6a09e667f3bcc908ULL;
+
+/// Returns the key of a feature of a cell.
+constexpr hash_t key(cell_t cell, unsigned feature)
+{
+    hash_t z = ((hash_t(cell) << 5) | feature) + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/// Returns the key of a cell holding a type; free cells do not count.
+constexpr hash_t cell_key(cell_t cell, Cell::cell_e type)
+{
+    return type == Cell::cell_e::FREE ? 0 : key(cell, static_cast<unsigned>(type));
+}
+
+/// Returns the link from a snake segment to the next one, in a maze with the given cols.
+constexpr unsigned link(cell_t from, cell_t to, size_t cols)
+{
+    return to + cols == from ? UP
+         : to == from + cols ? DOWN
+         : to + 1 == from ? LEFT
+         : to == from + 1 ? RIGHT
+         : DETACHED;
+}
+
+/// Returns the key of a snake segment and its link to the next one.
+constexpr hash_t segment_key(cell_t cell, unsigned link)
+{
+    return key(cell, 16 + link);
+}
+
+} // NAMESPACE ZOBRIST
+} // NAMESPACE SNAZE
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @file snaze_gen.cpp
+ *
+ * @description
+ * This program writes generated mazes to a level file, for runs and
+ * benchmarks on boards larger than the bundled levels. Each maze of a
+ * file takes the seed after the one of the previous maze.
+ *
+ * Usage: snaze-gen [options]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "maze_file.h"
+#include "maze_gen.h"
+
+/**
+ * @brief Displays the usage of the program.
+ */
+void usage()
+{
+    std::cout << "Usage: snaze-gen [options]\n";
+    std::cout << "   Options:\n";
+    std::cout << "     --help                Print this help text.\n";
+    std::cout << "     --style <name>        Style of the mazes: perfect, rooms, arena, corridors. Default = perfect.\n";
+    std::cout << "     --rows <num>          Number of rows, walls included. Default = 31.\n";
+    std::cout << "     --cols <num>          Number of cols, walls included. Default = 31.\n";
+    std::cout << "     --density <num>       Share of obstacles of an arena, from 0 to 1. Default = 0.2.\n";
+    std::cout << "     --seed <num>          Seed of the first maze. Default = 1.\n";
+    std::cout << "     --count <num>         Number of mazes in the file. Default = 1.\n";
+    std::cout << "     --output <file>       Level file to write. Default = the standard output.\n";
+}
+
+/**
+ * @brief Parses a non-negative number.
+ *
+ * @param flag The flag the number belongs to, for the error message.
+ * @param text The text to parse.
+ * @param value Receives the number.
+ * @return true if the text is a number, false otherwise.
+ */
+bool parse_number(const char *flag, const char *text, unsigned long long &value)
+{
+    char *end = nullptr;
+    value = std::strtoull(text, &end, 10);
+    if (*text == '\0' or *text == '-' or *end != '\0') {
+        std::cerr << "snaze-gen: invalid value for " << flag << ": " << text << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    snaze::maze_style_e style = snaze::maze_style_e::PERFECT;
+    unsigned long long rows = 31, cols = 31, seed = 1, count = 1;
+    double density = 0.2;
+    std::string output;
+
+    for (int arg = 1; arg < argc; ++arg) {
+        if (!strcmp(argv[arg], "--help")) {
+            usage();
+            return EXIT_SUCCESS;
+        }
+        if (arg + 1 == argc) {
+            std::cerr << "snaze-gen: missing value or unknown option: " << argv[arg] << "\n";
+            return EXIT_FAILURE;
+        }
+
+        const char *flag = argv[arg], *value = argv[++arg];
+        if (!strcmp(flag, "--style")) {
+            auto found = snaze::maze_style(value);
+            if (not found.has_value()) {
+                std::cerr << "snaze-gen: unknown style: " << value << "\n";
+                return EXIT_FAILURE;
+            }
+            style = found.value();
+        }
+        else if (!strcmp(flag, "--density")) {
+            char *end = nullptr;
+            density = std::strtod(value, &end);
+            if (*end != '\0' or density < 0 or density > 1) {
+                std::cerr << "snaze-gen: the density must be between 0 and 1: " << value << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (!strcmp(flag, "--output")) {
+            output = value;
+        }
+        else if (!strcmp(flag, "--rows")) {
+            if (not parse_number(flag, value, rows))
+                return EXIT_FAILURE;
+        }
+        else if (!strcmp(flag, "--cols")) {
+            if (not parse_number(flag, value, cols))
+                return EXIT_FAILURE;
+        }
+        else if (!strcmp(flag, "--seed")) {
+            if (not parse_number(flag, value, seed))
+                return EXIT_FAILURE;
+        }
+        else if (!strcmp(flag, "--count")) {
+            if (not parse_number(flag, value, count))
+                return EXIT_FAILURE;
+        }
+        else {
+            std::cerr << "snaze-gen: unknown option: " << flag << "\n";
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ofstream file;
+    if (not output.empty()) {
+        file.open(output, std::ios::binary | std::ios::trunc);
+        if (not file.is_open()) {
+            std::cerr << "snaze-gen: unable to create " << output << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream &out = output.empty() ? std::cout : file;
+
+    for (unsigned long long i = 0; i < count; ++i) {
+        try {
+            auto t0 = std::chrono::steady_clock::now();
+            snaze::maze_t maze = snaze::generate_maze(style, rows, cols, seed + i, density);
+            auto t1 = std::chrono::steady_clock::now();
+            snaze::write_maze(out, maze);
+
+            if (not output.empty())
+                std::cerr << "snaze-gen: " << rows << "x" << cols << " maze generated in "
+                          << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms\n";
+        }
+        catch (const std::exception &e) {
+            std::cerr << "snaze-gen: " << e.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    out.flush();
+    return out.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+}